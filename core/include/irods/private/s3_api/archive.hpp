@@ -0,0 +1,68 @@
+#ifndef IRODS_S3_API_ARCHIVE_HPP
+#define IRODS_S3_API_ARCHIVE_HPP
+
+#include "irods/private/s3_api/object_stat.hpp"
+
+#include <irods/filesystem/path.hpp>
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace irods::s3
+{
+	/// Returns true if the object has a good replica on one of irods_client.archive.archive_resources.
+	auto is_archived(const object_stat& _stat) -> bool;
+
+	/// Returns true if every good replica of the object is on one of
+	/// irods_client.archive.archive_resources, so reading it would have to wait for the archive.
+	auto needs_restore(const object_stat& _stat) -> bool;
+
+	/// Stages archived objects to irods_client.archive.stage_resource on threads of its own.
+	///
+	/// Staging may take hours, so it never runs on the threads which serve requests. Which objects
+	/// are being staged is only known to this server. Once staging completes, the catalog shows a
+	/// good replica outside the archive, which is how restored objects are recognized.
+	class restore_queue
+	{
+	  public:
+		/// \param _thread_count The number of objects staged at once.
+		explicit restore_queue(std::size_t _thread_count);
+
+		~restore_queue();
+
+		restore_queue(const restore_queue&) = delete;
+		auto operator=(const restore_queue&) -> restore_queue& = delete;
+
+		/// Queues \p _path to be staged as \p _client_username.
+		///
+		/// \returns false if the object is already queued or being staged.
+		auto restore(const std::string& _client_username, const irods::experimental::filesystem::path& _path)
+			-> bool;
+
+		/// Returns true if \p _path is queued or being staged.
+		auto is_ongoing(const std::string& _path) const -> bool;
+
+		/// Writes the number of restores queued, completed and failed to the log.
+		auto log_report() const -> void;
+
+	  private:
+		auto stage(const std::string& _client_username, const irods::experimental::filesystem::path& _path)
+			-> void;
+
+		mutable std::mutex mutex_;
+		std::unordered_set<std::string> ongoing_;
+
+		std::atomic<std::uint64_t> queued_{0};
+		std::atomic<std::uint64_t> completed_{0};
+		std::atomic<std::uint64_t> failed_{0};
+
+		boost::asio::thread_pool workers_;
+	}; // class restore_queue
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_ARCHIVE_HPP
@@ -21,6 +21,8 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <type_traits>
 #include <unordered_map>
 #include <variant>
 #include <vector>
@@ -128,6 +130,25 @@ namespace irods::http
 			THROW(SYS_INTERNAL_ERR, "Cannot return reference to connection object. connection_facade is empty.");
 		} // get_ref
 
+		// Drops the underlying connection so that it is never used again. A connection borrowed
+		// from the connection pool is released from the pool, which replaces it with a new one.
+		auto discard() noexcept -> void
+		{
+			if (auto* p = std::get_if<irods::connection_pool::connection_proxy>(&conn_); p) {
+				try {
+					if (auto* comm = p->release(); comm) {
+						rcDisconnect(comm);
+					}
+				}
+				catch (...) {
+					// The pool could not replace the connection. The slot is refreshed the next
+					// time it is retrieved.
+				}
+			}
+
+			conn_ = std::monostate{};
+		} // discard
+
 	  private:
 		std::variant<std::monostate, irods::experimental::client_connection, irods::connection_pool::connection_proxy>
 			conn_;
@@ -191,6 +212,48 @@ namespace irods
 
 	auto get_connection(const std::string& _username) -> irods::http::connection_facade;
 
+	// Returns true if _ec indicates that the connection to the iRODS server is no longer usable
+	// (e.g. the server restarted or the socket was closed).
+	auto is_connection_error(int _ec) noexcept -> bool;
+
+	// Discards a broken connection so that the pool replaces it. The caller retries at once on a
+	// new connection, without sleeping on the thread it runs on.
+	auto discard_connection_before_retry(irods::http::connection_facade& _conn, int _ec) -> void;
+
+	// Runs an idempotent catalog operation (existence checks, stat calls, GenQuery) on a
+	// connection for _username. If the operation fails because the connection is broken, it is
+	// retried once on a new connection.
+	//
+	// Data writes and other non-idempotent operations must never be passed to this function.
+	template <typename Op>
+	auto with_catalog_retry(const std::string& _username, Op&& _op)
+		-> std::invoke_result_t<Op&, irods::http::connection_facade&>
+	{
+		auto conn = get_connection(_username);
+		int ec = 0;
+
+		try {
+			return _op(conn);
+		}
+		catch (const irods::exception& e) {
+			if (!is_connection_error(static_cast<int>(e.code()))) {
+				throw;
+			}
+			ec = static_cast<int>(e.code());
+		}
+		catch (const std::system_error& e) {
+			if (!is_connection_error(e.code().value())) {
+				throw;
+			}
+			ec = e.code().value();
+		}
+
+		discard_connection_before_retry(conn, ec);
+		conn = get_connection(_username);
+
+		return _op(conn);
+	} // with_catalog_retry
+
 	auto fail(boost::beast::error_code ec, char const* what) -> void;
 
 	auto enable_ticket(RcComm& _comm, const std::string& _ticket) -> int;
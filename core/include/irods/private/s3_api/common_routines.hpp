@@ -1,6 +1,8 @@
 #ifndef IRODS_S3_API_COMMON_ROUTINES_HPP
 #define IRODS_S3_API_COMMON_ROUTINES_HPP
 
+#include <functional>
+#include <memory>
 #include <string>
 
 #include <fmt/format.h>
@@ -17,6 +19,7 @@
 #include <boost/property_tree/xml_parser.hpp>
 
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/session.hpp"
 #include "irods/private/s3_api/common.hpp"
 
@@ -25,7 +28,8 @@ namespace irods::s3::api::common_routines
 
 	inline std::string convert_time_t_to_str(const time_t& t, const std::string_view format)
 	{
-		return fmt::format(fmt::runtime(format), fmt::localtime(t));
+		// Every date format of the S3 API is in UTC.
+		return fmt::format(fmt::runtime(format), fmt::gmtime(t));
 	}
 
 	inline void send_error_response(
@@ -67,6 +71,51 @@ namespace irods::s3::api::common_routines
 		session_ptr->send(std::move(response));
 		return;
 	}
+
+	using string_body_parser = boost::beast::http::request_parser<boost::beast::http::string_body>;
+
+	// Reads the body of a request into a string without holding a worker thread while the client
+	// sends it. The socket is read on the I/O threads. Once the body is complete, _continuation is
+	// run with the parser through _schedule (e.g. irods::http::globals::metadata_task). If the body
+	// could not be read, an error response has already been sent and _continuation is not run.
+	inline void read_string_body_async(
+		irods::http::session_pointer_type session_ptr,
+		boost::beast::http::request_parser<boost::beast::http::empty_body>& empty_body_parser,
+		std::function<void(std::function<void()>)> schedule,
+		std::function<void(std::shared_ptr<string_body_parser>)> continuation,
+		const std::string& func)
+	{
+		empty_body_parser.eager(true);
+		auto parser = std::make_shared<string_body_parser>(std::move(empty_body_parser));
+
+		session_ptr->stream().expires_after(session_ptr->timeout());
+		boost::beast::http::async_read(
+			session_ptr->stream(),
+			session_ptr->get_buffer(),
+			*parser,
+			[session_ptr,
+		     parser,
+		     schedule = std::move(schedule),
+		     continuation = std::move(continuation),
+		     func,
+		     profile = irods::s3::rpc_profiler::current()](boost::beast::error_code ec, std::size_t) mutable {
+				// Socket reads complete on the I/O threads, so reinstall the request's profile.
+				const irods::s3::rpc_profiler::scope scope{profile};
+
+				if (ec) {
+					irods::http::logging::error("{}: Error reading request body: {}", func, ec.message());
+					boost::beast::http::response<boost::beast::http::empty_body> response;
+					response.result(boost::beast::http::status::bad_request);
+					irods::http::logging::debug("{}: returned [{}]", func, response.reason());
+					session_ptr->send(std::move(response));
+					return;
+				}
+
+				schedule([parser = std::move(parser), continuation = std::move(continuation)] {
+					continuation(parser);
+				});
+			});
+	}
 } //namespace irods::s3::api::common_routines
 
 #endif // IRODS_S3_API_COMMON_ROUTINES_HPP
@@ -0,0 +1,62 @@
+#ifndef IRODS_S3_API_CONDITIONAL_REQUEST_HPP
+#define IRODS_S3_API_CONDITIONAL_REQUEST_HPP
+
+#include <irods/filesystem/path.hpp>
+
+#include <boost/beast/http/fields.hpp>
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace irods::s3
+{
+	/// The outcome of evaluating the conditional headers of a GET or HEAD request.
+	enum class precondition_result
+	{
+		proceed,
+		not_modified,
+		precondition_failed
+	}; // enum class precondition_result
+
+	/// Returns the ETag of a data object, including the surrounding quotes.
+	///
+	/// The ETag is derived from the logical path, size, modification time and checksum of the
+	/// object, so it changes whenever the object is rewritten and never requires reading the data.
+	/// The modification time only has a resolution of one second, so the checksum is what tells
+	/// apart two writes of the same size within a second, provided that iRODS computed it. Every
+	/// operation reporting an ETag uses this function.
+	///
+	/// The ETag consists of the first 32 hex digits of a SHA-256 hash, so it has the length of an
+	/// MD5 digest without being the MD5 digest of the content.
+	///
+	/// \param _checksum The checksum in the catalog, or an empty string if there is none.
+	auto make_etag(
+		const irods::experimental::filesystem::path& _path,
+		std::uintmax_t _size,
+		std::time_t _mtime,
+		std::string_view _checksum) -> std::string;
+
+	/// Evaluates If-Match, If-Unmodified-Since, If-None-Match and If-Modified-Since.
+	///
+	/// The headers are evaluated in the order given by RFC 9110 section 13.2.2. A date header is
+	/// ignored when the corresponding ETag header is present or the date cannot be parsed.
+	///
+	/// \param _headers The headers of the request.
+	/// \param _etag The current ETag of the object, as returned by make_etag().
+	/// \param _mtime The current modification time of the object.
+	auto evaluate_preconditions(
+		const boost::beast::http::fields& _headers,
+		const std::string& _etag,
+		std::time_t _mtime) -> precondition_result;
+
+	/// Returns true if the Range header of a request should be honored.
+	///
+	/// This is the case when If-Range is absent or still matches the object. Otherwise the whole
+	/// object must be sent, so a resumed download never mixes bytes of two versions of an object.
+	auto range_is_current(const boost::beast::http::fields& _headers, const std::string& _etag, std::time_t _mtime)
+		-> bool;
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_CONDITIONAL_REQUEST_HPP
@@ -3,16 +3,71 @@
 
 #include <nlohmann/json.hpp>
 
+#include <string>
+#include <vector>
+
 namespace irods::s3
 {
+	// How GetObject obtains the checksum sent in the Content-MD5 header.
+	enum class checksum_policy
+	{
+		catalog,      // Send the checksum stored in the catalog, if any.
+		none,         // Never send a checksum.
+		compute_async // Like catalog, but compute a missing checksum in the background for later requests.
+	};
+
+	// How GetObject chooses the replica it reads.
+	enum class replica_selection_policy
+	{
+		resource,    // Let iRODS choose a replica in irods_client.resource.
+		nearest,     // Prefer replicas on the hosts listed in irods_client.replica_selection.local_hosts.
+		fastest,     // Prefer the resources which recently returned the first bytes of a read the soonest.
+		least_loaded // Prefer the resources with the fewest reads in progress from this server.
+	};
+
 	void set_resource(const std::string_view&);
 	std::string get_resource();
 
 	uint64_t get_put_object_buffer_size_in_bytes();
 	uint64_t get_get_object_buffer_size_in_bytes();
+	uint64_t get_get_object_read_ahead_in_bytes();
+	uint64_t get_get_object_small_object_threshold_in_bytes();
+	bool get_get_object_coalescing_enabled();
+	uint64_t get_get_object_coalescing_max_object_size_in_bytes();
+	uint64_t get_get_object_coalescing_budget_in_bytes();
+	uint64_t get_max_transfer_buffer_size_in_bytes();
+	uint64_t get_transfer_buffer_budget_in_bytes();
+	checksum_policy get_get_object_checksum_policy();
+
+	bool get_enable_data_redirection();
+
+	replica_selection_policy get_replica_selection_policy();
+	const std::vector<std::string>& get_replica_selection_local_hosts();
+
+	bool get_direct_vault_reads_enabled();
+
+	uint64_t get_parallel_transfer_threshold_in_bytes();
+	uint64_t get_parallel_transfer_stream_count();
+	uint64_t get_parallel_transfer_block_size_in_bytes();
+	uint64_t get_parallel_transfer_max_buffered_blocks();
+	bool get_parallel_transfer_spread_reads_across_replicas();
+
+	// The hedged read options of a bucket. Options not set for the bucket under
+	// irods_client.hedged_reads.buckets fall back to the options of irods_client.hedged_reads.
+	bool get_hedged_reads_enabled(const std::string& _bucket);
+	double get_hedged_reads_latency_percentile(const std::string& _bucket);
+	uint64_t get_hedged_reads_min_delay_in_milliseconds();
+	uint64_t get_hedged_reads_max_delay_in_milliseconds();
+
+	const std::vector<std::string>& get_archive_resources();
+	std::string get_archive_stage_resource();
 
 	std::string get_s3_region();
 
+	bool get_zerocopy_enabled();
+	uint64_t get_zerocopy_min_response_size_in_bytes();
+	uint64_t get_zerocopy_min_write_size_in_bytes();
+
 } //namespace irods::s3
 
 #endif //IRODS_S3_API_CONFIGURATION_HPP
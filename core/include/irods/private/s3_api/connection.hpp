@@ -3,12 +3,16 @@
 
 #include "irods/rcConnect.h"
 
+#include <irods/client_connection.hpp>
+#include <irods/filesystem/path.hpp>
+
 #include <nlohmann/json.hpp>
 
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace irods::s3
 {
@@ -31,5 +35,59 @@ namespace irods::s3
 
 	std::unique_ptr<rcComm_t, __detail::rcComm_Deleter> get_connection(
 		const std::optional<std::string>& _client_username = std::nullopt);
+
+	/// Identifies which side of a transfer a data connection is used for.
+	enum class data_transfer_direction
+	{
+		read,
+		write
+	};
+
+	/// Creates a dedicated iRODS connection on behalf of a client user.
+	///
+	/// The rodsadmin account from the configuration file acts as the proxy for the user.
+	///
+	/// \param _client_username The iRODS user the connection acts on behalf of.
+	/// \param _host The iRODS server to connect to. Defaults to the configured iRODS server.
+	///
+	/// \throws irods::exception If the connection cannot be authenticated.
+	std::shared_ptr<irods::experimental::client_connection> get_dedicated_connection(
+		const std::string& _client_username,
+		const std::optional<std::string>& _host = std::nullopt);
+
+	/// Creates a dedicated iRODS connection for moving the bytes of a data object.
+	///
+	/// When data redirection is enabled, the iRODS server which serves (or receives) the bytes of
+	/// \p _path is resolved first and the connection is opened directly against that server. This
+	/// keeps the catalog provider out of the data path. If the server cannot be resolved or reached,
+	/// the configured iRODS server is used instead.
+	///
+	/// \param _client_username The iRODS user the connection acts on behalf of.
+	/// \param _path The logical path of the data object being transferred.
+	/// \param _direction Whether the bytes are read from or written to iRODS.
+	///
+	/// \throws irods::exception If the connection cannot be authenticated.
+	std::shared_ptr<irods::experimental::client_connection> get_data_connection(
+		const std::string& _client_username,
+		const irods::experimental::filesystem::path& _path,
+		data_transfer_direction _direction);
+
+	/// Creates several dedicated iRODS connections for moving the bytes of a data object.
+	///
+	/// Behaves like get_data_connection(), except that the data host is resolved once and all
+	/// connections are opened against the same server. This matters when the connections share a
+	/// replica token, since a token is only valid on the server which issued it.
+	///
+	/// \param _client_username The iRODS user the connections act on behalf of.
+	/// \param _path The logical path of the data object being transferred.
+	/// \param _direction Whether the bytes are read from or written to iRODS.
+	/// \param _count The number of connections to create.
+	///
+	/// \throws irods::exception If a connection cannot be authenticated.
+	std::vector<std::shared_ptr<irods::experimental::client_connection>> get_data_connections(
+		const std::string& _client_username,
+		const irods::experimental::filesystem::path& _path,
+		data_transfer_direction _direction,
+		std::size_t _count);
 } //namespace irods::s3
 #endif // IRODS_S3_API_CONNECTION_HPP
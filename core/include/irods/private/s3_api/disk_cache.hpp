@@ -0,0 +1,180 @@
+#ifndef IRODS_S3_API_DISK_CACHE_HPP
+#define IRODS_S3_API_DISK_CACHE_HPP
+
+#include "irods/private/s3_api/object_cache.hpp"
+
+#include <irods/filesystem/path.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace irods::s3
+{
+	/// A cache of whole data objects on local disk.
+	///
+	/// Every entry is a pair of files named after the SHA-256 of the logical path: "<hash>.data"
+	/// holds the bytes and "<hash>.meta" holds the logical path and the version of the object. Both
+	/// files are written under temporary names, flushed and then renamed, the metadata last. An entry
+	/// therefore only exists once all of its bytes are on disk, and the index can be rebuilt from the
+	/// directory after a crash. Incomplete and orphaned files are removed on startup.
+	///
+	/// Entries are evicted with a segmented LRU: an entry is promoted to the protected segment on
+	/// its second use and eviction always starts with the probationary segment.
+	///
+	/// Entries are validated against the catalog information of the object on every lookup.
+	class disk_cache
+	{
+	  public:
+		using version = object_cache::version;
+
+		/// A cached object opened for reading. The file stays readable even if the entry is
+		/// evicted while it is open.
+		class file
+		{
+		  public:
+			explicit file(int _fd) noexcept;
+			~file();
+
+			file(file&& _other) noexcept;
+			auto operator=(file&&) -> file& = delete;
+
+			file(const file&) = delete;
+			auto operator=(const file&) -> file& = delete;
+
+			auto native_handle() const noexcept -> int;
+
+		  private:
+			int fd_;
+		}; // class file
+
+		struct statistics
+		{
+			std::uint64_t hits = 0;
+			std::uint64_t misses = 0;
+			std::uint64_t fills = 0;
+			std::uint64_t failed_fills = 0;
+			std::uint64_t evictions = 0;
+			std::uint64_t bytes_served = 0;
+			std::uint64_t entries = 0;
+			std::uint64_t size_in_bytes = 0;
+		}; // struct statistics
+
+		/// Opens the cache in \p _directory, creating the directory if necessary, and rebuilds the
+		/// index from the entries found there.
+		///
+		/// \param _capacity_in_bytes The maximum number of object bytes held on disk.
+		/// \param _min_object_size_in_bytes Smaller objects are never cached.
+		///
+		/// \throws std::filesystem::filesystem_error If the directory cannot be created or read.
+		disk_cache(
+			std::filesystem::path _directory,
+			std::uint64_t _capacity_in_bytes,
+			std::uint64_t _min_object_size_in_bytes);
+
+		disk_cache(const disk_cache&) = delete;
+		auto operator=(const disk_cache&) -> disk_cache& = delete;
+
+		/// Returns true if an object of \p _size bytes may be cached.
+		auto accepts(std::uint64_t _size) const noexcept -> bool;
+
+		/// Opens the cached copy of \p _path, or returns an empty std::optional if the object is not
+		/// cached or the cached copy does not match \p _version.
+		auto open(const std::string& _path, const version& _version) -> std::optional<file>;
+
+		/// Returns true if \p _path is cached with \p _version. Unlike open(), this does not count as
+		/// a request for the object.
+		auto contains(const std::string& _path, const version& _version) const -> bool;
+
+		/// Copies \p _path from iRODS into the cache on a background thread. Does nothing if the
+		/// object is already being copied. The copy is discarded if the object no longer matches
+		/// \p _version once it has been copied, or if it is invalidated in the meantime.
+		///
+		/// \param _client_username The iRODS user the object is read as.
+		auto fill_async(
+			const std::string& _client_username,
+			const irods::experimental::filesystem::path& _path,
+			const version& _version) -> void;
+
+		/// Removes \p _path from the cache. Called whenever the object is written or removed.
+		auto invalidate(const std::string& _path) -> void;
+
+		/// Records the number of bytes sent to a client from the cache.
+		auto record_bytes_served(std::uint64_t _bytes) noexcept -> void;
+
+		auto stats() const -> statistics;
+
+		/// Writes the hit ratio and the use of the cache to the log.
+		auto log_report() const -> void;
+
+	  private:
+		enum class segment
+		{
+			probation,
+			protected_
+		};
+
+		struct entry
+		{
+			std::string path;
+			version current_version;
+			segment where = segment::probation;
+			std::list<std::string>::iterator position;
+		};
+
+		auto fill(
+			const std::string& _client_username,
+			const irods::experimental::filesystem::path& _path,
+			const version& _version) -> bool;
+
+		auto insert(const std::string& _key, const std::string& _path, const version& _version) -> void;
+		auto touch(entry& _entry) -> void;
+		auto erase(std::unordered_map<std::string, entry>::iterator _iter) -> void;
+		auto evict_if_needed() -> void;
+		auto rebuild_index() -> void;
+
+		auto key_of(const std::string& _path) const -> std::string;
+		auto data_file(const std::string& _key) const -> std::filesystem::path;
+		auto meta_file(const std::string& _key) const -> std::filesystem::path;
+
+		const std::filesystem::path directory_;
+		const std::uint64_t capacity_;
+		const std::uint64_t min_object_size_;
+
+		mutable std::mutex mutex_;
+		std::unordered_map<std::string, entry> index_;
+		std::list<std::string> probation_;
+		std::list<std::string> protected_;
+		std::uint64_t size_ = 0;
+		std::uint64_t protected_size_ = 0;
+		std::unordered_set<std::string> fills_in_progress_;
+
+		// The fills in progress whose object was written since they started.
+		std::unordered_set<std::string> invalidated_fills_;
+
+		std::atomic<std::uint64_t> hits_{0};
+		std::atomic<std::uint64_t> misses_{0};
+		std::atomic<std::uint64_t> fills_{0};
+		std::atomic<std::uint64_t> failed_fills_{0};
+		std::atomic<std::uint64_t> evictions_{0};
+		std::atomic<std::uint64_t> bytes_served_{0};
+	}; // class disk_cache
+
+	/// Sends \p _count bytes of \p _file starting at \p _offset to a non-blocking socket using
+	/// sendfile(2), so that the bytes go straight from the page cache to the socket.
+	///
+	/// Never waits for the socket. \p _offset and \p _count are advanced past the bytes the kernel
+	/// took, so the caller can resume once the socket becomes writable again.
+	///
+	/// \returns 0 once every byte has been sent, EAGAIN if the socket cannot take more bytes right
+	/// now, otherwise the errno of the failure.
+	auto send_file(int _socket, const disk_cache::file& _file, std::uint64_t& _offset, std::uint64_t& _count) -> int;
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_DISK_CACHE_HPP
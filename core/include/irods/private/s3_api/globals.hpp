@@ -9,6 +9,15 @@
 
 #include <functional>
 
+namespace irods::s3
+{
+	class disk_cache;
+	class object_cache;
+	class open_handle_cache;
+	class prefetcher;
+	class restore_queue;
+} // namespace irods::s3
+
 namespace irods::http::globals
 {
 	auto set_configuration(const nlohmann::json& _config) -> void;
@@ -17,12 +26,50 @@ namespace irods::http::globals
 	auto set_request_handler_io_context(boost::asio::io_context& _ioc) -> void;
 	auto request_handler_io_context() -> boost::asio::io_context&;
 
+	// Long running tasks which move object bytes (e.g. GetObject, PutObject, CopyObject).
 	auto set_background_thread_pool(boost::asio::thread_pool& _tp) -> void;
 	auto background_thread_pool() -> boost::asio::thread_pool&;
 	auto background_task(std::function<void()> _task) -> void;
 
+	// Short catalog operations (e.g. HeadObject, ListObjects, DeleteObject). These run on their own
+	// threads so that they are never queued behind bulk data movement.
+	auto set_metadata_thread_pool(boost::asio::thread_pool& _tp) -> void;
+	auto metadata_thread_pool() -> boost::asio::thread_pool&;
+	auto metadata_task(std::function<void()> _task) -> void;
+
+	// CPU bound work (e.g. hashing) which should not hold up I/O threads.
+	auto set_compute_thread_pool(boost::asio::thread_pool& _tp) -> void;
+	auto compute_thread_pool() -> boost::asio::thread_pool&;
+	auto compute_task(std::function<void()> _task) -> void;
+
+	// The data streams of parallel PutObject and GetObject transfers. The size of this pool limits the
+	// number of streams moving bytes at once across all transfers.
+	auto set_transfer_thread_pool(boost::asio::thread_pool& _tp) -> void;
+	auto transfer_thread_pool() -> boost::asio::thread_pool&;
+	auto transfer_task(std::function<void()> _task) -> void;
+
 	auto set_connection_pool(irods::connection_pool& _cp) -> void;
 	auto connection_pool() -> irods::connection_pool&;
+
+	// The in-memory object cache, or nullptr if caching is disabled.
+	auto set_object_cache(irods::s3::object_cache* _cache) -> void;
+	auto object_cache() -> irods::s3::object_cache*;
+
+	// The on-disk object cache, or nullptr if it is disabled.
+	auto set_disk_cache(irods::s3::disk_cache* _cache) -> void;
+	auto disk_cache() -> irods::s3::disk_cache*;
+
+	// Stages archived objects for RestoreObject, or nullptr if no archive is configured.
+	auto set_restore_queue(irods::s3::restore_queue* _queue) -> void;
+	auto restore_queue() -> irods::s3::restore_queue*;
+
+	// Reads ahead the objects of a listing a client downloads in order, or nullptr if disabled.
+	auto set_prefetcher(irods::s3::prefetcher* _prefetcher) -> void;
+	auto prefetcher() -> irods::s3::prefetcher*;
+
+	// Keeps data objects open between ranged GetObject requests, or nullptr if disabled.
+	auto set_open_handle_cache(irods::s3::open_handle_cache* _cache) -> void;
+	auto open_handle_cache() -> irods::s3::open_handle_cache*;
 } // namespace irods::http::globals
 
 #endif // IRODS_S3_API_GLOBALS_HPP
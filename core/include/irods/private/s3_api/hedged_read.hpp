@@ -0,0 +1,106 @@
+#ifndef IRODS_S3_API_HEDGED_READ_HPP
+#define IRODS_S3_API_HEDGED_READ_HPP
+
+#include <irods/client_connection.hpp>
+#include <irods/dstream.hpp>
+#include <irods/filesystem/path.hpp>
+#include <irods/rcConnect.h>
+#include <irods/transport/default_transport.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace irods::s3
+{
+	/// A data object open for reading on a dedicated connection.
+	struct replica_stream
+	{
+		explicit replica_stream(std::shared_ptr<irods::experimental::client_connection> _conn);
+
+		std::shared_ptr<irods::experimental::client_connection> conn;
+		irods::experimental::io::client::default_transport xtrans;
+		irods::experimental::io::idstream in;
+	}; // struct replica_stream
+
+	/// Reads the first bytes of a GetObject from a second good replica if the replica being read
+	/// is slow to answer.
+	///
+	/// The read starts on the stream iRODS opened for the request. If no bytes have arrived once
+	/// the delay passes, another good replica is opened on a background thread and the same bytes
+	/// are read from it. Whichever read completes first is used. The connection of the losing read
+	/// is shut down so that its read returns at once, and the loser is closed.
+	///
+	/// A hedged read is used once, for the first read of a transfer. The rest of the transfer
+	/// continues on the replica which won.
+	class hedged_read
+	{
+	  public:
+		/// \param _client_username The iRODS user the alternate replica is read as.
+		/// \param _path The logical path of the data object.
+		/// \param _offset The offset the first read starts at.
+		/// \param _delay How long to wait for the first bytes before reading another replica.
+		hedged_read(
+			std::string _client_username,
+			irods::experimental::filesystem::path _path,
+			std::uint64_t _offset,
+			std::chrono::milliseconds _delay);
+
+		~hedged_read();
+
+		hedged_read(const hedged_read&) = delete;
+		auto operator=(const hedged_read&) -> hedged_read& = delete;
+
+		/// Reads up to \p _count bytes into \p _buffer. Blocks until a replica answers.
+		///
+		/// \param _primary_conn The connection \p _primary is open on.
+		/// \param _primary The stream opened for the request, positioned at the offset.
+		///
+		/// \returns The number of bytes read, or 0 if every replica read failed.
+		auto read(
+			RcComm& _primary_conn,
+			irods::experimental::io::idstream& _primary,
+			char* _buffer,
+			std::size_t _count) -> std::size_t;
+
+		/// Returns the alternate replica if it won the read, positioned after the bytes returned
+		/// by read(), otherwise nullptr. Once the alternate has won, the connection of the primary
+		/// stream is shut down and must not be read from again.
+		auto take_alternate() -> std::unique_ptr<replica_stream>;
+
+	  private:
+		struct race;
+
+		static auto start_alternate(std::shared_ptr<race> _race) -> void;
+
+		std::shared_ptr<race> race_;
+	}; // class hedged_read
+
+	namespace hedged_reads
+	{
+		struct statistics
+		{
+			std::uint64_t reads = 0;
+			std::uint64_t hedges = 0;
+			std::uint64_t alternate_wins = 0;
+			std::uint64_t failed_hedges = 0;
+		}; // struct statistics
+
+		/// Returns how long a GetObject on \p _bucket waits for the first bytes of a replica before
+		/// it reads another replica as well, or an empty std::optional if hedged reads are disabled
+		/// for the bucket.
+		///
+		/// The delay is the configured percentile of recent first-byte latencies, clamped to
+		/// irods_client.hedged_reads.min_delay_in_milliseconds and max_delay_in_milliseconds.
+		auto delay_for(const std::string& _bucket) -> std::optional<std::chrono::milliseconds>;
+
+		auto stats() -> statistics;
+
+		/// Writes how often reads were hedged and how often the alternate replica won to the log.
+		auto log_report() -> void;
+	} // namespace hedged_reads
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_HEDGED_READ_HPP
@@ -0,0 +1,103 @@
+#ifndef IRODS_S3_API_OBJECT_CACHE_HPP
+#define IRODS_S3_API_OBJECT_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace irods::s3
+{
+	/// A size-bounded in-memory cache of small data objects.
+	///
+	/// The cache is split into shards, each guarded by its own lock. Every shard uses W-TinyLFU: new
+	/// objects enter a small LRU window, and an object leaving the window is only admitted to the
+	/// main segmented LRU if it has been requested more often than the object it would displace.
+	/// Request frequencies are estimated with a count-min sketch which is halved periodically so
+	/// that old popularity fades.
+	///
+	/// Entries are validated against the catalog information of the object on every lookup, so an
+	/// object changed outside of the S3 API is never served stale.
+	class object_cache
+	{
+	  public:
+		/// Identifies the contents of a data object as known to the catalog.
+		struct version
+		{
+			std::uintmax_t size = 0;
+			std::time_t mtime = 0;
+			std::string checksum;
+
+			auto operator==(const version&) const -> bool = default;
+		}; // struct version
+
+		struct statistics
+		{
+			std::uint64_t hits = 0;
+			std::uint64_t misses = 0;
+			std::uint64_t bytes_saved = 0;
+			std::uint64_t entries = 0;
+			std::uint64_t size_in_bytes = 0;
+		}; // struct statistics
+
+		/// \param _capacity_in_bytes The maximum number of object bytes held by the cache.
+		/// \param _max_object_size_in_bytes Larger objects are never cached.
+		/// \param _shard_count The number of independently locked shards. Reduced if a shard would
+		///                     be too small to hold two objects of the maximum size.
+		object_cache(
+			std::uint64_t _capacity_in_bytes,
+			std::uint64_t _max_object_size_in_bytes,
+			std::size_t _shard_count);
+
+		~object_cache();
+
+		object_cache(const object_cache&) = delete;
+		auto operator=(const object_cache&) -> object_cache& = delete;
+
+		auto max_object_size_in_bytes() const noexcept -> std::uint64_t;
+
+		/// Returns the cached contents of \p _path, or nullptr if the object is not cached or the
+		/// cached copy does not match \p _version.
+		///
+		/// Every lookup counts towards the frequency of \p _path, whether or not it is a hit.
+		auto find(const std::string& _path, const version& _version) -> std::shared_ptr<const std::vector<char>>;
+
+		/// Offers the contents of \p _path to the cache. The cache may decline to keep them.
+		auto insert(const std::string& _path, const version& _version, std::shared_ptr<const std::vector<char>> _data)
+			-> void;
+
+		/// Returns true if \p _path is cached with \p _version. Unlike find(), this does not count as
+		/// a request for the object.
+		auto contains(const std::string& _path, const version& _version) const -> bool;
+
+		/// Removes \p _path from the cache. Called whenever the object is written or removed.
+		auto invalidate(const std::string& _path) -> void;
+
+		/// Records the number of bytes sent to a client from the cache instead of iRODS.
+		auto record_bytes_saved(std::uint64_t _bytes) noexcept -> void;
+
+		auto stats() const -> statistics;
+
+		/// Writes the hit ratio and bytes saved to the log.
+		auto log_report() const -> void;
+
+	  private:
+		class shard;
+
+		auto shard_for(const std::string& _path) const -> shard&;
+
+		std::uint64_t max_object_size_;
+		std::vector<std::unique_ptr<shard>> shards_;
+		std::atomic<std::uint64_t> hits_{0};
+		std::atomic<std::uint64_t> misses_{0};
+		std::atomic<std::uint64_t> bytes_saved_{0};
+	}; // class object_cache
+
+	/// Drops \p _path from the process-wide in-memory and on-disk caches and closes the handles kept
+	/// open on it, if they are enabled.
+	auto invalidate_cached_object(const std::string& _path) -> void;
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_OBJECT_CACHE_HPP
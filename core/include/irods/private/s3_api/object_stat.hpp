@@ -0,0 +1,96 @@
+#ifndef IRODS_S3_API_OBJECT_STAT_HPP
+#define IRODS_S3_API_OBJECT_STAT_HPP
+
+#include <irods/filesystem/path.hpp>
+#include <irods/rcConnect.h>
+
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace irods::s3
+{
+	/// The catalog information about a data object needed to serve an S3 request.
+	///
+	/// When the object has several replicas, the information describes a good replica if one
+	/// exists.
+	struct object_stat
+	{
+		std::uintmax_t size = 0;
+		std::time_t mtime = 0;
+
+		/// The checksum of a good replica, if any good replica has one.
+		std::string checksum;
+		std::string owner;
+		int replica_number = 0;
+		bool good_replica = false;
+
+		/// True if the user may read the bytes of the object, through a permission of its own or
+		/// of one of its groups. The permission to read metadata only does not count.
+		bool accessible = false;
+
+		/// The leaf resources holding the good replicas.
+		std::vector<std::string> good_resources;
+	}; // struct object_stat
+
+	/// Returns the GenQuery condition selecting the data object at \p _path.
+	///
+	/// GenQuery cannot escape a quote within a literal, so a name containing one is matched with a
+	/// like pattern in which the quote is the single-character wildcard. Such a condition may select
+	/// other data objects as well, so the query must select COLL_NAME and DATA_NAME and the caller
+	/// must skip the rows for which is_data_object() returns false.
+	auto make_data_object_condition(const irods::experimental::filesystem::path& _path) -> std::string;
+
+	/// Returns true if the COLL_NAME \p _collection and DATA_NAME \p _name of a row name the data
+	/// object at \p _path.
+	auto is_data_object(
+		const irods::experimental::filesystem::path& _path,
+		std::string_view _collection,
+		std::string_view _name) -> bool;
+
+	/// Whether stat_object() may return the result of a lookup of the same object which another
+	/// caller started earlier.
+	enum class stat_sharing
+	{
+		/// Concurrent lookups of the same object and user share one query.
+		allowed,
+
+		/// The object is looked up by the caller, e.g. because the caller has just changed the object
+		/// and a lookup which started before the change would return stale information.
+		none
+	};
+
+	/// Fetches the size, modification time, checksum, owner, replica status, the resources of the
+	/// good replicas and the permissions of \p _username on a data object in a single GenQuery.
+	/// The groups of \p _username are looked up as well if the object is readable by anyone else.
+	///
+	/// Unless \p _sharing is stat_sharing::none, concurrent calls for the same object and user share
+	/// one query, which runs on the connection of the first caller. If that connection breaks, the
+	/// other callers run the query on their own connections instead of failing too.
+	///
+	/// \param _conn A connection acting on behalf of \p _username.
+	/// \param _path The logical path of the data object.
+	/// \param _username The user whose permissions are checked.
+	/// \param _sharing Whether the result of a lookup in progress may be returned.
+	///
+	/// \returns The stat information, or an empty std::optional if no data object exists at
+	///          \p _path (including when \p _path is a collection).
+	///
+	/// \throws irods::exception If the query fails.
+	auto stat_object(
+		RcComm& _conn,
+		const irods::experimental::filesystem::path& _path,
+		std::string_view _username,
+		stat_sharing _sharing = stat_sharing::allowed) -> std::optional<object_stat>;
+
+	/// Returns the replica numbers of the good replicas of a data object.
+	///
+	/// \throws irods::exception If the query fails.
+	auto get_good_replica_numbers(RcComm& _conn, const irods::experimental::filesystem::path& _path)
+		-> std::vector<int>;
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_OBJECT_STAT_HPP
@@ -0,0 +1,142 @@
+#ifndef IRODS_S3_API_OPEN_HANDLE_CACHE_HPP
+#define IRODS_S3_API_OPEN_HANDLE_CACHE_HPP
+
+#include "irods/private/s3_api/object_stat.hpp"
+
+#include <irods/client_connection.hpp>
+#include <irods/dstream.hpp>
+#include <irods/filesystem/path.hpp>
+#include <irods/transport/default_transport.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace irods::s3
+{
+	/// A data object opened for reading, together with the connection it was opened on and the
+	/// catalog information it was opened with.
+	///
+	/// A handle is used by one request at a time.
+	struct read_handle
+	{
+		/// \param _conn The connection the data object is opened on.
+		/// \param _username The iRODS user the connection acts on behalf of.
+		/// \param _path The logical path of the data object.
+		/// \param _stat The catalog information about the data object.
+		/// \param _looked_up When \p _stat was requested from the catalog.
+		read_handle(
+			std::shared_ptr<irods::experimental::client_connection> _conn,
+			std::string _username,
+			irods::experimental::filesystem::path _path,
+			object_stat _stat,
+			std::chrono::steady_clock::time_point _looked_up);
+
+		read_handle(const read_handle&) = delete;
+		auto operator=(const read_handle&) -> read_handle& = delete;
+
+		std::shared_ptr<irods::experimental::client_connection> conn;
+		irods::experimental::io::client::default_transport transport;
+		irods::experimental::io::idstream in;
+
+		std::string username;
+		irods::experimental::filesystem::path path;
+
+		/// The replica the stream is open on, or empty if iRODS chose a replica in
+		/// irods_client.resource.
+		std::optional<int> replica_number;
+
+		object_stat stat;
+
+		/// When stat was requested from the catalog. Writes through the gateway after this point
+		/// make the handle stale.
+		std::chrono::steady_clock::time_point looked_up;
+
+		/// When the handle was last given back to the cache.
+		std::chrono::steady_clock::time_point last_used;
+	}; // struct read_handle
+
+	/// Keeps the data objects read by ranged GetObject requests open for the next request.
+	///
+	/// Parallel downloaders and columnar readers issue many small ranged requests against one object.
+	/// Each of them would otherwise create a connection, look the object up, open it and close it
+	/// again, which costs far more than reading a few KiB. A request takes an idle handle for the
+	/// same user, object and replica, seeks and reads, and gives the handle back once the response is
+	/// sent.
+	///
+	/// Handles are dropped when a write to the object goes through the gateway, when they have been
+	/// idle for too long, and when they are older than the maximum age. The maximum age bounds how
+	/// long changes made outside the gateway may go unnoticed.
+	class open_handle_cache
+	{
+	  public:
+		struct options
+		{
+			/// The maximum number of idle handles. Each of them holds a connection to iRODS.
+			std::size_t max_handles = 64;
+
+			/// Handles which have not been used for this long are closed.
+			std::chrono::seconds idle_timeout{5};
+
+			/// Handles whose catalog information is older than this are not reused.
+			std::chrono::seconds max_age{60};
+		}; // struct options
+
+		explicit open_handle_cache(const options& _options);
+
+		~open_handle_cache();
+
+		open_handle_cache(const open_handle_cache&) = delete;
+		auto operator=(const open_handle_cache&) -> open_handle_cache& = delete;
+
+		/// Removes an idle handle on replica \p _replica_number of \p _path opened on behalf of
+		/// \p _username from the cache. An empty \p _replica_number asks for a handle on the replica
+		/// iRODS chose.
+		///
+		/// \returns The handle, or nullptr if there is none.
+		auto take(const std::string& _username, const std::string& _path, std::optional<int> _replica_number)
+			-> std::unique_ptr<read_handle>;
+
+		/// Keeps \p _handle open for the next request, unless the object was written since the handle
+		/// looked it up or the stream is no longer usable. The least recently used handle is closed
+		/// if the cache is full.
+		auto give_back(std::unique_ptr<read_handle> _handle) -> void;
+
+		/// Closes the idle handles on \p _path and keeps handles in use from being given back.
+		auto invalidate(const std::string& _path) -> void;
+
+		/// Closes the handles which have been idle for too long or are too old.
+		auto expire() -> void;
+
+		/// Writes the hit rate and the number of idle handles to the log.
+		auto log_report() const -> void;
+
+	  private:
+		static auto make_key(const std::string& _username, const std::string& _path, std::optional<int> _replica_number)
+			-> std::string;
+
+		// True if the handle is too old or its object was written since the handle looked it up. Must
+		// be called with mutex_ held.
+		auto is_stale(const read_handle& _handle, std::chrono::steady_clock::time_point _now) const -> bool;
+
+		const options options_;
+
+		mutable std::mutex mutex_;
+		std::unordered_multimap<std::string, std::unique_ptr<read_handle>> idle_;
+
+		// The last write through the gateway to each object written within the maximum age.
+		std::unordered_map<std::string, std::chrono::steady_clock::time_point> written_;
+
+		std::atomic<std::uint64_t> hits_{0};
+		std::atomic<std::uint64_t> misses_{0};
+		std::atomic<std::uint64_t> closed_{0};
+	}; // class open_handle_cache
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_OPEN_HANDLE_CACHE_HPP
@@ -0,0 +1,200 @@
+#ifndef IRODS_S3_API_PARALLEL_TRANSFER_HPP
+#define IRODS_S3_API_PARALLEL_TRANSFER_HPP
+
+#include <irods/filesystem/path.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace irods::s3
+{
+	/// Writes a single replica of a data object over several iRODS data streams at once.
+	///
+	/// The first stream creates (or truncates) the replica. The remaining streams are opened with
+	/// the first stream's replica token so that all of them write into the same replica. Each block
+	/// is handed to whichever stream is idle and written at its own offset, so the order in which
+	/// blocks complete does not matter.
+	///
+	/// Writes are performed on the transfer thread pool shared by all transfers, and neither write()
+	/// nor close() waits for them. Blocks which arrive while every stream is busy are queued. A
+	/// caller which should not produce blocks faster than they are written waits for when_ready()
+	/// to call back, which bounds the memory held by a transfer to one block per stream plus the
+	/// blocks handed over in between.
+	///
+	/// Callbacks run on the background thread pool. Outstanding writes keep the writer alive, so it
+	/// must be owned by a std::shared_ptr.
+	class parallel_writer : public std::enable_shared_from_this<parallel_writer>
+	{
+	  public:
+		/// \param _client_username The iRODS user the streams act on behalf of.
+		/// \param _path The logical path of the data object to write.
+		/// \param _stream_count The number of data streams to open.
+		///
+		/// \throws irods::exception If a connection cannot be established.
+		parallel_writer(
+			const std::string& _client_username,
+			const irods::experimental::filesystem::path& _path,
+			std::size_t _stream_count);
+
+		~parallel_writer();
+
+		parallel_writer(const parallel_writer&) = delete;
+		auto operator=(const parallel_writer&) -> parallel_writer& = delete;
+
+		/// Returns true if every stream was opened successfully.
+		auto is_open() const noexcept -> bool;
+
+		/// Schedules a block to be written at \p _offset. Never waits for a stream.
+		///
+		/// \returns false if a previous write failed or the writer is being closed.
+		auto write(std::uint64_t _offset, std::vector<char> _block) -> bool;
+
+		/// Calls \p _callback once no block is waiting for a stream, i.e. once the caller may hand
+		/// over more blocks. The callback runs right away on the calling thread if no block is
+		/// waiting, otherwise on a background thread. Replaces a callback which has not run yet.
+		auto when_ready(std::function<void()> _callback) -> void;
+
+		/// Closes the streams once every outstanding write has completed. Returns right away.
+		///
+		/// The secondary streams are closed without updating the catalog. The stream which created
+		/// the replica is closed last and finalizes the replica once all bytes are in place.
+		///
+		/// \param _on_closed Called on a background thread once the streams are closed, with false
+		///                   if any write failed.
+		auto close(std::function<void(bool)> _on_closed) -> void;
+
+		/// Gives up on the transfer, e.g. because the client went away before sending every byte.
+		///
+		/// Closes the streams once the outstanding writes have completed. Returns right away.
+		///
+		/// \param _remove_object Whether to remove the data object so that the partial replica is
+		///                       never mistaken for a complete one. Pass false if the object existed
+		///                       before the transfer. The streams open the object with truncation,
+		///                       so an existing object is left truncated or partially written.
+		auto abandon(bool _remove_object) -> void;
+
+	  private:
+		struct stream;
+
+		struct queued_block
+		{
+			std::uint64_t offset;
+			std::vector<char> data;
+		}; // struct queued_block
+
+		auto start_writes() -> void;
+		auto write_block(std::size_t _stream_index, const queued_block& _block) -> void;
+		auto close_streams() -> void;
+
+		irods::experimental::filesystem::path path_;
+		std::vector<std::unique_ptr<stream>> streams_;
+
+		std::mutex mutex_;
+		std::vector<std::size_t> idle_streams_;
+		std::deque<queued_block> queued_blocks_;
+		std::function<void()> on_ready_;
+		std::vector<std::function<void(bool)>> on_closed_;
+		bool opened_ = false;
+		bool failed_ = false;
+		bool closing_ = false;
+		bool closed_ = false;
+	}; // class parallel_writer
+
+	/// Reads a byte range of a data object over several iRODS data streams at once.
+	///
+	/// The range is split into stripes of a fixed block size. Each stream repeatedly claims the
+	/// next unread stripe, so a slow stream does not hold back the others. Stripes which complete
+	/// early wait in a bounded reorder buffer until every stripe before them has been returned by
+	/// next(), which hands the range to the caller in offset order.
+	///
+	/// Each stripe is read by a task on the transfer thread pool shared by all transfers. A stream
+	/// whose next stripe does not fit in the reorder buffer gives its thread back until next()
+	/// makes room. Outstanding reads keep the reader alive, so it must be owned by a std::shared_ptr.
+	///
+	/// Streams can optionally be spread over the good replicas of the data object, one replica per
+	/// stream in turn, so that a single transfer draws on more than one storage resource.
+	class parallel_reader : public std::enable_shared_from_this<parallel_reader>
+	{
+	  public:
+		/// \param _client_username The iRODS user the streams act on behalf of.
+		/// \param _path The logical path of the data object to read.
+		/// \param _stream_count The number of data streams to open.
+		/// \param _spread_across_replicas Whether to open the streams against different good replicas.
+		///
+		/// \throws irods::exception If a connection cannot be established.
+		parallel_reader(
+			const std::string& _client_username,
+			const irods::experimental::filesystem::path& _path,
+			std::size_t _stream_count,
+			bool _spread_across_replicas = false);
+
+		~parallel_reader();
+
+		parallel_reader(const parallel_reader&) = delete;
+		auto operator=(const parallel_reader&) -> parallel_reader& = delete;
+
+		/// Returns true if every stream was opened successfully.
+		auto is_open() const noexcept -> bool;
+
+		auto stream_count() const noexcept -> std::size_t;
+
+		/// Starts reading \p _length bytes beginning at \p _offset.
+		///
+		/// Must be called at most once.
+		///
+		/// \param _block_size The number of bytes in each stripe. The final stripe may be shorter.
+		/// \param _max_buffered_blocks The maximum number of stripes being read or waiting to be
+		///                             returned by next(). Never less than the number of streams.
+		auto start(
+			std::uint64_t _offset,
+			std::uint64_t _length,
+			std::uint64_t _block_size,
+			std::size_t _max_buffered_blocks) -> void;
+
+		/// Returns the next stripe in offset order, blocking until it has been read.
+		///
+		/// \returns The stripe, or an empty std::optional if a read failed or the whole range has
+		///          already been returned.
+		auto next() -> std::optional<std::vector<char>>;
+
+		/// Stops the transfer early. Reads in progress complete, but no further stripes are read and
+		/// next() returns an empty std::optional.
+		///
+		/// May be called from any thread.
+		auto cancel() -> void;
+
+	  private:
+		struct stream;
+
+		auto schedule_read(std::size_t _stream_index) -> void;
+
+		// Reads the next unclaimed stripe. Returns false once the stream should stop or has been
+		// parked because the reorder buffer is full.
+		auto read_stripe(std::size_t _stream_index) -> bool;
+
+		irods::experimental::filesystem::path path_;
+		std::vector<std::unique_ptr<stream>> streams_;
+
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::uint64_t block_size_ = 0;
+		std::uint64_t max_buffered_bytes_ = 0;
+		std::uint64_t end_ = 0;
+		std::uint64_t next_claim_ = 0;
+		std::uint64_t next_return_ = 0;
+		std::map<std::uint64_t, std::vector<char>> reorder_buffer_;
+		std::vector<std::size_t> parked_streams_;
+		bool failed_ = false;
+		bool stopping_ = false;
+	}; // class parallel_reader
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_PARALLEL_TRANSFER_HPP
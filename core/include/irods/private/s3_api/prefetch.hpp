@@ -0,0 +1,119 @@
+#ifndef IRODS_S3_API_PREFETCH_HPP
+#define IRODS_S3_API_PREFETCH_HPP
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace irods::s3
+{
+	/// A data object returned by ListObjectsV2.
+	struct listed_object
+	{
+		/// The logical path of the data object.
+		std::string path;
+
+		/// The size of the data object according to the listing.
+		std::uint64_t size = 0;
+	}; // struct listed_object
+
+	/// Reads ahead the objects a client is about to download one after another.
+	///
+	/// Recursive copies and sync tools list a prefix and then GET the listed keys in lexicographic
+	/// order. The most recent listing of every client is remembered. Once a client has fetched two
+	/// objects of its listing, the objects following the furthest one fetched are copied into the
+	/// object cache or the disk cache, so that the client finds them there.
+	///
+	/// Prefetching runs on threads of its own. While the memory or bandwidth budget is used up, no
+	/// further objects are scheduled. Objects the client reaches in the meantime are not prefetched.
+	class prefetcher
+	{
+	  public:
+		struct options
+		{
+			/// The number of objects read ahead of the furthest object fetched by the client.
+			std::size_t object_count = 4;
+
+			/// The maximum number of object bytes held in memory by prefetches in progress.
+			std::uint64_t max_bytes_in_flight = 67108864;
+
+			/// The maximum rate at which objects are prefetched, or 0 for no limit.
+			std::uint64_t max_bytes_per_second = 104857600;
+
+			/// Listings which have not been used for this long are forgotten.
+			std::chrono::seconds listing_ttl{300};
+
+			/// The number of objects prefetched at once.
+			std::size_t thread_count = 2;
+		}; // struct options
+
+		explicit prefetcher(const options& _options);
+
+		~prefetcher();
+
+		prefetcher(const prefetcher&) = delete;
+		auto operator=(const prefetcher&) -> prefetcher& = delete;
+
+		/// Remembers the data objects returned to \p _client_username by a listing, replacing the
+		/// previous listing of the client.
+		auto remember_listing(const std::string& _client_username, std::vector<listed_object> _objects) -> void;
+
+		/// Called for every GetObject. Starts prefetching the objects which follow \p _path in the
+		/// listing of \p _client_username once the client is reading the listing in order.
+		auto on_get(const std::string& _client_username, const std::string& _path) -> void;
+
+		/// Writes the number of objects prefetched, requested by a client and failed to the log.
+		auto log_report() const -> void;
+
+	  private:
+		struct listing
+		{
+			std::vector<listed_object> objects;
+			std::unordered_map<std::string, std::size_t> positions;
+			std::vector<bool> prefetched;
+			std::chrono::steady_clock::time_point last_used;
+
+			/// The number of GetObject requests for objects of the listing.
+			std::size_t gets = 0;
+
+			/// One past the furthest object fetched by the client.
+			std::size_t furthest = 0;
+
+			/// Objects before this position have been considered for prefetching.
+			std::size_t scheduled = 0;
+		}; // struct listing
+
+		// Takes _memory bytes of the memory budget and _size bytes of the bandwidth budget. Must be
+		// called with mutex_ held.
+		auto reserve(std::uint64_t _memory, std::uint64_t _size) -> bool;
+
+		auto forget_expired_listings() -> void;
+
+		auto fetch(const std::string& _client_username, const listed_object& _object) -> bool;
+
+		const options options_;
+
+		mutable std::mutex mutex_;
+		std::unordered_map<std::string, listing> listings_;
+		std::uint64_t bytes_in_flight_ = 0;
+
+		// A token bucket refilled at max_bytes_per_second. It may go negative, which delays the next
+		// prefetch until the debt is paid off.
+		double tokens_ = 0;
+		std::chrono::steady_clock::time_point refilled_;
+
+		std::atomic<std::uint64_t> prefetched_{0};
+		std::atomic<std::uint64_t> used_{0};
+		std::atomic<std::uint64_t> failed_{0};
+
+		boost::asio::thread_pool workers_;
+	}; // class prefetcher
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_PREFETCH_HPP
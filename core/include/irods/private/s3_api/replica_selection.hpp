@@ -0,0 +1,68 @@
+#ifndef IRODS_S3_API_REPLICA_SELECTION_HPP
+#define IRODS_S3_API_REPLICA_SELECTION_HPP
+
+#include <irods/client_connection.hpp>
+#include <irods/filesystem/path.hpp>
+#include <irods/rcConnect.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace irods::s3
+{
+	/// A good replica of a data object and where it is stored.
+	struct replica_location
+	{
+		int replica_number = 0;
+
+		/// The leaf resource holding the replica.
+		std::string resource;
+
+		/// The host of the leaf resource.
+		std::string host;
+	}; // struct replica_location
+
+	/// Returns the good replicas of a data object in the order GetObject should try them under
+	/// irods_client.replica_selection.policy.
+	///
+	/// \throws irods::exception If the query fails.
+	auto select_replicas(RcComm& _conn, const irods::experimental::filesystem::path& _path)
+		-> std::vector<replica_location>;
+
+	/// Creates a dedicated connection for reading the first of \p _replicas.
+	///
+	/// When data redirection is enabled, the connection is opened directly against the host of the
+	/// replica. If \p _replicas is empty or the host cannot be reached, this behaves like
+	/// get_data_connection().
+	///
+	/// \throws irods::exception If the connection cannot be authenticated.
+	auto get_replica_connection(
+		const std::string& _client_username,
+		const irods::experimental::filesystem::path& _path,
+		const std::vector<replica_location>& _replicas) -> std::shared_ptr<irods::experimental::client_connection>;
+
+	/// Counts a read from a resource as in progress for the lifetime of the object.
+	///
+	/// The fastest and least_loaded policies rank resources by what the trackers recorded.
+	class replica_read_tracker
+	{
+	  public:
+		explicit replica_read_tracker(std::string _resource);
+		~replica_read_tracker();
+
+		replica_read_tracker(const replica_read_tracker&) = delete;
+		auto operator=(const replica_read_tracker&) -> replica_read_tracker& = delete;
+
+		auto resource() const noexcept -> const std::string&;
+
+		/// Records how long the first read from the resource took to return its first bytes.
+		auto record_first_byte_latency(std::chrono::steady_clock::duration _latency) -> void;
+
+	  private:
+		std::string resource_;
+	}; // class replica_read_tracker
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_REPLICA_SELECTION_HPP
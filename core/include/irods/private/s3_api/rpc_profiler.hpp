@@ -0,0 +1,135 @@
+#ifndef IRODS_S3_API_RPC_PROFILER_HPP
+#define IRODS_S3_API_RPC_PROFILER_HPP
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace irods::s3::rpc_profiler
+{
+	/// The number of calls made to a single iRODS operation and the time spent in them.
+	struct api_stats
+	{
+		std::uint64_t calls = 0;
+		std::uint64_t errors = 0;
+		std::chrono::nanoseconds total{};
+		std::chrono::nanoseconds max{};
+	}; // struct api_stats
+
+	/// Counts and times the iRODS API calls made while serving a single S3 request.
+	///
+	/// When the last reference to a profile is dropped, its breakdown is written to the log and
+	/// merged into the process-wide totals returned by snapshot().
+	class request_profile
+	{
+	  public:
+		explicit request_profile(std::string _operation);
+		~request_profile();
+
+		request_profile(const request_profile&) = delete;
+		auto operator=(const request_profile&) -> request_profile& = delete;
+
+		auto operation() const noexcept -> const std::string&;
+
+		auto record(const std::string& _name, std::chrono::nanoseconds _elapsed, bool _failed) -> void;
+
+		/// Returns the statistics recorded so far, keyed by the name of the iRODS operation.
+		auto stats() const -> std::map<std::string, api_stats>;
+
+	  private:
+		std::string operation_;
+		std::chrono::steady_clock::time_point start_;
+		mutable std::mutex mutex_;
+		std::map<std::string, api_stats> stats_;
+	}; // class request_profile
+
+	/// Makes a profile the current profile of the calling thread for the lifetime of the object.
+	///
+	/// Every call timed by the thread while the scope is alive is recorded in the profile.
+	/// The previous profile is restored when the scope ends.
+	class scope
+	{
+	  public:
+		/// Starts a new profile for the S3 operation \p _operation if profiling is enabled.
+		explicit scope(std::string _operation);
+
+		/// Continues an existing profile (e.g. in a background task scheduled by the request).
+		explicit scope(std::shared_ptr<request_profile> _profile) noexcept;
+
+		~scope();
+
+		scope(const scope&) = delete;
+		auto operator=(const scope&) -> scope& = delete;
+
+	  private:
+		std::shared_ptr<request_profile> previous_;
+	}; // class scope
+
+	/// Returns the profile of the request being served by the calling thread, or nullptr.
+	auto current() noexcept -> std::shared_ptr<request_profile>;
+
+	auto set_enabled(bool _enabled) noexcept -> void;
+	auto is_enabled() noexcept -> bool;
+
+	/// Times a single iRODS operation made by the S3 API and records it in the current profile of
+	/// the calling thread when the object is destroyed. Does nothing if there is no current profile.
+	///
+	/// The operation is recorded as failed if the object is destroyed by an exception. \p _name must
+	/// outlive the object. By convention it is the name of the iRODS API the operation maps to
+	/// (e.g. "GEN_QUERY").
+	class timer
+	{
+	  public:
+		explicit timer(const char* _name) noexcept;
+		~timer();
+
+		timer(const timer&) = delete;
+		auto operator=(const timer&) -> timer& = delete;
+
+		/// Records the operation now instead of when the object is destroyed. Does nothing if the
+		/// operation was already recorded.
+		auto stop(bool _failed = false) noexcept -> void;
+
+	  private:
+		std::shared_ptr<request_profile> profile_;
+		const char* name_;
+		std::chrono::steady_clock::time_point start_;
+		int uncaught_exceptions_;
+	}; // class timer
+
+	/// Invokes \p _func and records it as the iRODS operation \p _name.
+	///
+	/// Following the convention of the iRODS C API, a negative integer returned by \p _func is
+	/// recorded as a failure.
+	template <typename Function>
+	auto timed(const char* _name, Function&& _func) -> decltype(auto)
+	{
+		using result_type = std::invoke_result_t<Function>;
+
+		timer t{_name};
+
+		if constexpr (std::is_integral_v<result_type> && !std::is_same_v<result_type, bool>) {
+			const auto ec = std::forward<Function>(_func)();
+			t.stop(ec < 0);
+			return ec;
+		}
+		else {
+			return std::forward<Function>(_func)();
+		}
+	} // timed
+
+	/// Returns the process-wide totals for each S3 operation and iRODS operation as JSON.
+	auto snapshot() -> nlohmann::json;
+
+	/// Writes the process-wide totals to the log.
+	auto log_report() -> void;
+} // namespace irods::s3::rpc_profiler
+
+#endif // IRODS_S3_API_RPC_PROFILER_HPP
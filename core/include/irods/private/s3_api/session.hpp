@@ -6,9 +6,16 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
 
+namespace irods::s3
+{
+	class zerocopy_writer;
+} // namespace irods::s3
+
 namespace irods::http
 {
 	class session : public std::enable_shared_from_this<session>
@@ -20,6 +27,8 @@ namespace irods::http
 			int _max_body_size,
 			int _timeout_in_seconds);
 
+		~session();
+
 		auto ip() const -> std::string;
 
 		auto run() -> void;
@@ -37,6 +46,28 @@ namespace irods::http
 			return stream_;
 		} // stream
 
+		// The time a single read or write on the stream may take. Transfers set it with
+		// stream().expires_after() before every operation so that it bounds how long a client may
+		// stall rather than how long the whole transfer may take.
+		auto timeout() const -> std::chrono::seconds
+		{
+			return std::chrono::seconds(timeout_in_secs_);
+		} // timeout
+
+		// Calls _on_disconnect on an I/O thread as soon as the client closes the connection, or the
+		// connection fails or times out, while a response is being produced. Pending operations on
+		// the stream are cancelled first.
+		//
+		// Meant for responses which do not read from the client, so that a departed client is
+		// noticed while the server is waiting on iRODS rather than on the next write. The watch
+		// ends without calling _on_disconnect if the client sends more data or the session ends.
+		auto watch_for_disconnect(std::function<void()> _on_disconnect) -> void;
+
+		// The writer which sends response bodies on this session with MSG_ZEROCOPY, or nullptr if
+		// s3_server.zerocopy is disabled or the kernel does not support it. The writer is created on
+		// first use and shared by all responses of the session.
+		auto zerocopy_writer() -> std::shared_ptr<irods::s3::zerocopy_writer>;
+
 		template <bool isRequest, class Body, class Fields>
 		auto send(boost::beast::http::message<isRequest, Body, Fields>&& msg) -> void
 		{
@@ -70,7 +101,18 @@ namespace irods::http
 		const request_handler_map_type* req_handlers_;
 		const int max_body_size_;
 		const int timeout_in_secs_;
+		std::optional<std::shared_ptr<irods::s3::zerocopy_writer>> zerocopy_writer_;
 	}; // class session
+
+	// Returns true if _ec means that the client is gone, in which case there is nobody to send a
+	// response to.
+	inline auto is_disconnect(const boost::beast::error_code& _ec) -> bool
+	{
+		return _ec == boost::beast::http::error::end_of_stream || _ec == boost::beast::http::error::partial_message ||
+		       _ec == boost::beast::error::timeout || _ec == boost::asio::error::eof ||
+		       _ec == boost::asio::error::connection_reset || _ec == boost::asio::error::broken_pipe ||
+		       _ec == boost::asio::error::operation_aborted;
+	} // is_disconnect
 } // namespace irods::http
 
 #endif // IRODS_S3_API_SESSION_HPP
@@ -0,0 +1,97 @@
+#ifndef IRODS_S3_API_SINGLEFLIGHT_HPP
+#define IRODS_S3_API_SINGLEFLIGHT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace irods::s3
+{
+	/// Lets concurrent callers asking for the same key share the result of a single call.
+	///
+	/// The first caller for a key runs the function. Callers arriving while it runs wait for its
+	/// result, or its exception, instead of running the function themselves. Once the call
+	/// completes, the next caller starts a new one, so results are never reused after the fact.
+	template <typename T>
+	class singleflight
+	{
+	  public:
+		template <typename Function>
+		auto run(const std::string& _key, Function&& _function) -> T
+		{
+			return run(_key, std::forward<Function>(_function), [](const std::exception_ptr&) { return true; });
+		} // run
+
+		/// Like run(_key, _function), except that an exception for which \p _shareable returns false
+		/// is only thrown to the caller which ran the function. The callers waiting for its result
+		/// run the function themselves instead, e.g. because the exception concerns the connection
+		/// of the first caller only.
+		template <typename Function, typename Predicate>
+		auto run(const std::string& _key, Function&& _function, Predicate&& _shareable) -> T
+		{
+			std::promise<T> promise;
+			std::shared_future<T> result;
+
+			{
+				std::lock_guard lk{mutex_};
+				if (const auto iter = calls_.find(_key); iter != std::end(calls_)) {
+					result = iter->second;
+				}
+				else {
+					calls_.emplace(_key, promise.get_future().share());
+				}
+			}
+
+			if (result.valid()) {
+				try {
+					T value = result.get();
+					++shared_calls_;
+					return value;
+				}
+				catch (...) {
+					if (_shareable(std::current_exception())) {
+						throw;
+					}
+				}
+
+				return std::forward<Function>(_function)();
+			}
+
+			try {
+				T value = std::forward<Function>(_function)();
+				forget(_key);
+				promise.set_value(value);
+				return value;
+			}
+			catch (...) {
+				forget(_key);
+				promise.set_exception(std::current_exception());
+				throw;
+			}
+		} // run
+
+		/// The number of callers which received the result of another caller's call.
+		auto shared_calls() const noexcept -> std::uint64_t
+		{
+			return shared_calls_.load();
+		} // shared_calls
+
+	  private:
+		auto forget(const std::string& _key) -> void
+		{
+			std::lock_guard lk{mutex_};
+			calls_.erase(_key);
+		} // forget
+
+		std::mutex mutex_;
+		std::unordered_map<std::string, std::shared_future<T>> calls_;
+		std::atomic<std::uint64_t> shared_calls_{0};
+	}; // class singleflight
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_SINGLEFLIGHT_HPP
@@ -0,0 +1,35 @@
+#ifndef IRODS_S3_API_SMALL_OBJECT_HPP
+#define IRODS_S3_API_SMALL_OBJECT_HPP
+
+#include <irods/filesystem/path.hpp>
+#include <irods/rcConnect.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace irods::s3
+{
+	/// Reads a whole data object of \p _size bytes with a single data-transfer RPC.
+	///
+	/// This replaces the open, seek, read and close calls of a stream for objects no larger than
+	/// irods_client.get_object_small_object_threshold_in_bytes. The bytes are copied into a buffer
+	/// taken from a pool which the buffer returns to once the last reference to it is dropped.
+	///
+	/// \param _conn A connection acting on behalf of the client.
+	/// \param _path The logical path of the data object.
+	/// \param _size The size of the data object according to the catalog.
+	/// \param _replica_number The replica to read. If not set, iRODS picks a replica in
+	/// irods_client.resource.
+	///
+	/// \returns The contents of the object, or nullptr if the object could not be read in one RPC,
+	/// e.g. because its size no longer matches \p _size. The caller should fall back to a stream.
+	auto read_small_object(
+		RcComm& _conn,
+		const irods::experimental::filesystem::path& _path,
+		std::uint64_t _size,
+		std::optional<int> _replica_number) -> std::shared_ptr<std::vector<char>>;
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_SMALL_OBJECT_HPP
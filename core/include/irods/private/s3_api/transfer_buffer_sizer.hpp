@@ -0,0 +1,57 @@
+#ifndef IRODS_S3_API_TRANSFER_BUFFER_SIZER_HPP
+#define IRODS_S3_API_TRANSFER_BUFFER_SIZER_HPP
+
+#include <chrono>
+#include <cstdint>
+
+namespace irods::s3
+{
+	/// Chooses the size of the buffers used by a single transfer.
+	///
+	/// A transfer starts with small buffers and doubles their size while doing so improves the
+	/// observed throughput, up to irods_client.max_transfer_buffer_size_in_bytes. Once a larger
+	/// buffer stops paying off, the size is kept for the rest of the transfer. Buffers never grow
+	/// beyond the length of the transfer.
+	///
+	/// The bytes held by the buffers of all transfers are counted against
+	/// irods_client.transfer_buffer_budget_in_bytes. The starting size is always granted, but a
+	/// transfer only grows its buffers while the budget has room, so many concurrent transfers
+	/// settle on smaller buffers than a single one.
+	///
+	/// Not thread-safe. Each transfer owns its own instance.
+	class transfer_buffer_sizer
+	{
+	  public:
+		/// \param _initial_size The starting buffer size, e.g. irods_client.get_object_buffer_size_in_bytes.
+		/// \param _expected_bytes The length of the transfer, or 0 if it is not known in advance.
+		/// \param _buffer_count The number of buffers of the chosen size the transfer holds at once.
+		transfer_buffer_sizer(
+			std::uint64_t _initial_size,
+			std::uint64_t _expected_bytes,
+			std::uint64_t _buffer_count = 1);
+
+		~transfer_buffer_sizer();
+
+		transfer_buffer_sizer(const transfer_buffer_sizer&) = delete;
+		auto operator=(const transfer_buffer_sizer&) -> transfer_buffer_sizer& = delete;
+
+		/// The size to use for the next buffer.
+		auto size() const noexcept -> std::uint64_t;
+
+		/// Records that a buffer of \p _bytes took \p _elapsed to move and returns the size to use
+		/// for the next buffer. Partially filled buffers are ignored since their timing says
+		/// little about the buffer size.
+		auto record(std::uint64_t _bytes, std::chrono::steady_clock::duration _elapsed) -> std::uint64_t;
+
+	  private:
+		std::uint64_t size_;
+		std::uint64_t maximum_;
+		std::uint64_t buffer_count_;
+		std::uint64_t reserved_;
+		double best_rate_ = 0;
+		int misses_ = 0;
+		bool settled_ = false;
+	}; // class transfer_buffer_sizer
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_TRANSFER_BUFFER_SIZER_HPP
@@ -0,0 +1,53 @@
+#ifndef IRODS_S3_API_VAULT_READ_HPP
+#define IRODS_S3_API_VAULT_READ_HPP
+
+#include "irods/private/s3_api/disk_cache.hpp"
+
+#include <irods/filesystem/path.hpp>
+#include <irods/rcConnect.h>
+
+#include <cstdint>
+#include <optional>
+
+namespace irods::s3::vault_reads
+{
+	struct statistics
+	{
+		std::uint64_t lookups = 0;
+		std::uint64_t opened = 0;
+		std::uint64_t no_local_replica = 0;
+		std::uint64_t failed_opens = 0;
+		std::uint64_t bytes_served = 0;
+	}; // struct statistics
+
+	/// Opens a good replica of \p _path directly in the vault of a unixfilesystem resource on this
+	/// host, so that it can be sent with sendfile(2) instead of being read through iRODS.
+	///
+	/// A resource is on this host if its location is listed in
+	/// irods_client.replica_selection.local_hosts, which always includes the host name of this
+	/// server. The file is read with the privileges of this server, so the caller must have made
+	/// sure that the user may read the object, i.e. that object_stat::accessible is set.
+	///
+	/// \param _conn A connection acting on behalf of the client.
+	/// \param _path The logical path of the data object.
+	/// \param _size The size of the data object according to the catalog. Vault files of another
+	///              size are not used.
+	///
+	/// \returns The open vault file, or an empty std::optional if no replica can be read from a
+	///          local vault. The caller should read the object through iRODS instead.
+	auto open(
+		RcComm& _conn,
+		const irods::experimental::filesystem::path& _path,
+		std::uint64_t _size) -> std::optional<disk_cache::file>;
+
+	/// Records the number of bytes sent to a client from a vault file.
+	auto record_bytes_served(std::uint64_t _bytes) noexcept -> void;
+
+	auto stats() -> statistics;
+
+	/// Writes how many GetObject requests were served from a local vault, and why the others were
+	/// not, to the log.
+	auto log_report() -> void;
+} // namespace irods::s3::vault_reads
+
+#endif // IRODS_S3_API_VAULT_READ_HPP
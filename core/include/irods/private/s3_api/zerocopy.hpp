@@ -0,0 +1,149 @@
+#ifndef IRODS_S3_API_ZEROCOPY_HPP
+#define IRODS_S3_API_ZEROCOPY_HPP
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace irods::s3
+{
+	/// Sends response bodies to a client socket with MSG_ZEROCOPY.
+	///
+	/// The kernel sends the pages of the caller's buffer instead of copying them into the socket
+	/// buffer. The buffer must stay untouched until the kernel reports on the error queue of the
+	/// socket that it no longer references the pages, so every write comes with a callback which
+	/// runs once the buffer may be reused.
+	///
+	/// Writes smaller than the minimum write size are copied, since pinning the pages of a few KiB
+	/// costs more than copying them. Writes are copied as well while the kernel cannot allocate the
+	/// notifications (ENOBUFS).
+	///
+	/// The kernel numbers the zero-copy sends of a socket, so a session uses one writer for all of
+	/// its responses. Only one write may be in progress at a time.
+	///
+	/// If the kernel does not release the sends within the timeout of the latest write, or a write
+	/// fails, the writer resets the connection and releases every write. A reset makes the kernel
+	/// drop the unacknowledged bytes, which it would otherwise send again from the released buffers.
+	/// If the socket has already been closed, the buffers are kept for the life of the process
+	/// instead.
+	class zerocopy_writer : public std::enable_shared_from_this<zerocopy_writer>
+	{
+	  public:
+		/// Enables MSG_ZEROCOPY on \p _socket.
+		///
+		/// \param _socket The client socket. It must outlive every write.
+		/// \param _min_write_size Writes smaller than this are copied.
+		///
+		/// \returns The writer, or nullptr if the kernel does not support MSG_ZEROCOPY.
+		static auto create(boost::asio::ip::tcp::socket& _socket, std::size_t _min_write_size)
+			-> std::shared_ptr<zerocopy_writer>;
+
+		zerocopy_writer(boost::asio::ip::tcp::socket& _socket, std::size_t _min_write_size);
+
+		zerocopy_writer(const zerocopy_writer&) = delete;
+		auto operator=(const zerocopy_writer&) -> zerocopy_writer& = delete;
+
+		/// Sends \p _size bytes at \p _data.
+		///
+		/// \param _timeout How long the socket may stay full before the write fails.
+		/// \param _on_sent Called once the kernel has taken every byte, or the write has failed.
+		/// \param _on_released Called once the kernel no longer references the bytes, and never
+		///                     before \p _on_sent. It is called when the write fails, too.
+		auto write(
+			const char* _data,
+			std::size_t _size,
+			std::chrono::seconds _timeout,
+			std::function<void(boost::system::error_code)> _on_sent,
+			std::function<void()> _on_released) -> void;
+
+		/// Called by the session before it closes the socket. Releases every write as above. The
+		/// writer does not use the socket afterwards.
+		auto detach() -> void;
+
+	  private:
+		struct pending_write
+		{
+			// The number of zero-copy sends of the write the kernel has not released yet.
+			std::size_t unreleased = 0;
+
+			// Set once the kernel has taken every byte of the write.
+			bool sent = false;
+
+			std::function<void()> on_released;
+		}; // struct pending_write
+
+		// Sends as much of the current write as the socket takes, then waits for the socket to become
+		// writable again.
+		auto send() -> void;
+
+		auto finish_write(boost::system::error_code _ec) -> void;
+
+		// Waits for notifications on the error queue while zero-copy sends are unreleased. Must be
+		// called with mutex_ held.
+		auto wait_for_notifications() -> void;
+
+		// Reads the notifications on the error queue and runs the callbacks of the writes which were
+		// released.
+		auto read_notifications() -> void;
+
+		// Called once the kernel has not released the sends in time.
+		auto on_notification_timeout() -> void;
+
+		// Runs the callbacks of all unreleased writes, e.g. because the socket has failed. Resets
+		// the connection first if the kernel still references any of their bytes.
+		auto release_all() -> void;
+
+		// Closes the socket with a reset. Returns false if the socket is already closed. Must be
+		// called with mutex_ held.
+		auto reset_connection() -> bool;
+
+		boost::asio::ip::tcp::socket& socket_;
+		const std::size_t min_write_size_;
+		boost::asio::steady_timer timer_;
+
+		// The write in progress.
+		const char* data_ = nullptr;
+		std::size_t remaining_ = 0;
+		std::chrono::seconds timeout_{0};
+		std::function<void(boost::system::error_code)> on_sent_;
+		std::uint64_t write_id_ = 0;
+
+		// Set once the kernel has refused a zero-copy send of the write in progress.
+		bool copy_ = false;
+
+		std::mutex mutex_;
+
+		// The number the kernel gives to the next zero-copy send on the socket.
+		std::uint32_t next_sequence_ = 0;
+
+		std::unordered_map<std::uint32_t, std::uint64_t> write_of_sequence_;
+		std::unordered_map<std::uint64_t, pending_write> pending_;
+		bool waiting_ = false;
+
+		// Set once the session no longer lets the writer use the socket.
+		bool detached_ = false;
+
+		// Bounds the wait for notifications. It is restarted whenever notifications arrive.
+		boost::asio::steady_timer notification_timer_;
+	}; // class zerocopy_writer
+
+	namespace zerocopy
+	{
+		/// Counts bytes of GetObject bodies sent to clients. \p _zerocopy tells whether they were
+		/// sent with MSG_ZEROCOPY.
+		auto record_bytes_sent(std::uint64_t _bytes, bool _zerocopy) -> void;
+
+		/// Writes the number of body bytes sent, the share sent with MSG_ZEROCOPY and the CPU time
+		/// of the process per GB sent since the last report to the log.
+		auto log_report() -> void;
+	} // namespace zerocopy
+} // namespace irods::s3
+
+#endif // IRODS_S3_API_ZEROCOPY_HPP
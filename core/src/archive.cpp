@@ -0,0 +1,132 @@
+#include "irods/private/s3_api/archive.hpp"
+#include "irods/private/s3_api/common.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+
+#include <irods/dataObjInpOut.h>
+#include <irods/dataObjRepl.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/rcMisc.h>
+#include <irods/rodsKeyWdDef.h>
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	auto is_archive_resource(const std::string& _resource) -> bool
+	{
+		const auto& archive_resources = irods::s3::get_archive_resources();
+		return std::find(std::begin(archive_resources), std::end(archive_resources), _resource) !=
+		       std::end(archive_resources);
+	} // is_archive_resource
+} // anonymous namespace
+
+auto irods::s3::is_archived(const object_stat& _stat) -> bool
+{
+	return std::any_of(std::begin(_stat.good_resources), std::end(_stat.good_resources), is_archive_resource);
+} // is_archived
+
+auto irods::s3::needs_restore(const object_stat& _stat) -> bool
+{
+	return !_stat.good_resources.empty() &&
+	       std::all_of(std::begin(_stat.good_resources), std::end(_stat.good_resources), is_archive_resource);
+} // needs_restore
+
+irods::s3::restore_queue::restore_queue(std::size_t _thread_count)
+	: workers_{std::max<std::size_t>(_thread_count, 1)}
+{
+} // constructor
+
+irods::s3::restore_queue::~restore_queue()
+{
+	workers_.stop();
+	workers_.join();
+} // destructor
+
+auto irods::s3::restore_queue::restore(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path) -> bool
+{
+	{
+		std::lock_guard lk{mutex_};
+		if (!ongoing_.insert(_path.string()).second) {
+			return false;
+		}
+	}
+
+	++queued_;
+	logging::info("{}: Queued [{}] to be staged to [{}].", __func__, _path.c_str(), get_archive_stage_resource());
+
+	boost::asio::post(workers_, [this, _client_username, _path] {
+		stage(_client_username, _path);
+
+		std::lock_guard lk{mutex_};
+		ongoing_.erase(_path.string());
+	});
+
+	return true;
+} // restore
+
+auto irods::s3::restore_queue::is_ongoing(const std::string& _path) const -> bool
+{
+	std::lock_guard lk{mutex_};
+	return ongoing_.contains(_path);
+} // is_ongoing
+
+auto irods::s3::restore_queue::log_report() const -> void
+{
+	std::size_t ongoing = 0;
+	{
+		std::lock_guard lk{mutex_};
+		ongoing = ongoing_.size();
+	}
+
+	logging::info(
+		"{}: [{}] restores queued, [{}] completed, [{}] failed, [{}] in progress.",
+		__func__,
+		queued_.load(),
+		completed_.load(),
+		failed_.load(),
+		ongoing);
+} // log_report
+
+auto irods::s3::restore_queue::stage(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path) -> void
+{
+	// Restores are not part of any request, so they are profiled on their own.
+	const irods::s3::rpc_profiler::scope profile{"RestoreObject (staging)"};
+
+	try {
+		auto conn = irods::s3::get_dedicated_connection(_client_username);
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_options{[&input] { clearKeyVal(&input.condInput); }};
+		irods::strncpy_null_terminated(input.objPath, _path.c_str());
+
+		if (const auto resource = get_archive_stage_resource(); !resource.empty()) {
+			addKeyVal(&input.condInput, DEST_RESC_NAME_KW, resource.c_str());
+		}
+
+		const auto ec = irods::s3::rpc_profiler::timed(
+			"DATA_OBJ_REPL", [&] { return rcDataObjRepl(static_cast<RcComm*>(*conn), &input); });
+		if (ec < 0) {
+			logging::error("{}: Could not stage [{}]. ec=[{}]", __func__, _path.c_str(), ec);
+			++failed_;
+			return;
+		}
+
+		logging::info("{}: Staged [{}].", __func__, _path.c_str());
+		++completed_;
+	}
+	catch (const std::exception& e) {
+		logging::error("{}: Could not stage [{}]: {}", __func__, _path.c_str(), e.what());
+		++failed_;
+	}
+} // stage
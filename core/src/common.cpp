@@ -4,6 +4,7 @@
 #include "irods/private/s3_api/globals.hpp"
 #include "irods/private/s3_api/log.hpp"
 #include "irods/private/s3_api/process_stash.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/session.hpp"
 #include "irods/private/s3_api/version.hpp"
 
@@ -23,6 +24,8 @@
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
+
+#include <chrono>
 #include <string>
 
 namespace irods::http
@@ -438,6 +441,8 @@ namespace irods
 			static auto rodsadmin_password =
 				irods_client_config.at(json_pointer{"/proxy_admin_account/password"}).get_ref<const std::string&>();
 
+			irods::s3::rpc_profiler::timer timer{"CONNECT"};
+
 			irods::experimental::client_connection conn{
 				irods::experimental::defer_authentication,
 				irods_client_config.at("host").get_ref<const std::string&>(),
@@ -448,6 +453,7 @@ namespace irods
 			auto* conn_ptr = static_cast<RcComm*>(conn);
 
 			if (const auto ec = clientLoginWithPassword(conn_ptr, rodsadmin_password.data()); ec < 0) {
+				timer.stop(true);
 				http::logging::error("{}: clientLoginWithPassword error: {}", __func__, ec);
 				THROW(SYS_INTERNAL_ERR, "clientLoginWithPassword error.");
 			}
@@ -455,10 +461,6 @@ namespace irods
 			return irods::http::connection_facade{std::move(conn)};
 		}
 
-		auto conn = irods::http::globals::connection_pool().get_connection();
-
-		http::logging::trace("{}: Changing identity associated with connection to [{}].", __func__, _username);
-
 		SwitchUserInput input{};
 
 		irods::at_scope_exit clear_options{[&input] { clearKeyVal(&input.options); }};
@@ -467,16 +469,60 @@ namespace irods
 		irods::strncpy_null_terminated(input.zone, zone.c_str());
 		addKeyVal(&input.options, KW_CLOSE_OPEN_REPLICAS, "");
 
-		if (const auto ec = rc_switch_user(static_cast<RcComm*>(conn), &input); ec < 0) {
-			http::logging::error("{}: rc_switch_user error: {}", __func__, ec);
-			THROW(ec, "rc_switch_user error.");
-		}
+		// Switching users is the first call made on a pooled connection, so this is where a stale
+		// connection is usually detected. Switching users is idempotent, so it is retried once on
+		// a replacement connection.
+		for (bool retried = false;; retried = true) {
+			irods::http::connection_facade conn{irods::http::globals::connection_pool().get_connection()};
+
+			http::logging::trace("{}: Changing identity associated with connection to [{}].", __func__, _username);
+
+			const auto ec = irods::s3::rpc_profiler::timed(
+				"SWITCH_USER", [&] { return rc_switch_user(static_cast<RcComm*>(conn), &input); });
+			if (ec < 0) {
+				if (!retried && is_connection_error(ec)) {
+					discard_connection_before_retry(conn, ec);
+					continue;
+				}
+
+				http::logging::error("{}: rc_switch_user error: {}", __func__, ec);
+				THROW(ec, "rc_switch_user error.");
+			}
 
-		http::logging::trace("{}: Successfully changed identity associated with connection to [{}].", __func__, _username);
+			http::logging::trace(
+				"{}: Successfully changed identity associated with connection to [{}].", __func__, _username);
 
-		return irods::http::connection_facade{std::move(conn)};
+			return conn;
+		}
 	} // get_connection
 
+	auto is_connection_error(int _ec) noexcept -> bool
+	{
+		// Socket errors are reported with the system errno folded into the error code.
+		switch (getIrodsErrno(_ec)) {
+			case SYS_HEADER_READ_LEN_ERR:
+			case SYS_HEADER_WRITE_LEN_ERR:
+			case SYS_SOCK_READ_TIMEDOUT:
+			case SYS_SOCK_READ_ERR:
+			case SYS_SOCK_OPEN_ERR:
+			case SYS_SOCK_CONNECT_ERR:
+			case USER_SOCK_OPEN_ERR:
+			case USER_SOCK_CONNECT_ERR:
+				return true;
+
+			default:
+				return false;
+		}
+	} // is_connection_error
+
+	auto discard_connection_before_retry(irods::http::connection_facade& _conn, int _ec) -> void
+	{
+		http::logging::warn("{}: Connection to iRODS server is broken [error_code={}]. Retrying once.", __func__, _ec);
+
+		// The retry runs right away. It gets a new connection, so waiting would only hold the thread.
+		_conn.discard();
+	} // discard_connection_before_retry
+
 	auto fail(boost::beast::error_code ec, char const* what) -> void
 	{
 		http::logging::error("{}: {}: {}", __func__, what, ec.message());
@@ -489,6 +535,6 @@ namespace irods
 		input.arg2 = const_cast<char*>(_ticket.c_str()); // NOLINT(cppcoreguidelines-pro-type-const-cast)
 		input.arg3 = const_cast<char*>(""); // NOLINT(cppcoreguidelines-pro-type-const-cast)
 
-		return rcTicketAdmin(&_comm, &input);
+		return irods::s3::rpc_profiler::timed("TICKET_ADMIN", [&] { return rcTicketAdmin(&_comm, &input); });
 	} // enable_ticket
 } // namespace irods
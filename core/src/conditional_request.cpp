@@ -0,0 +1,138 @@
+#include "irods/private/s3_api/conditional_request.hpp"
+#include "irods/private/s3_api/hmac.hpp"
+
+#include <boost/algorithm/string.hpp>
+
+#include <fmt/format.h>
+
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	// Parses an HTTP date such as "Sun, 06 Nov 1994 08:49:37 GMT". HTTP dates are always in UTC,
+	// like Last-Modified (see convert_time_t_to_str).
+	auto parse_http_date(std::string_view _value) -> std::optional<std::time_t>
+	{
+		std::tm tm{};
+		std::istringstream in{std::string{_value}};
+		in >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+
+		if (in.fail()) {
+			return std::nullopt;
+		}
+
+		const auto t = ::timegm(&tm);
+		if (t == static_cast<std::time_t>(-1)) {
+			return std::nullopt;
+		}
+
+		return t;
+	} // parse_http_date
+
+	// Returns true if the ETag list of an If-Match or If-None-Match header contains _etag.
+	//
+	// Weak validators are compared by their opaque tag, which is all that is required for the
+	// weak comparison used by If-None-Match. Our ETags are never weak, so If-Match is unaffected.
+	auto etag_list_matches(std::string_view _value, const std::string& _etag) -> bool
+	{
+		std::vector<std::string> tags;
+		boost::split(tags, _value, boost::is_any_of(","));
+
+		for (auto& tag : tags) {
+			boost::trim(tag);
+
+			if (tag == "*") {
+				return true;
+			}
+
+			if (tag.starts_with("W/")) {
+				tag.erase(0, 2);
+			}
+
+			if (tag == _etag) {
+				return true;
+			}
+		}
+
+		return false;
+	} // etag_list_matches
+
+	auto find(const boost::beast::http::fields& _headers, std::string_view _name) -> std::optional<std::string_view>
+	{
+		if (auto iter = _headers.find(_name); iter != _headers.end()) {
+			return std::string_view{iter->value().data(), iter->value().size()};
+		}
+
+		return std::nullopt;
+	} // find
+} // anonymous namespace
+
+auto irods::s3::make_etag(
+	const irods::experimental::filesystem::path& _path,
+	std::uintmax_t _size,
+	std::time_t _mtime,
+	std::string_view _checksum) -> std::string
+{
+	// Clients often expect the 32 hex digits of an MD5 digest, so the hash is cut to 128 bits.
+	constexpr std::size_t etag_length = 32;
+
+	const auto key = fmt::format("{}\n{}\n{}\n{}", _path.c_str(), _size, _mtime, _checksum);
+	const auto digest = irods::s3::authentication::hex_encode(irods::s3::authentication::hash_sha_256(key));
+	return fmt::format("\"{}\"", std::string_view{digest}.substr(0, etag_length));
+} // make_etag
+
+auto irods::s3::evaluate_preconditions(
+	const boost::beast::http::fields& _headers,
+	const std::string& _etag,
+	std::time_t _mtime) -> precondition_result
+{
+	const auto if_match = find(_headers, "If-Match");
+
+	if (if_match) {
+		if (!etag_list_matches(*if_match, _etag)) {
+			return precondition_result::precondition_failed;
+		}
+	}
+	else if (const auto value = find(_headers, "If-Unmodified-Since"); value) {
+		if (const auto since = parse_http_date(*value); since && _mtime > *since) {
+			return precondition_result::precondition_failed;
+		}
+	}
+
+	if (const auto if_none_match = find(_headers, "If-None-Match"); if_none_match) {
+		if (etag_list_matches(*if_none_match, _etag)) {
+			return precondition_result::not_modified;
+		}
+	}
+	else if (const auto value = find(_headers, "If-Modified-Since"); value) {
+		if (const auto since = parse_http_date(*value); since && _mtime <= *since) {
+			return precondition_result::not_modified;
+		}
+	}
+
+	return precondition_result::proceed;
+} // evaluate_preconditions
+
+auto irods::s3::range_is_current(
+	const boost::beast::http::fields& _headers,
+	const std::string& _etag,
+	std::time_t _mtime) -> bool
+{
+	const auto if_range = find(_headers, "If-Range");
+
+	if (!if_range) {
+		return true;
+	}
+
+	// If-Range holds either an ETag or a date. Only a strong ETag or an exact date match counts.
+	if (if_range->starts_with("\"")) {
+		return *if_range == _etag;
+	}
+
+	const auto date = parse_http_date(*if_range);
+	return date && *date == _mtime;
+} // range_is_current
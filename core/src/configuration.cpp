@@ -1,5 +1,6 @@
 #include <optional>
 #include <nlohmann/json.hpp>
+#include <boost/asio/ip/host_name.hpp>
 
 #include "irods/private/s3_api/configuration.hpp"
 #include "irods/private/s3_api/globals.hpp"
@@ -9,7 +10,49 @@ namespace
 	std::optional<std::string> resource;
 	std::optional<uint64_t> put_object_buffer_size_in_bytes;
 	std::optional<uint64_t> get_object_buffer_size_in_bytes;
+	std::optional<uint64_t> get_object_read_ahead_in_bytes;
+	std::optional<uint64_t> get_object_small_object_threshold_in_bytes;
+	std::optional<bool> get_object_coalescing_enabled;
+	std::optional<uint64_t> get_object_coalescing_max_object_size_in_bytes;
+	std::optional<uint64_t> get_object_coalescing_budget_in_bytes;
+	std::optional<uint64_t> max_transfer_buffer_size_in_bytes;
+	std::optional<uint64_t> transfer_buffer_budget_in_bytes;
+	std::optional<irods::s3::checksum_policy> get_object_checksum_policy;
+	std::optional<bool> enable_data_redirection;
+	std::optional<irods::s3::replica_selection_policy> replica_selection_policy;
+	std::optional<std::vector<std::string>> replica_selection_local_hosts;
+	std::optional<bool> direct_vault_reads_enabled;
+	std::optional<uint64_t> parallel_transfer_threshold_in_bytes;
+	std::optional<uint64_t> parallel_transfer_stream_count;
+	std::optional<uint64_t> parallel_transfer_block_size_in_bytes;
+	std::optional<uint64_t> parallel_transfer_max_buffered_blocks;
+	std::optional<bool> parallel_transfer_spread_reads_across_replicas;
+	std::optional<uint64_t> hedged_reads_min_delay_in_milliseconds;
+	std::optional<uint64_t> hedged_reads_max_delay_in_milliseconds;
+	std::optional<std::vector<std::string>> archive_resources;
+	std::optional<std::string> archive_stage_resource;
 	std::optional<std::string> s3_region;
+	std::optional<bool> zerocopy_enabled;
+	std::optional<uint64_t> zerocopy_min_response_size_in_bytes;
+	std::optional<uint64_t> zerocopy_min_write_size_in_bytes;
+
+	// Returns the value of a hedged read option for a bucket, falling back to the value shared by
+	// all buckets.
+	template <typename T>
+	T get_hedged_reads_option(const std::string& _bucket, const std::string& _name, T _default)
+	{
+		const nlohmann::json& config = irods::http::globals::configuration();
+
+		const nlohmann::json::json_pointer buckets{"/irods_client/hedged_reads/buckets"};
+		if (config.contains(buckets)) {
+			const auto& options = config.at(buckets);
+			if (const auto iter = options.find(_bucket); iter != options.end() && iter->contains(_name)) {
+				return iter->at(_name).get<T>();
+			}
+		}
+
+		return config.value(nlohmann::json::json_pointer{"/irods_client/hedged_reads/" + _name}, _default);
+	}
 } //namespace
 
 uint64_t irods::s3::get_put_object_buffer_size_in_bytes()
@@ -32,6 +75,249 @@ uint64_t irods::s3::get_get_object_buffer_size_in_bytes()
 	return get_object_buffer_size_in_bytes.value();
 }
 
+uint64_t irods::s3::get_get_object_read_ahead_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!get_object_read_ahead_in_bytes.has_value()) {
+		get_object_read_ahead_in_bytes =
+			config.value(nlohmann::json::json_pointer{"/irods_client/get_object_read_ahead_in_bytes"}, 1048576);
+	}
+	return get_object_read_ahead_in_bytes.value();
+}
+
+uint64_t irods::s3::get_get_object_small_object_threshold_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!get_object_small_object_threshold_in_bytes.has_value()) {
+		get_object_small_object_threshold_in_bytes = config.value(
+			nlohmann::json::json_pointer{"/irods_client/get_object_small_object_threshold_in_bytes"}, 0);
+	}
+	return get_object_small_object_threshold_in_bytes.value();
+}
+
+bool irods::s3::get_get_object_coalescing_enabled()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!get_object_coalescing_enabled.has_value()) {
+		get_object_coalescing_enabled =
+			config.value(nlohmann::json::json_pointer{"/irods_client/get_object_coalescing/enabled"}, false);
+	}
+	return get_object_coalescing_enabled.value();
+}
+
+uint64_t irods::s3::get_get_object_coalescing_max_object_size_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!get_object_coalescing_max_object_size_in_bytes.has_value()) {
+		get_object_coalescing_max_object_size_in_bytes = config.value(
+			nlohmann::json::json_pointer{"/irods_client/get_object_coalescing/max_object_size_in_bytes"}, 16777216);
+	}
+	return get_object_coalescing_max_object_size_in_bytes.value();
+}
+
+uint64_t irods::s3::get_get_object_coalescing_budget_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!get_object_coalescing_budget_in_bytes.has_value()) {
+		get_object_coalescing_budget_in_bytes = config.value(
+			nlohmann::json::json_pointer{"/irods_client/get_object_coalescing/budget_in_bytes"}, 268435456);
+	}
+	return get_object_coalescing_budget_in_bytes.value();
+}
+
+uint64_t irods::s3::get_max_transfer_buffer_size_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!max_transfer_buffer_size_in_bytes.has_value()) {
+		max_transfer_buffer_size_in_bytes =
+			config.value(nlohmann::json::json_pointer{"/irods_client/max_transfer_buffer_size_in_bytes"}, 4194304);
+	}
+	return max_transfer_buffer_size_in_bytes.value();
+}
+
+uint64_t irods::s3::get_transfer_buffer_budget_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!transfer_buffer_budget_in_bytes.has_value()) {
+		transfer_buffer_budget_in_bytes =
+			config.value(nlohmann::json::json_pointer{"/irods_client/transfer_buffer_budget_in_bytes"}, 268435456);
+	}
+	return transfer_buffer_budget_in_bytes.value();
+}
+
+irods::s3::checksum_policy irods::s3::get_get_object_checksum_policy()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!get_object_checksum_policy.has_value()) {
+		const auto policy =
+			config.value(nlohmann::json::json_pointer{"/irods_client/get_object_checksum_policy"}, "catalog");
+		if (policy == "none") {
+			get_object_checksum_policy = checksum_policy::none;
+		}
+		else if (policy == "compute_async") {
+			get_object_checksum_policy = checksum_policy::compute_async;
+		}
+		else {
+			get_object_checksum_policy = checksum_policy::catalog;
+		}
+	}
+	return get_object_checksum_policy.value();
+}
+
+bool irods::s3::get_enable_data_redirection()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!enable_data_redirection.has_value()) {
+		enable_data_redirection =
+			config.value(nlohmann::json::json_pointer{"/irods_client/enable_data_redirection"}, false);
+	}
+	return enable_data_redirection.value();
+}
+
+irods::s3::replica_selection_policy irods::s3::get_replica_selection_policy()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!replica_selection_policy.has_value()) {
+		const auto policy =
+			config.value(nlohmann::json::json_pointer{"/irods_client/replica_selection/policy"}, "resource");
+		if (policy == "nearest") {
+			replica_selection_policy = replica_selection_policy::nearest;
+		}
+		else if (policy == "fastest") {
+			replica_selection_policy = replica_selection_policy::fastest;
+		}
+		else if (policy == "least_loaded") {
+			replica_selection_policy = replica_selection_policy::least_loaded;
+		}
+		else {
+			replica_selection_policy = replica_selection_policy::resource;
+		}
+	}
+	return replica_selection_policy.value();
+}
+
+const std::vector<std::string>& irods::s3::get_replica_selection_local_hosts()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!replica_selection_local_hosts.has_value()) {
+		// The host running this server is always local.
+		replica_selection_local_hosts = config.value(
+			nlohmann::json::json_pointer{"/irods_client/replica_selection/local_hosts"}, std::vector<std::string>{});
+		replica_selection_local_hosts->push_back(boost::asio::ip::host_name());
+	}
+	return replica_selection_local_hosts.value();
+}
+
+bool irods::s3::get_direct_vault_reads_enabled()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!direct_vault_reads_enabled.has_value()) {
+		direct_vault_reads_enabled =
+			config.value(nlohmann::json::json_pointer{"/irods_client/direct_vault_reads/enabled"}, false);
+	}
+	return direct_vault_reads_enabled.value();
+}
+
+uint64_t irods::s3::get_parallel_transfer_threshold_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!parallel_transfer_threshold_in_bytes.has_value()) {
+		parallel_transfer_threshold_in_bytes = config.value(
+			nlohmann::json::json_pointer{"/irods_client/parallel_transfer/threshold_in_bytes"}, 33554432);
+	}
+	return parallel_transfer_threshold_in_bytes.value();
+}
+
+uint64_t irods::s3::get_parallel_transfer_stream_count()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!parallel_transfer_stream_count.has_value()) {
+		parallel_transfer_stream_count =
+			config.value(nlohmann::json::json_pointer{"/irods_client/parallel_transfer/streams"}, 1);
+	}
+	return parallel_transfer_stream_count.value();
+}
+
+uint64_t irods::s3::get_parallel_transfer_block_size_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!parallel_transfer_block_size_in_bytes.has_value()) {
+		parallel_transfer_block_size_in_bytes = config.value(
+			nlohmann::json::json_pointer{"/irods_client/parallel_transfer/block_size_in_bytes"}, 4194304);
+	}
+	return parallel_transfer_block_size_in_bytes.value();
+}
+
+uint64_t irods::s3::get_parallel_transfer_max_buffered_blocks()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!parallel_transfer_max_buffered_blocks.has_value()) {
+		parallel_transfer_max_buffered_blocks =
+			config.value(nlohmann::json::json_pointer{"/irods_client/parallel_transfer/max_buffered_blocks"}, 8);
+	}
+	return parallel_transfer_max_buffered_blocks.value();
+}
+
+bool irods::s3::get_parallel_transfer_spread_reads_across_replicas()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!parallel_transfer_spread_reads_across_replicas.has_value()) {
+		parallel_transfer_spread_reads_across_replicas = config.value(
+			nlohmann::json::json_pointer{"/irods_client/parallel_transfer/spread_reads_across_replicas"}, false);
+	}
+	return parallel_transfer_spread_reads_across_replicas.value();
+}
+
+bool irods::s3::get_hedged_reads_enabled(const std::string& _bucket)
+{
+	return get_hedged_reads_option(_bucket, "enabled", false);
+}
+
+double irods::s3::get_hedged_reads_latency_percentile(const std::string& _bucket)
+{
+	return get_hedged_reads_option(_bucket, "latency_percentile", 95.0);
+}
+
+uint64_t irods::s3::get_hedged_reads_min_delay_in_milliseconds()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!hedged_reads_min_delay_in_milliseconds.has_value()) {
+		hedged_reads_min_delay_in_milliseconds =
+			config.value(nlohmann::json::json_pointer{"/irods_client/hedged_reads/min_delay_in_milliseconds"}, 10);
+	}
+	return hedged_reads_min_delay_in_milliseconds.value();
+}
+
+uint64_t irods::s3::get_hedged_reads_max_delay_in_milliseconds()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!hedged_reads_max_delay_in_milliseconds.has_value()) {
+		hedged_reads_max_delay_in_milliseconds =
+			config.value(nlohmann::json::json_pointer{"/irods_client/hedged_reads/max_delay_in_milliseconds"}, 1000);
+	}
+	return hedged_reads_max_delay_in_milliseconds.value();
+}
+
+const std::vector<std::string>& irods::s3::get_archive_resources()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!archive_resources.has_value()) {
+		archive_resources = config.value(
+			nlohmann::json::json_pointer{"/irods_client/archive/archive_resources"}, std::vector<std::string>{});
+	}
+	return archive_resources.value();
+}
+
+std::string irods::s3::get_archive_stage_resource()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!archive_stage_resource.has_value()) {
+		archive_stage_resource =
+			config.value(nlohmann::json::json_pointer{"/irods_client/archive/stage_resource"}, std::string{});
+	}
+	return archive_stage_resource.value();
+}
+
 std::string irods::s3::get_s3_region()
 {
 	const nlohmann::json& config = irods::http::globals::configuration();
@@ -41,6 +327,35 @@ std::string irods::s3::get_s3_region()
 	return s3_region.value();
 }
 
+bool irods::s3::get_zerocopy_enabled()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!zerocopy_enabled.has_value()) {
+		zerocopy_enabled = config.value(nlohmann::json::json_pointer{"/s3_server/zerocopy/enabled"}, false);
+	}
+	return zerocopy_enabled.value();
+}
+
+uint64_t irods::s3::get_zerocopy_min_response_size_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!zerocopy_min_response_size_in_bytes.has_value()) {
+		zerocopy_min_response_size_in_bytes = config.value(
+			nlohmann::json::json_pointer{"/s3_server/zerocopy/min_response_size_in_bytes"}, 1048576);
+	}
+	return zerocopy_min_response_size_in_bytes.value();
+}
+
+uint64_t irods::s3::get_zerocopy_min_write_size_in_bytes()
+{
+	const nlohmann::json& config = irods::http::globals::configuration();
+	if (!zerocopy_min_write_size_in_bytes.has_value()) {
+		zerocopy_min_write_size_in_bytes =
+			config.value(nlohmann::json::json_pointer{"/s3_server/zerocopy/min_write_size_in_bytes"}, 16384);
+	}
+	return zerocopy_min_write_size_in_bytes.value();
+}
+
 void irods::s3::set_resource(const std::string_view& resc)
 {
 	resource = resc;
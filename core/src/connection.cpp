@@ -1,10 +1,83 @@
 #include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/configuration.hpp"
 #include "irods/private/s3_api/globals.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 
+#include <irods/dataObjInpOut.h>
+#include <irods/fully_qualified_username.hpp>
+#include <irods/getHostForGet.h>
+#include <irods/getHostForPut.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/irods_exception.hpp>
 #include <irods/rcConnect.h>
+#include <irods/rcMisc.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rodsKeyWdDef.h>
+
+#include <fmt/format.h>
+
+#include <cstdlib>
 #include <optional>
+#include <string_view>
+
+namespace
+{
+	// Asks the iRODS server which host should serve the bytes of a data object.
+	//
+	// Returns an empty std::optional if the configured iRODS server is the correct host or if the
+	// host could not be resolved.
+	auto resolve_data_host(
+		RcComm& _comm,
+		const irods::experimental::filesystem::path& _path,
+		irods::s3::data_transfer_direction _direction) -> std::optional<std::string>
+	{
+		namespace logging = irods::http::logging;
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_options{[&input] { clearKeyVal(&input.condInput); }};
+		irods::strncpy_null_terminated(input.objPath, _path.c_str());
+
+		const auto resource = irods::s3::get_resource();
+		char* host{};
+		int ec = 0;
+
+		if (_direction == irods::s3::data_transfer_direction::read) {
+			input.oprType = GET_OPR;
+			if (!resource.empty()) {
+				addKeyVal(&input.condInput, RESC_NAME_KW, resource.c_str());
+			}
+			ec = irods::s3::rpc_profiler::timed(
+				"GET_HOST_FOR_GET", [&] { return rcGetHostForGet(&_comm, &input, &host); });
+		}
+		else {
+			input.oprType = PUT_OPR;
+			if (!resource.empty()) {
+				addKeyVal(&input.condInput, DEST_RESC_NAME_KW, resource.c_str());
+			}
+			ec = irods::s3::rpc_profiler::timed(
+				"GET_HOST_FOR_PUT", [&] { return rcGetHostForPut(&_comm, &input, &host); });
+		}
+
+		std::unique_ptr<char, void (*)(void*)> host_ptr{host, std::free};
+
+		if (ec < 0 || host == nullptr) {
+			logging::debug("{}: Could not resolve data host for [{}]. ec=[{}]", __func__, _path.c_str(), ec);
+			return std::nullopt;
+		}
+
+		const auto& configured_host = irods::http::globals::configuration()
+		                                  .at(nlohmann::json::json_pointer{"/irods_client/host"})
+		                                  .get_ref<const std::string&>();
+
+		if (std::string_view{host} == THIS_ADDRESS || configured_host == host) {
+			return std::nullopt;
+		}
+
+		return std::string{host};
+	} // resolve_data_host
+} // anonymous namespace
 
 std::unique_ptr<rcComm_t, irods::s3::__detail::rcComm_Deleter> irods::s3::get_connection(
 	const std::optional<std::string>& _client_username)
@@ -49,3 +122,98 @@ std::unique_ptr<rcComm_t, irods::s3::__detail::rcComm_Deleter> irods::s3::get_co
 
 	return result;
 }
+
+std::shared_ptr<irods::experimental::client_connection> irods::s3::get_dedicated_connection(
+	const std::string& _client_username,
+	const std::optional<std::string>& _host)
+{
+	namespace logging = irods::http::logging;
+	using json_pointer = nlohmann::json::json_pointer;
+
+	const auto& irods_client_config = irods::http::globals::configuration().at("irods_client");
+	const auto& zone = irods_client_config.at("zone").get_ref<const std::string&>();
+
+	const auto& rodsadmin_username =
+		irods_client_config.at(json_pointer{"/proxy_admin_account/username"}).get_ref<const std::string&>();
+	auto rodsadmin_password =
+		irods_client_config.at(json_pointer{"/proxy_admin_account/password"}).get_ref<const std::string&>();
+
+	irods::s3::rpc_profiler::timer timer{"CONNECT"};
+
+	auto conn = std::make_shared<irods::experimental::client_connection>(
+		irods::experimental::defer_authentication,
+		_host.value_or(irods_client_config.at("host").get_ref<const std::string&>()),
+		irods_client_config.at("port").get<int>(),
+		irods::experimental::fully_qualified_username{rodsadmin_username, zone},
+		irods::experimental::fully_qualified_username{_client_username, zone});
+
+	if (const auto ec = clientLoginWithPassword(static_cast<RcComm*>(*conn), rodsadmin_password.data()); ec < 0) {
+		timer.stop(true);
+		logging::error("{}: clientLoginWithPassword error: {}", __func__, ec);
+		THROW(ec, "clientLoginWithPassword error.");
+	}
+
+	return conn;
+}
+
+std::shared_ptr<irods::experimental::client_connection> irods::s3::get_data_connection(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path,
+	data_transfer_direction _direction)
+{
+	auto conns = get_data_connections(_client_username, _path, _direction, 1);
+
+	if (conns.empty()) {
+		THROW(SYS_INTERNAL_ERR, fmt::format("Could not connect to iRODS for [{}].", _path.c_str()));
+	}
+
+	return std::move(conns.front());
+}
+
+std::vector<std::shared_ptr<irods::experimental::client_connection>> irods::s3::get_data_connections(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path,
+	data_transfer_direction _direction,
+	std::size_t _count)
+{
+	namespace logging = irods::http::logging;
+
+	std::vector<std::shared_ptr<irods::experimental::client_connection>> conns;
+	conns.reserve(_count);
+
+	std::optional<std::string> host;
+
+	if (irods::s3::get_enable_data_redirection()) {
+		try {
+			auto conn = irods::get_connection(_client_username);
+			host = resolve_data_host(conn, _path, _direction);
+		}
+		catch (const std::exception& e) {
+			logging::warn("{}: Could not resolve data host for [{}]: {}", __func__, _path.c_str(), e.what());
+		}
+	}
+
+	if (host) {
+		try {
+			logging::debug("{}: Redirecting data transfer for [{}] to [{}].", __func__, _path.c_str(), *host);
+			while (conns.size() < _count) {
+				conns.push_back(get_dedicated_connection(_client_username, host));
+			}
+			return conns;
+		}
+		catch (const std::exception& e) {
+			logging::warn(
+				"{}: Could not connect to [{}]. Falling back to the configured iRODS server: {}",
+				__func__,
+				*host,
+				e.what());
+			conns.clear();
+		}
+	}
+
+	while (conns.size() < _count) {
+		conns.push_back(get_dedicated_connection(_client_username));
+	}
+
+	return conns;
+}
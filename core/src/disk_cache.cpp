@@ -0,0 +1,550 @@
+#include "irods/private/s3_api/disk_cache.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/hmac.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+
+#include <irods/client_connection.hpp>
+#include <irods/dstream.hpp>
+#include <irods/transport/default_transport.hpp>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// Writes all of _data to _fd.
+	auto write_fully(int _fd, const char* _data, std::size_t _size) -> bool
+	{
+		while (_size > 0) {
+			const auto n = ::write(_fd, _data, _size);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;
+			}
+			_data += n;
+			_size -= static_cast<std::size_t>(n);
+		}
+
+		return true;
+	} // write_fully
+
+	// Flushes the directory entry of files renamed into _directory.
+	auto sync_directory(const std::filesystem::path& _directory) -> void
+	{
+		if (const auto fd = ::open(_directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); fd >= 0) {
+			::fsync(fd);
+			::close(fd);
+		}
+	} // sync_directory
+
+	auto remove_quietly(const std::filesystem::path& _p) -> void
+	{
+		std::error_code ec;
+		std::filesystem::remove(_p, ec);
+	} // remove_quietly
+} // anonymous namespace
+
+irods::s3::disk_cache::file::file(int _fd) noexcept
+	: fd_{_fd}
+{
+} // constructor
+
+irods::s3::disk_cache::file::~file()
+{
+	if (fd_ >= 0) {
+		::close(fd_);
+	}
+} // destructor
+
+irods::s3::disk_cache::file::file(file&& _other) noexcept
+	: fd_{std::exchange(_other.fd_, -1)}
+{
+} // move constructor
+
+auto irods::s3::disk_cache::file::native_handle() const noexcept -> int
+{
+	return fd_;
+} // native_handle
+
+irods::s3::disk_cache::disk_cache(
+	std::filesystem::path _directory,
+	std::uint64_t _capacity_in_bytes,
+	std::uint64_t _min_object_size_in_bytes)
+	: directory_{std::move(_directory)}
+	, capacity_{_capacity_in_bytes}
+	, min_object_size_{_min_object_size_in_bytes}
+{
+	std::filesystem::create_directories(directory_);
+	rebuild_index();
+
+	logging::info(
+		"{}: Caching objects of at least [{}] bytes in [{}]. [{}] entries using [{}] of [{}] bytes recovered.",
+		__func__,
+		min_object_size_,
+		directory_.c_str(),
+		index_.size(),
+		size_,
+		capacity_);
+} // constructor
+
+auto irods::s3::disk_cache::accepts(std::uint64_t _size) const noexcept -> bool
+{
+	// An object must leave room for others, otherwise every fill would empty the cache.
+	return _size >= min_object_size_ && _size > 0 && _size <= capacity_ / 2;
+} // accepts
+
+auto irods::s3::disk_cache::open(const std::string& _path, const version& _version) -> std::optional<file>
+{
+	const auto key = key_of(_path);
+
+	std::lock_guard lk{mutex_};
+
+	const auto iter = index_.find(key);
+	if (iter == std::end(index_)) {
+		++misses_;
+		return std::nullopt;
+	}
+
+	if (iter->second.current_version != _version) {
+		erase(iter);
+		++misses_;
+		return std::nullopt;
+	}
+
+	const auto fd = ::open(data_file(key).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		logging::warn("{}: Cache entry for [{}] is unreadable. Dropping it.", __func__, _path);
+		erase(iter);
+		++misses_;
+		return std::nullopt;
+	}
+
+	touch(iter->second);
+	++hits_;
+
+	// The modification time of the metadata file orders the entries when the index is rebuilt.
+	std::error_code ec;
+	std::filesystem::last_write_time(meta_file(key), std::filesystem::file_time_type::clock::now(), ec);
+
+	return file{fd};
+} // open
+
+auto irods::s3::disk_cache::contains(const std::string& _path, const version& _version) const -> bool
+{
+	const auto key = key_of(_path);
+
+	std::lock_guard lk{mutex_};
+	const auto iter = index_.find(key);
+	return iter != std::end(index_) && iter->second.current_version == _version;
+} // contains
+
+auto irods::s3::disk_cache::fill_async(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path,
+	const version& _version) -> void
+{
+	if (!accepts(_version.size)) {
+		return;
+	}
+
+	const auto key = key_of(_path.string());
+
+	{
+		std::lock_guard lk{mutex_};
+		if (!fills_in_progress_.insert(key).second) {
+			return;
+		}
+	}
+
+	irods::http::globals::background_task([this, _client_username, _path, _version, key] {
+		bool filled = false;
+
+		try {
+			filled = fill(_client_username, _path, _version);
+		}
+		catch (const std::exception& e) {
+			logging::error("{}: Failed to cache [{}]: {}", __func__, _path.c_str(), e.what());
+		}
+
+		++(filled ? fills_ : failed_fills_);
+
+		std::lock_guard lk{mutex_};
+		fills_in_progress_.erase(key);
+		invalidated_fills_.erase(key);
+	});
+} // fill_async
+
+auto irods::s3::disk_cache::fill(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path,
+	const version& _version) -> bool
+{
+	namespace io = irods::experimental::io;
+
+	const auto key = key_of(_path.string());
+	const auto data_tmp = directory_ / (key + ".data.tmp");
+	const auto meta_tmp = directory_ / (key + ".meta.tmp");
+
+	auto conn = get_data_connection(_client_username, _path, data_transfer_direction::read);
+	io::client::default_transport xtrans{*conn};
+	irods::s3::rpc_profiler::timer open_timer{"DATA_OBJ_OPEN"};
+	io::idstream in{xtrans, _path, io::root_resource_name{get_resource()}, std::ios_base::in};
+	open_timer.stop(!in.is_open());
+
+	if (!in.is_open()) {
+		logging::error("{}: Failed to open iRODS data object [{}].", __func__, _path.c_str());
+		return false;
+	}
+
+	const auto fd = ::open(data_tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		logging::error("{}: Failed to create [{}]. errno=[{}]", __func__, data_tmp.c_str(), errno);
+		return false;
+	}
+
+	std::vector<char> buffer(4 * 1024 * 1024);
+	std::uint64_t total = 0;
+	bool ok = true;
+
+	while (ok && total < _version.size) {
+		irods::s3::rpc_profiler::timer read_timer{"DATA_OBJ_READ"};
+		in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		const auto count = static_cast<std::size_t>(in.gcount());
+		read_timer.stop(count == 0);
+		if (count == 0) {
+			break;
+		}
+		ok = write_fully(fd, buffer.data(), count);
+		total += count;
+	}
+
+	ok = ok && total == _version.size && ::fsync(fd) == 0;
+	::close(fd);
+
+	if (!ok) {
+		logging::error(
+			"{}: Failed to copy [{}] into the cache. [{}] of [{}] bytes written.",
+			__func__,
+			_path.c_str(),
+			total,
+			_version.size);
+		remove_quietly(data_tmp);
+		return false;
+	}
+
+	// The object may have been overwritten between the lookup of the request and the copy, in which
+	// case the bytes belong to another version. The object is looked up again once they are on disk.
+	const auto stat = stat_object(*conn, _path, _client_username, stat_sharing::none);
+	if (!stat || version{stat->size, stat->mtime, stat->checksum} != _version) {
+		logging::debug("{}: [{}] changed while it was copied. Discarding the copy.", __func__, _path.c_str());
+		remove_quietly(data_tmp);
+		return false;
+	}
+
+	const auto meta = nlohmann::json{
+		{"path", _path.string()},
+		{"size", _version.size},
+		{"mtime", _version.mtime},
+		{"checksum", _version.checksum}}.dump();
+
+	const auto meta_fd = ::open(meta_tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	ok = meta_fd >= 0 && write_fully(meta_fd, meta.data(), meta.size()) && ::fsync(meta_fd) == 0;
+	if (meta_fd >= 0) {
+		::close(meta_fd);
+	}
+
+	if (!ok) {
+		logging::error("{}: Failed to write [{}].", __func__, meta_tmp.c_str());
+		remove_quietly(data_tmp);
+		remove_quietly(meta_tmp);
+		return false;
+	}
+
+	std::lock_guard lk{mutex_};
+
+	// Writes through this server are not always visible in the catalog's modification time, e.g.
+	// an overwrite of the same size within the same second.
+	if (invalidated_fills_.erase(key) > 0) {
+		logging::debug("{}: [{}] was written while it was copied. Discarding the copy.", __func__, _path.c_str());
+		remove_quietly(data_tmp);
+		remove_quietly(meta_tmp);
+		return false;
+	}
+
+	// Renaming the metadata file commits the entry.
+	std::filesystem::rename(data_tmp, data_file(key));
+	std::filesystem::rename(meta_tmp, meta_file(key));
+	sync_directory(directory_);
+
+	insert(key, _path.string(), _version);
+	evict_if_needed();
+
+	logging::debug("{}: Cached [{}] ([{}] bytes).", __func__, _path.c_str(), total);
+
+	return true;
+} // fill
+
+auto irods::s3::disk_cache::invalidate(const std::string& _path) -> void
+{
+	const auto key = key_of(_path);
+
+	std::lock_guard lk{mutex_};
+
+	if (const auto iter = index_.find(key); iter != std::end(index_)) {
+		erase(iter);
+	}
+
+	// A copy in progress may hold bytes from before the write.
+	if (fills_in_progress_.contains(key)) {
+		invalidated_fills_.insert(key);
+	}
+} // invalidate
+
+auto irods::s3::disk_cache::record_bytes_served(std::uint64_t _bytes) noexcept -> void
+{
+	bytes_served_ += _bytes;
+} // record_bytes_served
+
+auto irods::s3::disk_cache::stats() const -> statistics
+{
+	statistics result;
+	result.hits = hits_.load();
+	result.misses = misses_.load();
+	result.fills = fills_.load();
+	result.failed_fills = failed_fills_.load();
+	result.evictions = evictions_.load();
+	result.bytes_served = bytes_served_.load();
+
+	std::lock_guard lk{mutex_};
+	result.entries = index_.size();
+	result.size_in_bytes = size_;
+
+	return result;
+} // stats
+
+auto irods::s3::disk_cache::log_report() const -> void
+{
+	const auto s = stats();
+	const auto lookups = s.hits + s.misses;
+
+	logging::info(
+		"{}: Disk cache hit ratio [{:.3f}] ([{}] of [{}] lookups), [{}] bytes served, [{}] fills, [{}] failed fills, "
+		"[{}] evictions, [{}] entries using [{}] bytes.",
+		__func__,
+		lookups > 0 ? static_cast<double>(s.hits) / static_cast<double>(lookups) : 0.0,
+		s.hits,
+		lookups,
+		s.bytes_served,
+		s.fills,
+		s.failed_fills,
+		s.evictions,
+		s.entries,
+		s.size_in_bytes);
+} // log_report
+
+auto irods::s3::disk_cache::insert(const std::string& _key, const std::string& _path, const version& _version) -> void
+{
+	// A newer copy replaces the files of an existing entry, so only the index entry is dropped.
+	if (const auto iter = index_.find(_key); iter != std::end(index_)) {
+		auto& list = (iter->second.where == segment::probation) ? probation_ : protected_;
+		list.erase(iter->second.position);
+		size_ -= iter->second.current_version.size;
+		if (iter->second.where == segment::protected_) {
+			protected_size_ -= iter->second.current_version.size;
+		}
+		index_.erase(iter);
+	}
+
+	probation_.push_front(_key);
+	index_.emplace(_key, entry{_path, _version, segment::probation, std::begin(probation_)});
+	size_ += _version.size;
+} // insert
+
+auto irods::s3::disk_cache::touch(entry& _entry) -> void
+{
+	if (_entry.where == segment::protected_) {
+		protected_.splice(std::begin(protected_), protected_, _entry.position);
+		return;
+	}
+
+	// A second use promotes the entry. The protected segment overflows into the probationary one.
+	protected_.splice(std::begin(protected_), probation_, _entry.position);
+	_entry.where = segment::protected_;
+	protected_size_ += _entry.current_version.size;
+
+	while (protected_size_ > capacity_ / 5 * 4 && protected_.size() > 1) {
+		const auto demoted = std::prev(std::end(protected_));
+		auto& e = index_.at(*demoted);
+		probation_.splice(std::begin(probation_), protected_, demoted);
+		e.where = segment::probation;
+		protected_size_ -= e.current_version.size;
+	}
+} // touch
+
+auto irods::s3::disk_cache::erase(std::unordered_map<std::string, entry>::iterator _iter) -> void
+{
+	const auto& key = _iter->first;
+	auto& e = _iter->second;
+
+	// Removing the metadata file first uncommits the entry.
+	remove_quietly(meta_file(key));
+	remove_quietly(data_file(key));
+
+	auto& list = (e.where == segment::probation) ? probation_ : protected_;
+	list.erase(e.position);
+	size_ -= e.current_version.size;
+	if (e.where == segment::protected_) {
+		protected_size_ -= e.current_version.size;
+	}
+
+	index_.erase(_iter);
+} // erase
+
+auto irods::s3::disk_cache::evict_if_needed() -> void
+{
+	while (size_ > capacity_ && !index_.empty()) {
+		const auto& victims = probation_.empty() ? protected_ : probation_;
+		const auto iter = index_.find(victims.back());
+		logging::debug("{}: Evicting [{}] from the disk cache.", __func__, iter->second.path);
+		erase(iter);
+		++evictions_;
+	}
+} // evict_if_needed
+
+auto irods::s3::disk_cache::rebuild_index() -> void
+{
+	struct recovered
+	{
+		std::string key;
+		std::string path;
+		version current_version;
+		std::filesystem::file_time_type last_used;
+	};
+
+	std::vector<recovered> entries;
+
+	for (const auto& dirent : std::filesystem::directory_iterator{directory_}) {
+		const auto& p = dirent.path();
+
+		// Files of interrupted fills.
+		if (p.extension() == ".tmp") {
+			remove_quietly(p);
+			continue;
+		}
+
+		if (p.extension() != ".meta") {
+			continue;
+		}
+
+		const auto key = p.stem().string();
+
+		try {
+			std::ifstream in{p};
+			const auto meta = nlohmann::json::parse(in);
+
+			recovered r{
+				key,
+				meta.at("path").get<std::string>(),
+				{meta.at("size").get<std::uintmax_t>(),
+				 meta.at("mtime").get<std::time_t>(),
+				 meta.at("checksum").get<std::string>()},
+				std::filesystem::last_write_time(p)};
+
+			if (std::filesystem::file_size(data_file(key)) == r.current_version.size) {
+				entries.push_back(std::move(r));
+				continue;
+			}
+		}
+		catch (const std::exception& e) {
+			logging::warn("{}: Dropping unreadable cache entry [{}]: {}", __func__, p.c_str(), e.what());
+		}
+
+		remove_quietly(p);
+		remove_quietly(data_file(key));
+	}
+
+	// Data files without metadata were never committed.
+	for (const auto& dirent : std::filesystem::directory_iterator{directory_}) {
+		const auto& p = dirent.path();
+		if (p.extension() == ".data" && !std::filesystem::exists(meta_file(p.stem().string()))) {
+			remove_quietly(p);
+		}
+	}
+
+	// Insert the least recently used entries first so that they end up at the back.
+	std::sort(std::begin(entries), std::end(entries), [](const auto& _l, const auto& _r) {
+		return _l.last_used < _r.last_used;
+	});
+
+	for (const auto& r : entries) {
+		insert(r.key, r.path, r.current_version);
+	}
+
+	evict_if_needed();
+} // rebuild_index
+
+auto irods::s3::disk_cache::key_of(const std::string& _path) const -> std::string
+{
+	return irods::s3::authentication::hex_encode(irods::s3::authentication::hash_sha_256(_path));
+} // key_of
+
+auto irods::s3::disk_cache::data_file(const std::string& _key) const -> std::filesystem::path
+{
+	return directory_ / (_key + ".data");
+} // data_file
+
+auto irods::s3::disk_cache::meta_file(const std::string& _key) const -> std::filesystem::path
+{
+	return directory_ / (_key + ".meta");
+} // meta_file
+
+auto irods::s3::send_file(int _socket, const disk_cache::file& _file, std::uint64_t& _offset, std::uint64_t& _count)
+	-> int
+{
+	while (_count > 0) {
+		auto offset = static_cast<off_t>(_offset);
+		const auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(_count, 1U << 30));
+		const auto n = ::sendfile(_socket, _file.native_handle(), &offset, chunk);
+
+		if (n > 0) {
+			_offset += static_cast<std::uint64_t>(n);
+			_count -= static_cast<std::uint64_t>(n);
+			continue;
+		}
+
+		if (n == 0) {
+			// The file is shorter than expected.
+			return EIO;
+		}
+
+		if (errno == EINTR) {
+			continue;
+		}
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return EAGAIN;
+		}
+
+		return errno;
+	}
+
+	return 0;
+} // send_file
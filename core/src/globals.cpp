@@ -1,4 +1,5 @@
 #include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 
 #include <boost/asio.hpp>
 
@@ -13,8 +14,46 @@ namespace
 	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 	boost::asio::thread_pool* g_bg_thread_pool{};
 
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	boost::asio::thread_pool* g_metadata_thread_pool{};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	boost::asio::thread_pool* g_compute_thread_pool{};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	boost::asio::thread_pool* g_transfer_thread_pool{};
+
 	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 	irods::connection_pool* g_conn_pool{};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	irods::s3::object_cache* g_object_cache{};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	irods::s3::disk_cache* g_disk_cache{};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	irods::s3::restore_queue* g_restore_queue{};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	irods::s3::prefetcher* g_prefetcher{};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	irods::s3::open_handle_cache* g_open_handle_cache{};
+
+	auto post_task(boost::asio::thread_pool& _tp, std::function<void()> _task) -> void
+	{
+		// The task continues to record iRODS API calls against the request which scheduled it.
+		boost::asio::post(_tp, [t = std::move(_task), profile = irods::s3::rpc_profiler::current()] {
+			const irods::s3::rpc_profiler::scope scope{profile};
+
+			try {
+				t();
+			}
+			catch (...) {
+			}
+		});
+	} // post_task
 } // anonymous namespace
 
 namespace irods::http::globals
@@ -51,15 +90,54 @@ namespace irods::http::globals
 
 	auto background_task(std::function<void()> _task) -> void
 	{
-		boost::asio::post(background_thread_pool(), [t = std::move(_task)] {
-			try {
-				t();
-			}
-			catch (...) {
-			}
-		});
+		post_task(background_thread_pool(), std::move(_task));
 	} // background_task
 
+	auto set_metadata_thread_pool(boost::asio::thread_pool& _tp) -> void
+	{
+		g_metadata_thread_pool = &_tp;
+	} // set_metadata_thread_pool
+
+	auto metadata_thread_pool() -> boost::asio::thread_pool&
+	{
+		return *g_metadata_thread_pool;
+	} // metadata_thread_pool
+
+	auto metadata_task(std::function<void()> _task) -> void
+	{
+		post_task(metadata_thread_pool(), std::move(_task));
+	} // metadata_task
+
+	auto set_compute_thread_pool(boost::asio::thread_pool& _tp) -> void
+	{
+		g_compute_thread_pool = &_tp;
+	} // set_compute_thread_pool
+
+	auto compute_thread_pool() -> boost::asio::thread_pool&
+	{
+		return *g_compute_thread_pool;
+	} // compute_thread_pool
+
+	auto compute_task(std::function<void()> _task) -> void
+	{
+		post_task(compute_thread_pool(), std::move(_task));
+	} // compute_task
+
+	auto set_transfer_thread_pool(boost::asio::thread_pool& _tp) -> void
+	{
+		g_transfer_thread_pool = &_tp;
+	} // set_transfer_thread_pool
+
+	auto transfer_thread_pool() -> boost::asio::thread_pool&
+	{
+		return *g_transfer_thread_pool;
+	} // transfer_thread_pool
+
+	auto transfer_task(std::function<void()> _task) -> void
+	{
+		post_task(transfer_thread_pool(), std::move(_task));
+	} // transfer_task
+
 	auto set_connection_pool(irods::connection_pool& _cp) -> void
 	{
 		g_conn_pool = &_cp;
@@ -69,4 +147,54 @@ namespace irods::http::globals
 	{
 		return *g_conn_pool;
 	} // connection_pool
+
+	auto set_object_cache(irods::s3::object_cache* _cache) -> void
+	{
+		g_object_cache = _cache;
+	} // set_object_cache
+
+	auto object_cache() -> irods::s3::object_cache*
+	{
+		return g_object_cache;
+	} // object_cache
+
+	auto set_disk_cache(irods::s3::disk_cache* _cache) -> void
+	{
+		g_disk_cache = _cache;
+	} // set_disk_cache
+
+	auto disk_cache() -> irods::s3::disk_cache*
+	{
+		return g_disk_cache;
+	} // disk_cache
+
+	auto set_restore_queue(irods::s3::restore_queue* _queue) -> void
+	{
+		g_restore_queue = _queue;
+	} // set_restore_queue
+
+	auto restore_queue() -> irods::s3::restore_queue*
+	{
+		return g_restore_queue;
+	} // restore_queue
+
+	auto set_prefetcher(irods::s3::prefetcher* _prefetcher) -> void
+	{
+		g_prefetcher = _prefetcher;
+	} // set_prefetcher
+
+	auto prefetcher() -> irods::s3::prefetcher*
+	{
+		return g_prefetcher;
+	} // prefetcher
+
+	auto set_open_handle_cache(irods::s3::open_handle_cache* _cache) -> void
+	{
+		g_open_handle_cache = _cache;
+	} // set_open_handle_cache
+
+	auto open_handle_cache() -> irods::s3::open_handle_cache*
+	{
+		return g_open_handle_cache;
+	} // open_handle_cache
 } // namespace irods::http::globals
@@ -0,0 +1,387 @@
+#include "irods/private/s3_api/hedged_read.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace fs = irods::experimental::filesystem;
+namespace io = irods::experimental::io;
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// The number of recent first-byte latencies the delay is derived from.
+	constexpr std::size_t max_samples = 1024;
+
+	// Until this many latencies have been recorded, the configured maximum delay is used.
+	constexpr std::size_t min_samples = 32;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::mutex g_samples_mutex;
+
+	// Recent first-byte latencies, in microseconds. Once full, the oldest sample is overwritten.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::vector<std::int64_t> g_samples;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::size_t g_next_sample = 0;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_reads{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_hedges{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_alternate_wins{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_failed_hedges{0};
+
+	auto record_latency(std::chrono::steady_clock::duration _latency) -> void
+	{
+		const auto us = std::chrono::duration_cast<std::chrono::microseconds>(_latency).count();
+
+		std::lock_guard lk{g_samples_mutex};
+
+		if (g_samples.size() < max_samples) {
+			g_samples.push_back(us);
+			return;
+		}
+
+		g_samples[g_next_sample] = us;
+		g_next_sample = (g_next_sample + 1) % max_samples;
+	} // record_latency
+
+	// Returns the latency below which _percentile percent of the recent first reads completed, or
+	// an empty std::optional if too few reads have been seen.
+	auto latency_percentile(double _percentile) -> std::optional<std::chrono::microseconds>
+	{
+		std::vector<std::int64_t> samples;
+
+		{
+			std::lock_guard lk{g_samples_mutex};
+			if (g_samples.size() < min_samples) {
+				return std::nullopt;
+			}
+			samples = g_samples;
+		}
+
+		const auto fraction = std::clamp(_percentile, 0.0, 100.0) / 100.0;
+		const auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(samples.size())));
+		const auto index = std::clamp<std::size_t>(rank, 1, samples.size()) - 1;
+		const auto nth = std::begin(samples) + static_cast<std::ptrdiff_t>(index);
+		std::nth_element(std::begin(samples), nth, std::end(samples));
+
+		return std::chrono::microseconds{*nth};
+	} // latency_percentile
+
+	// Aborts a read in progress on a connection. The connection remains valid, but every further
+	// operation on it fails.
+	auto shut_down(int _socket) -> void
+	{
+		if (_socket >= 0) {
+			::shutdown(_socket, SHUT_RDWR);
+		}
+	} // shut_down
+} // anonymous namespace
+
+irods::s3::replica_stream::replica_stream(std::shared_ptr<irods::experimental::client_connection> _conn)
+	: conn{std::move(_conn)}
+	, xtrans{*conn}
+{
+} // constructor
+
+// The state shared by the request, the timer which starts the alternate read and the alternate
+// read itself. Whichever of them finishes last frees it, so the request may finish first.
+struct irods::s3::hedged_read::race
+{
+	enum class winner_type
+	{
+		none,
+		primary,
+		alternate,
+		nobody // Every read failed.
+	};
+
+	race(
+		boost::asio::io_context& _io,
+		std::string _client_username,
+		fs::path _path,
+		std::uint64_t _offset,
+		std::chrono::milliseconds _delay)
+		: timer{_io}
+		, client_username{std::move(_client_username)}
+		, path{std::move(_path)}
+		, offset{_offset}
+		, delay{_delay}
+	{
+	}
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	boost::asio::steady_timer timer;
+	std::shared_ptr<irods::s3::rpc_profiler::request_profile> profile;
+
+	const std::string client_username;
+	const fs::path path;
+	const std::uint64_t offset;
+	const std::chrono::milliseconds delay;
+
+	int primary_replica = -1;
+	std::size_t count = 0;
+
+	winner_type winner = winner_type::none;
+	bool primary_done = false;
+	bool alternate_started = false;
+	bool alternate_running = false;
+	bool alternate_done = false;
+
+	// The sockets of the reads which may be aborted, or -1.
+	int primary_socket = -1;
+	int alternate_socket = -1;
+
+	// The winning alternate replica and the bytes it read.
+	std::unique_ptr<replica_stream> alternate;
+	std::vector<char> alternate_buffer;
+}; // struct hedged_read::race
+
+irods::s3::hedged_read::hedged_read(
+	std::string _client_username,
+	irods::experimental::filesystem::path _path,
+	std::uint64_t _offset,
+	std::chrono::milliseconds _delay)
+	: race_{std::make_shared<race>(
+		  irods::http::globals::request_handler_io_context(),
+		  std::move(_client_username),
+		  std::move(_path),
+		  _offset,
+		  _delay)}
+{
+} // constructor
+
+irods::s3::hedged_read::~hedged_read() = default;
+
+auto irods::s3::hedged_read::read(
+	RcComm& _primary_conn,
+	irods::experimental::io::idstream& _primary,
+	char* _buffer,
+	std::size_t _count) -> std::size_t
+{
+	++g_reads;
+
+	race_->profile = irods::s3::rpc_profiler::current();
+	race_->primary_replica = _primary.replica_number();
+	race_->primary_socket = _primary_conn.sock;
+	race_->count = _count;
+
+	race_->timer.expires_after(race_->delay);
+	race_->timer.async_wait([r = race_](const auto& _ec) {
+		if (_ec) {
+			return;
+		}
+
+		{
+			std::lock_guard lk{r->mutex};
+			if (r->primary_done) {
+				return;
+			}
+			r->alternate_started = true;
+		}
+
+		start_alternate(r);
+	});
+
+	const auto start = std::chrono::steady_clock::now();
+	_primary.read(_buffer, static_cast<std::streamsize>(_count));
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	const auto count = static_cast<std::size_t>(_primary.gcount());
+
+	record_latency(elapsed);
+
+	std::unique_lock lk{race_->mutex};
+	race_->primary_done = true;
+	race_->primary_socket = -1;
+
+	if (race_->winner == race::winner_type::none) {
+		if (!_primary.bad() && count > 0) {
+			race_->winner = race::winner_type::primary;
+			shut_down(race_->alternate_socket);
+			return count;
+		}
+
+		// The primary read failed. An alternate read which is under way may still succeed. One
+		// which is still queued is not waited for since it may be queued behind this thread.
+		if (!race_->alternate_running) {
+			race_->winner = race::winner_type::nobody;
+			return 0;
+		}
+
+		race_->cv.wait(lk, [this] { return race_->alternate_done; });
+	}
+
+	if (race_->winner != race::winner_type::alternate) {
+		return 0;
+	}
+
+	std::memcpy(_buffer, race_->alternate_buffer.data(), race_->alternate_buffer.size());
+	return race_->alternate_buffer.size();
+} // read
+
+auto irods::s3::hedged_read::take_alternate() -> std::unique_ptr<replica_stream>
+{
+	std::lock_guard lk{race_->mutex};
+	return std::move(race_->alternate);
+} // take_alternate
+
+auto irods::s3::hedged_read::start_alternate(std::shared_ptr<race> _race) -> void
+{
+	++g_hedges;
+	logging::debug(
+		"{}: First bytes of [{}] did not arrive within [{}] ms. Reading another replica.",
+		__func__,
+		_race->path.c_str(),
+		_race->delay.count());
+
+	irods::http::globals::background_task([r = std::move(_race), fn = __func__] {
+		const irods::s3::rpc_profiler::scope scope{r->profile};
+
+		{
+			std::lock_guard lk{r->mutex};
+			if (r->winner != race::winner_type::none) {
+				return;
+			}
+			r->alternate_running = true;
+		}
+
+		// Returns true if the alternate read may go on.
+		const auto still_racing = [&r] {
+			std::lock_guard lk{r->mutex};
+			return r->winner == race::winner_type::none;
+		};
+
+		std::unique_ptr<replica_stream> s;
+		std::vector<char> buffer;
+		bool succeeded = false;
+
+		try {
+			s = std::make_unique<replica_stream>(irods::s3::get_data_connection(
+				r->client_username, r->path, irods::s3::data_transfer_direction::read));
+
+			const auto replicas = irods::s3::get_good_replica_numbers(*s->conn, r->path);
+			const auto iter = std::find_if(std::begin(replicas), std::end(replicas), [&r](int _replica) {
+				return _replica != r->primary_replica;
+			});
+
+			if (iter == std::end(replicas)) {
+				logging::debug("{}: [{}] has no other good replica.", fn, r->path.c_str());
+			}
+			else {
+				{
+					std::lock_guard lk{r->mutex};
+					if (r->winner == race::winner_type::none) {
+						r->alternate_socket = static_cast<RcComm&>(*s->conn).sock;
+					}
+				}
+
+				irods::s3::rpc_profiler::timer open_timer{"DATA_OBJ_OPEN"};
+				s->in.open(s->xtrans, r->path, io::replica_number{*iter}, std::ios_base::in);
+				open_timer.stop(!s->in.is_open());
+
+				if (s->in.is_open() && still_racing()) {
+					const irods::s3::rpc_profiler::timer read_timer{"DATA_OBJ_READ"};
+					buffer.resize(r->count);
+					s->in.seekg(static_cast<std::streamoff>(r->offset));
+					s->in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+					buffer.resize(static_cast<std::size_t>(std::max<std::streamsize>(s->in.gcount(), 0)));
+					succeeded = !s->in.bad() && !buffer.empty();
+				}
+			}
+		}
+		catch (const std::exception& e) {
+			logging::error("{}: Could not read another replica of [{}]: {}", fn, r->path.c_str(), e.what());
+		}
+
+		{
+			std::lock_guard lk{r->mutex};
+			r->alternate_socket = -1;
+			r->alternate_done = true;
+
+			if (succeeded && r->winner == race::winner_type::none) {
+				r->winner = race::winner_type::alternate;
+				r->alternate = std::move(s);
+				r->alternate_buffer = std::move(buffer);
+				shut_down(r->primary_socket);
+				++g_alternate_wins;
+			}
+			else if (!succeeded && r->winner == race::winner_type::none) {
+				++g_failed_hedges;
+			}
+		}
+
+		r->cv.notify_all();
+
+		// The alternate lost or failed, so it is closed.
+		if (s) {
+			if (s->in.is_open()) {
+				irods::s3::rpc_profiler::timed("DATA_OBJ_CLOSE", [&s] { s->in.close(); });
+			}
+			s->conn->disconnect();
+		}
+	});
+} // start_alternate
+
+auto irods::s3::hedged_reads::delay_for(const std::string& _bucket) -> std::optional<std::chrono::milliseconds>
+{
+	if (!irods::s3::get_hedged_reads_enabled(_bucket)) {
+		return std::nullopt;
+	}
+
+	const auto min_delay = std::chrono::milliseconds{irods::s3::get_hedged_reads_min_delay_in_milliseconds()};
+	const auto max_delay =
+		std::max(min_delay, std::chrono::milliseconds{irods::s3::get_hedged_reads_max_delay_in_milliseconds()});
+
+	const auto latency = latency_percentile(irods::s3::get_hedged_reads_latency_percentile(_bucket));
+	if (!latency) {
+		return max_delay;
+	}
+
+	return std::clamp(std::chrono::ceil<std::chrono::milliseconds>(*latency), min_delay, max_delay);
+} // delay_for
+
+auto irods::s3::hedged_reads::stats() -> statistics
+{
+	statistics result;
+	result.reads = g_reads.load();
+	result.hedges = g_hedges.load();
+	result.alternate_wins = g_alternate_wins.load();
+	result.failed_hedges = g_failed_hedges.load();
+	return result;
+} // stats
+
+auto irods::s3::hedged_reads::log_report() -> void
+{
+	const auto s = stats();
+
+	logging::info(
+		"{}: Hedged [{}] of [{}] reads. The alternate replica won [{}] times and failed [{}] times.",
+		__func__,
+		s.hedges,
+		s.reads,
+		s.alternate_wins,
+		s.failed_hedges);
+} // log_report
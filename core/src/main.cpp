@@ -1,10 +1,19 @@
 #include "irods/private/s3_api/common.hpp"
+#include "irods/private/s3_api/archive.hpp"
+#include "irods/private/s3_api/disk_cache.hpp"
+#include "irods/private/s3_api/hedged_read.hpp"
 #include "irods/private/s3_api/globals.hpp"
 #include "irods/private/s3_api/handlers.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_cache.hpp"
+#include "irods/private/s3_api/open_handle_cache.hpp"
+#include "irods/private/s3_api/prefetch.hpp"
 #include "irods/private/s3_api/session.hpp"
 #include "irods/private/s3_api/transport.hpp"
+#include "irods/private/s3_api/vault_read.hpp"
+#include "irods/private/s3_api/zerocopy.hpp"
 #include "irods/private/s3_api/process_stash.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/version.hpp"
 #include "irods/private/s3_api/configuration.hpp"
 
@@ -42,9 +51,11 @@
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string_view>
 #include <system_error>
@@ -231,12 +242,162 @@ constexpr auto default_jsonschema() -> std::string_view
                         "timeout_in_seconds"
                     ]
                 }},
+                "rpc_profiling": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }}
+                }},
+                "object_cache": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "capacity_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "max_object_size_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "shards": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }}
+                }},
+                "disk_cache": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "directory": {{
+                            "type": "string"
+                        }},
+                        "capacity_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "min_object_size_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }},
+                    "required": [
+                        "directory"
+                    ]
+                }},
+                "prefetch": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "object_count": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "max_bytes_in_flight": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "max_bytes_per_second": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }},
+                        "listing_ttl_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "threads": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }}
+                }},
+                "open_handle_cache": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "max_handles": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "idle_timeout_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "max_age_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }}
+                }},
+                "zerocopy": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "min_response_size_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }},
+                        "min_write_size_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }}
+                }},
                 "background_io": {{
                     "type": "object",
                     "properties": {{
                         "threads": {{
                             "type": "integer",
                             "minimum": 1
+                        }},
+                        "metadata_threads": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "compute_threads": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "transfer_threads": {{
+                            "type": "integer",
+                            "minimum": 1
                         }}
                     }},
                     "required": [
@@ -342,6 +503,128 @@ constexpr auto default_jsonschema() -> std::string_view
                 "resource": {{
                     "type": "string"
                 }},
+                "enable_data_redirection": {{
+                    "type": "boolean"
+                }},
+                "replica_selection": {{
+                    "type": "object",
+                    "properties": {{
+                        "policy": {{
+                            "type": "string",
+                            "enum": [
+                                "resource",
+                                "nearest",
+                                "fastest",
+                                "least_loaded"
+                            ]
+                        }},
+                        "local_hosts": {{
+                            "type": "array",
+                            "items": {{
+                                "type": "string"
+                            }}
+                        }}
+                    }}
+                }},
+                "direct_vault_reads": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }}
+                }},
+                "parallel_transfer": {{
+                    "type": "object",
+                    "properties": {{
+                        "threshold_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }},
+                        "streams": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "block_size_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "max_buffered_blocks": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "spread_reads_across_replicas": {{
+                            "type": "boolean"
+                        }}
+                    }}
+                }},
+                "hedged_reads": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "latency_percentile": {{
+                            "type": "number",
+                            "minimum": 0,
+                            "maximum": 100
+                        }},
+                        "min_delay_in_milliseconds": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }},
+                        "max_delay_in_milliseconds": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }},
+                        "buckets": {{
+                            "type": "object",
+                            "additionalProperties": {{
+                                "type": "object",
+                                "properties": {{
+                                    "enabled": {{
+                                        "type": "boolean"
+                                    }},
+                                    "latency_percentile": {{
+                                        "type": "number",
+                                        "minimum": 0,
+                                        "maximum": 100
+                                    }}
+                                }}
+                            }}
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }}
+                }},
+                "archive": {{
+                    "type": "object",
+                    "properties": {{
+                        "archive_resources": {{
+                            "type": "array",
+                            "items": {{
+                                "type": "string"
+                            }}
+                        }},
+                        "stage_resource": {{
+                            "type": "string"
+                        }},
+                        "restore_threads": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }},
+                        "report_interval_in_seconds": {{
+                            "type": "integer",
+                            "minimum": 1
+                        }}
+                    }}
+                }},
                 "put_object_buffer_size_in_bytes": {{
                     "type": "integer",
                     "minimum": 1
@@ -349,6 +632,47 @@ constexpr auto default_jsonschema() -> std::string_view
                 "get_object_buffer_size_in_bytes": {{
                     "type": "integer",
                     "minimum": 1
+                }},
+                "get_object_read_ahead_in_bytes": {{
+                    "type": "integer",
+                    "minimum": 0
+                }},
+                "get_object_small_object_threshold_in_bytes": {{
+                    "type": "integer",
+                    "minimum": 0,
+                    "maximum": 33554432
+                }},
+                "get_object_coalescing": {{
+                    "type": "object",
+                    "properties": {{
+                        "enabled": {{
+                            "type": "boolean"
+                        }},
+                        "max_object_size_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }},
+                        "budget_in_bytes": {{
+                            "type": "integer",
+                            "minimum": 0
+                        }}
+                    }}
+                }},
+                "max_transfer_buffer_size_in_bytes": {{
+                    "type": "integer",
+                    "minimum": 1
+                }},
+                "transfer_buffer_budget_in_bytes": {{
+                    "type": "integer",
+                    "minimum": 0
+                }},
+                "get_object_checksum_policy": {{
+                    "type": "string",
+                    "enum": [
+                        "catalog",
+                        "none",
+                        "compute_async"
+                    ]
                 }}
             }},
             "required": [
@@ -418,8 +742,57 @@ auto print_configuration_template() -> void
             "timeout_in_seconds": 30
         }},
 
+        "rpc_profiling": {{
+            "enabled": false,
+            "report_interval_in_seconds": 60
+        }},
+
+        "object_cache": {{
+            "enabled": false,
+            "capacity_in_bytes": 268435456,
+            "max_object_size_in_bytes": 4194304,
+            "shards": 16,
+            "report_interval_in_seconds": 60
+        }},
+
+        "disk_cache": {{
+            "enabled": false,
+            "directory": "<string>",
+            "capacity_in_bytes": 68719476736,
+            "min_object_size_in_bytes": 4194304,
+            "report_interval_in_seconds": 60
+        }},
+
+        "prefetch": {{
+            "enabled": false,
+            "object_count": 4,
+            "max_bytes_in_flight": 67108864,
+            "max_bytes_per_second": 104857600,
+            "listing_ttl_in_seconds": 300,
+            "threads": 2,
+            "report_interval_in_seconds": 60
+        }},
+
+        "open_handle_cache": {{
+            "enabled": false,
+            "max_handles": 64,
+            "idle_timeout_in_seconds": 5,
+            "max_age_in_seconds": 60,
+            "report_interval_in_seconds": 60
+        }},
+
+        "zerocopy": {{
+            "enabled": false,
+            "min_response_size_in_bytes": 1048576,
+            "min_write_size_in_bytes": 16384,
+            "report_interval_in_seconds": 60
+        }},
+
         "background_io": {{
-            "threads": 6
+            "threads": 6,
+            "metadata_threads": 2,
+            "compute_threads": 2,
+            "transfer_threads": 8
         }}
     }},
 
@@ -452,8 +825,54 @@ auto print_configuration_template() -> void
 
         "resource": "<string>",
 
+        "enable_data_redirection": false,
+
+        "replica_selection": {{
+            "policy": "resource",
+            "local_hosts": []
+        }},
+
+        "direct_vault_reads": {{
+            "enabled": false,
+            "report_interval_in_seconds": 60
+        }},
+
+        "parallel_transfer": {{
+            "threshold_in_bytes": 33554432,
+            "streams": 1,
+            "block_size_in_bytes": 4194304,
+            "max_buffered_blocks": 8,
+            "spread_reads_across_replicas": false
+        }},
+
+        "hedged_reads": {{
+            "enabled": false,
+            "latency_percentile": 95,
+            "min_delay_in_milliseconds": 10,
+            "max_delay_in_milliseconds": 1000,
+            "buckets": {{}},
+            "report_interval_in_seconds": 60
+        }},
+
+        "archive": {{
+            "archive_resources": [],
+            "stage_resource": "<string>",
+            "restore_threads": 2,
+            "report_interval_in_seconds": 60
+        }},
+
         "put_object_buffer_size_in_bytes": 8192,
-        "get_object_buffer_size_in_bytes": 8192
+        "get_object_buffer_size_in_bytes": 8192,
+        "get_object_read_ahead_in_bytes": 1048576,
+        "get_object_small_object_threshold_in_bytes": 0,
+        "get_object_coalescing": {{
+            "enabled": false,
+            "max_object_size_in_bytes": 16777216,
+            "budget_in_bytes": 268435456
+        }},
+        "max_transfer_buffer_size_in_bytes": 4194304,
+        "transfer_buffer_budget_in_bytes": 268435456,
+        "get_object_checksum_policy": "catalog"
     }}
 }}
 )");
@@ -675,6 +1094,38 @@ class process_stash_eviction_manager
 	} // evict
 }; // class process_stash_eviction_manager
 
+// Writes a report to the log at a fixed interval.
+class periodic_reporter
+{
+	net::steady_timer timer_;
+	std::chrono::seconds interval_;
+	std::function<void()> report_;
+
+  public:
+	periodic_reporter(net::io_context& _io, std::chrono::seconds _report_interval, std::function<void()> _report)
+		: timer_{_io}
+		, interval_{_report_interval}
+		, report_{std::move(_report)}
+	{
+		report();
+	} // constructor
+
+  private:
+	auto report() -> void
+	{
+		timer_.expires_after(interval_);
+		timer_.async_wait([this](const auto& _ec) {
+			if (_ec) {
+				return;
+			}
+
+			report_();
+
+			report();
+		});
+	} // report
+}; // class periodic_reporter
+
 auto main(int _argc, char* _argv[]) -> int
 {
 	po::options_description opts_desc{""};
@@ -801,6 +1252,25 @@ auto main(int _argc, char* _argv[]) -> int
 			std::max(s3_server_config.at(json::json_pointer{"/background_io/threads"}).get<int>(), 1));
 		irods::http::globals::set_background_thread_pool(io_threads);
 
+		// Catalog operations and CPU bound work get their own threads so that they are never
+		// queued behind bulk data movement.
+		logging::trace("Initializing thread pool for metadata tasks.");
+		net::thread_pool metadata_threads(
+			std::max(s3_server_config.value(json::json_pointer{"/background_io/metadata_threads"}, 2), 1));
+		irods::http::globals::set_metadata_thread_pool(metadata_threads);
+
+		logging::trace("Initializing thread pool for compute tasks.");
+		net::thread_pool compute_threads(
+			std::max(s3_server_config.value(json::json_pointer{"/background_io/compute_threads"}, 2), 1));
+		irods::http::globals::set_compute_thread_pool(compute_threads);
+
+		// The streams of parallel transfers share one pool, so the number of iRODS data streams in
+		// use at once does not grow with the number of concurrent transfers.
+		logging::trace("Initializing thread pool for parallel transfer streams.");
+		net::thread_pool transfer_threads(
+			std::max(s3_server_config.value(json::json_pointer{"/background_io/transfer_threads"}, 8), 1));
+		irods::http::globals::set_transfer_thread_pool(transfer_threads);
+
 		// Run the I/O service on the requested number of threads.
 		logging::trace("Initializing thread pool for HTTP requests.");
 		net::thread_pool request_handler_threads(request_thread_count);
@@ -820,11 +1290,158 @@ auto main(int _argc, char* _argv[]) -> int
 			s3_server_config.at(json::json_pointer{"/authentication/eviction_check_interval_in_seconds"}).get<int>();
 		process_stash_eviction_manager eviction_mgr{ioc, std::chrono::seconds{eviction_check_interval}};
 
+		// Launch the periodic report of iRODS API calls made per S3 operation.
+		std::optional<periodic_reporter> rpc_reporter;
+		if (s3_server_config.value(json::json_pointer{"/rpc_profiling/enabled"}, false)) {
+			irods::s3::rpc_profiler::set_enabled(true);
+			const auto report_interval =
+				s3_server_config.value(json::json_pointer{"/rpc_profiling/report_interval_in_seconds"}, 60);
+			rpc_reporter.emplace(
+				ioc, std::chrono::seconds{std::max(report_interval, 1)}, irods::s3::rpc_profiler::log_report);
+		}
+
+		// Frequently read small objects are served from memory.
+		std::optional<irods::s3::object_cache> object_cache;
+		std::optional<periodic_reporter> object_cache_reporter;
+		if (s3_server_config.value(json::json_pointer{"/object_cache/enabled"}, false)) {
+			logging::trace("Initializing object cache.");
+			object_cache.emplace(
+				s3_server_config.value(json::json_pointer{"/object_cache/capacity_in_bytes"}, 268435456ULL),
+				s3_server_config.value(json::json_pointer{"/object_cache/max_object_size_in_bytes"}, 4194304ULL),
+				s3_server_config.value(json::json_pointer{"/object_cache/shards"}, 16ULL));
+			irods::http::globals::set_object_cache(&*object_cache);
+
+			const auto report_interval =
+				s3_server_config.value(json::json_pointer{"/object_cache/report_interval_in_seconds"}, 60);
+			object_cache_reporter.emplace(ioc, std::chrono::seconds{std::max(report_interval, 1)}, [&object_cache] {
+				object_cache->log_report();
+			});
+		}
+
+		// Large objects which are read repeatedly are copied to local disk and served with sendfile.
+		std::optional<irods::s3::disk_cache> disk_cache;
+		std::optional<periodic_reporter> disk_cache_reporter;
+		if (s3_server_config.value(json::json_pointer{"/disk_cache/enabled"}, false)) {
+			logging::trace("Initializing disk cache.");
+			disk_cache.emplace(
+				s3_server_config.at(json::json_pointer{"/disk_cache/directory"}).get<std::string>(),
+				s3_server_config.value(json::json_pointer{"/disk_cache/capacity_in_bytes"}, 68719476736ULL),
+				s3_server_config.value(json::json_pointer{"/disk_cache/min_object_size_in_bytes"}, 4194304ULL));
+			irods::http::globals::set_disk_cache(&*disk_cache);
+
+			const auto report_interval =
+				s3_server_config.value(json::json_pointer{"/disk_cache/report_interval_in_seconds"}, 60);
+			disk_cache_reporter.emplace(ioc, std::chrono::seconds{std::max(report_interval, 1)}, [&disk_cache] {
+				disk_cache->log_report();
+			});
+		}
+
+		// Objects a client is about to download after listing them are read into the caches ahead of time.
+		std::optional<irods::s3::prefetcher> prefetcher;
+		std::optional<periodic_reporter> prefetcher_reporter;
+		if (s3_server_config.value(json::json_pointer{"/prefetch/enabled"}, false) && (object_cache || disk_cache)) {
+			logging::trace("Initializing prefetcher.");
+			irods::s3::prefetcher::options options;
+			options.object_count = s3_server_config.value(json::json_pointer{"/prefetch/object_count"}, 4ULL);
+			options.max_bytes_in_flight =
+				s3_server_config.value(json::json_pointer{"/prefetch/max_bytes_in_flight"}, 67108864ULL);
+			options.max_bytes_per_second =
+				s3_server_config.value(json::json_pointer{"/prefetch/max_bytes_per_second"}, 104857600ULL);
+			options.listing_ttl = std::chrono::seconds{
+				s3_server_config.value(json::json_pointer{"/prefetch/listing_ttl_in_seconds"}, 300)};
+			options.thread_count = s3_server_config.value(json::json_pointer{"/prefetch/threads"}, 2ULL);
+			prefetcher.emplace(options);
+			irods::http::globals::set_prefetcher(&*prefetcher);
+
+			const auto report_interval =
+				s3_server_config.value(json::json_pointer{"/prefetch/report_interval_in_seconds"}, 60);
+			prefetcher_reporter.emplace(ioc, std::chrono::seconds{std::max(report_interval, 1)}, [&prefetcher] {
+				prefetcher->log_report();
+			});
+		}
+
+		// Ranged GetObject requests reuse data objects left open by earlier requests.
+		std::optional<irods::s3::open_handle_cache> open_handle_cache;
+		std::optional<periodic_reporter> open_handle_cache_reporter;
+		std::optional<periodic_reporter> open_handle_cache_sweeper;
+		if (s3_server_config.value(json::json_pointer{"/open_handle_cache/enabled"}, false)) {
+			logging::trace("Initializing open handle cache.");
+			irods::s3::open_handle_cache::options options;
+			options.max_handles = s3_server_config.value(json::json_pointer{"/open_handle_cache/max_handles"}, 64ULL);
+			options.idle_timeout = std::chrono::seconds{
+				s3_server_config.value(json::json_pointer{"/open_handle_cache/idle_timeout_in_seconds"}, 5)};
+			options.max_age = std::chrono::seconds{
+				s3_server_config.value(json::json_pointer{"/open_handle_cache/max_age_in_seconds"}, 60)};
+			open_handle_cache.emplace(options);
+			irods::http::globals::set_open_handle_cache(&*open_handle_cache);
+
+			const auto report_interval =
+				s3_server_config.value(json::json_pointer{"/open_handle_cache/report_interval_in_seconds"}, 60);
+			open_handle_cache_reporter.emplace(
+				ioc, std::chrono::seconds{std::max(report_interval, 1)}, [&open_handle_cache] {
+					open_handle_cache->log_report();
+				});
+
+			// Idle handles hold connections to iRODS, so they are closed even while no requests arrive.
+			// Closing them talks to iRODS, which is kept off the I/O threads.
+			open_handle_cache_sweeper.emplace(ioc, std::chrono::seconds{1}, [&open_handle_cache] {
+				irods::http::globals::background_task([&open_handle_cache] { open_handle_cache->expire(); });
+			});
+		}
+
+		// Report the CPU time used per GB of GetObject bodies, with MSG_ZEROCOPY enabled or disabled.
+		std::optional<periodic_reporter> zerocopy_reporter;
+		if (const auto zerocopy = s3_server_config.value(json::json_pointer{"/zerocopy"}, json::object());
+		    !zerocopy.empty())
+		{
+			const auto report_interval = zerocopy.value("report_interval_in_seconds", 60);
+			zerocopy_reporter.emplace(
+				ioc, std::chrono::seconds{std::max(report_interval, 1)}, irods::s3::zerocopy::log_report);
+		}
+
+		// Archived objects are staged for RestoreObject on threads of their own.
+		std::optional<irods::s3::restore_queue> restore_queue;
+		std::optional<periodic_reporter> restore_queue_reporter;
+		if (const auto archive = config.value(json::json_pointer{"/irods_client/archive"}, json::object());
+		    !archive.value("archive_resources", json::array()).empty())
+		{
+			logging::trace("Initializing restore queue.");
+			restore_queue.emplace(std::max(archive.value("restore_threads", 2), 1));
+			irods::http::globals::set_restore_queue(&*restore_queue);
+
+			const auto report_interval = archive.value("report_interval_in_seconds", 60);
+			restore_queue_reporter.emplace(ioc, std::chrono::seconds{std::max(report_interval, 1)}, [&restore_queue] {
+				restore_queue->log_report();
+			});
+		}
+
+		// Report how often GetObject reads are hedged against a second replica.
+		std::optional<periodic_reporter> hedged_reads_reporter;
+		if (const auto hedged_reads = config.value(json::json_pointer{"/irods_client/hedged_reads"}, json::object());
+		    hedged_reads.value("enabled", false) || !hedged_reads.value("buckets", json::object()).empty())
+		{
+			const auto report_interval = hedged_reads.value("report_interval_in_seconds", 60);
+			hedged_reads_reporter.emplace(
+				ioc, std::chrono::seconds{std::max(report_interval, 1)}, irods::s3::hedged_reads::log_report);
+		}
+
+		// Report how many GetObject requests were served from a vault on this host.
+		std::optional<periodic_reporter> vault_reads_reporter;
+		const auto vault_reads = config.value(json::json_pointer{"/irods_client/direct_vault_reads"}, json::object());
+		if (vault_reads.value("enabled", false)) {
+			const auto report_interval = vault_reads.value("report_interval_in_seconds", 60);
+			vault_reads_reporter.emplace(
+				ioc, std::chrono::seconds{std::max(report_interval, 1)}, irods::s3::vault_reads::log_report);
+		}
+
 		logging::info("Server is ready.");
 		ioc.run();
 
 		request_handler_threads.stop();
 		io_threads.stop();
+		metadata_threads.stop();
+		compute_threads.stop();
+		transfer_threads.stop();
 
 		logging::trace("Waiting for HTTP requests thread pool to shut down.");
 		request_handler_threads.join();
@@ -832,6 +1449,21 @@ auto main(int _argc, char* _argv[]) -> int
 		logging::trace("Waiting for I/O thread pool to shut down.");
 		io_threads.join();
 
+		logging::trace("Waiting for metadata thread pool to shut down.");
+		metadata_threads.join();
+
+		logging::trace("Waiting for compute thread pool to shut down.");
+		compute_threads.join();
+
+		logging::trace("Waiting for parallel transfer thread pool to shut down.");
+		transfer_threads.join();
+
+		irods::http::globals::set_object_cache(nullptr);
+		irods::http::globals::set_disk_cache(nullptr);
+		irods::http::globals::set_restore_queue(nullptr);
+		irods::http::globals::set_prefetcher(nullptr);
+		irods::http::globals::set_open_handle_cache(nullptr);
+
 		logging::info("Shutdown complete.");
 
 		return 0;
@@ -0,0 +1,387 @@
+#include "irods/private/s3_api/object_cache.hpp"
+#include "irods/private/s3_api/disk_cache.hpp"
+#include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/open_handle_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// Estimates how often a key has been requested recently.
+	//
+	// A count-min sketch with four rows of 8-bit counters. Once the number of increments reaches
+	// ten times the width, every counter is halved so that old requests weigh less than new ones.
+	class frequency_sketch
+	{
+	  public:
+		explicit frequency_sketch(std::size_t _width)
+			: width_{std::bit_ceil(std::max<std::size_t>(_width, 64))}
+			, counters_(width_ * rows)
+		{
+		}
+
+		auto increment(std::size_t _hash) -> void
+		{
+			for (std::size_t row = 0; row < rows; ++row) {
+				auto& counter = counters_[row * width_ + index(_hash, row)];
+				if (counter < UINT8_MAX) {
+					++counter;
+				}
+			}
+
+			if (++additions_ >= width_ * 10) {
+				for (auto& counter : counters_) {
+					counter /= 2;
+				}
+				additions_ /= 2;
+			}
+		} // increment
+
+		auto estimate(std::size_t _hash) const -> std::uint8_t
+		{
+			std::uint8_t result = UINT8_MAX;
+			for (std::size_t row = 0; row < rows; ++row) {
+				result = std::min(result, counters_[row * width_ + index(_hash, row)]);
+			}
+			return result;
+		} // estimate
+
+	  private:
+		static constexpr std::size_t rows = 4;
+
+		auto index(std::size_t _hash, std::size_t _row) const -> std::size_t
+		{
+			static constexpr std::array<std::uint64_t, rows> seeds{
+				0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL, 0x94d049bb133111ebULL, 0xd6e8feb86659fd93ULL};
+
+			auto h = (static_cast<std::uint64_t>(_hash) + seeds[_row]) * seeds[(_row + 1) % rows];
+			h ^= h >> 32;
+			return static_cast<std::size_t>(h) & (width_ - 1);
+		} // index
+
+		std::size_t width_;
+		std::vector<std::uint8_t> counters_;
+		std::size_t additions_ = 0;
+	}; // class frequency_sketch
+} // anonymous namespace
+
+class irods::s3::object_cache::shard
+{
+  public:
+	shard(std::uint64_t _capacity, std::uint64_t _max_object_size)
+		: window_capacity_{std::max(_capacity / 100, _max_object_size)}
+		, main_capacity_{_capacity - window_capacity_}
+		, protected_capacity_{main_capacity_ * 4 / 5}
+		, sketch_{static_cast<std::size_t>(std::min<std::uint64_t>(_capacity / 4096, 1 << 20))}
+	{
+	}
+
+	auto find(const std::string& _path, const version& _version) -> std::shared_ptr<const std::vector<char>>
+	{
+		const auto hash = std::hash<std::string>{}(_path);
+
+		std::lock_guard lk{mutex_};
+		sketch_.increment(hash);
+
+		const auto iter = index_.find(_path);
+		if (iter == std::end(index_)) {
+			return nullptr;
+		}
+
+		if (iter->second->current_version != _version) {
+			erase(iter->second);
+			return nullptr;
+		}
+
+		touch(iter->second);
+		return iter->second->data;
+	} // find
+
+	auto insert(const std::string& _path, const version& _version, std::shared_ptr<const std::vector<char>> _data)
+		-> void
+	{
+		std::lock_guard lk{mutex_};
+
+		if (const auto iter = index_.find(_path); iter != std::end(index_)) {
+			erase(iter->second);
+		}
+
+		const auto size = _data->size();
+		window_.push_front({_path, std::hash<std::string>{}(_path), _version, std::move(_data), segment::window});
+		index_[_path] = std::begin(window_);
+		window_size_ += size;
+
+		// Objects leaving the window compete for a place in the main segment.
+		while (window_size_ > window_capacity_) {
+			const auto candidate = std::prev(std::end(window_));
+			candidate->where = segment::probation;
+			probation_.splice(std::begin(probation_), window_, candidate);
+			window_size_ -= candidate->data->size();
+			probation_size_ += candidate->data->size();
+			admit(candidate);
+		}
+	} // insert
+
+	auto contains(const std::string& _path, const version& _version) const -> bool
+	{
+		std::lock_guard lk{mutex_};
+
+		const auto iter = index_.find(_path);
+		return iter != std::end(index_) && iter->second->current_version == _version;
+	} // contains
+
+	auto invalidate(const std::string& _path) -> void
+	{
+		std::lock_guard lk{mutex_};
+
+		if (const auto iter = index_.find(_path); iter != std::end(index_)) {
+			erase(iter->second);
+		}
+	} // invalidate
+
+	auto add_stats(statistics& _stats) const -> void
+	{
+		std::lock_guard lk{mutex_};
+		_stats.entries += index_.size();
+		_stats.size_in_bytes += window_size_ + probation_size_ + protected_size_;
+	} // add_stats
+
+  private:
+	enum class segment
+	{
+		window,
+		probation,
+		protected_
+	};
+
+	struct entry
+	{
+		std::string path;
+		std::size_t hash;
+		version current_version;
+		std::shared_ptr<const std::vector<char>> data;
+		segment where;
+	};
+
+	using entry_list = std::list<entry>;
+
+	// Evicts from the main segment until _candidate, which has just been placed at the front of
+	// the probation segment, fits. The candidate is dropped instead if it is not requested more
+	// often than the entry it would displace.
+	auto admit(entry_list::iterator _candidate) -> void
+	{
+		const auto candidate_frequency = sketch_.estimate(_candidate->hash);
+
+		while (probation_size_ + protected_size_ > main_capacity_) {
+			auto& victims = (probation_.size() > 1) ? probation_ : protected_;
+			if (victims.empty()) {
+				break;
+			}
+
+			const auto victim = std::prev(std::end(victims));
+			if (victim == _candidate) {
+				break;
+			}
+
+			if (candidate_frequency <= sketch_.estimate(victim->hash)) {
+				erase(_candidate);
+				return;
+			}
+
+			erase(victim);
+		}
+	} // admit
+
+	// Records a hit on an entry.
+	auto touch(entry_list::iterator _entry) -> void
+	{
+		switch (_entry->where) {
+			case segment::window:
+				window_.splice(std::begin(window_), window_, _entry);
+				break;
+
+			case segment::protected_:
+				protected_.splice(std::begin(protected_), protected_, _entry);
+				break;
+
+			case segment::probation:
+				// A second request promotes the entry. The protected segment overflows into the
+				// probation segment.
+				_entry->where = segment::protected_;
+				protected_.splice(std::begin(protected_), probation_, _entry);
+				probation_size_ -= _entry->data->size();
+				protected_size_ += _entry->data->size();
+
+				while (protected_size_ > protected_capacity_) {
+					const auto demoted = std::prev(std::end(protected_));
+					demoted->where = segment::probation;
+					probation_.splice(std::begin(probation_), protected_, demoted);
+					protected_size_ -= demoted->data->size();
+					probation_size_ += demoted->data->size();
+				}
+				break;
+		}
+	} // touch
+
+	auto erase(entry_list::iterator _entry) -> void
+	{
+		const auto size = _entry->data->size();
+		index_.erase(_entry->path);
+
+		switch (_entry->where) {
+			case segment::window:
+				window_size_ -= size;
+				window_.erase(_entry);
+				break;
+
+			case segment::probation:
+				probation_size_ -= size;
+				probation_.erase(_entry);
+				break;
+
+			case segment::protected_:
+				protected_size_ -= size;
+				protected_.erase(_entry);
+				break;
+		}
+	} // erase
+
+	const std::uint64_t window_capacity_;
+	const std::uint64_t main_capacity_;
+	const std::uint64_t protected_capacity_;
+
+	mutable std::mutex mutex_;
+	frequency_sketch sketch_;
+	std::unordered_map<std::string, entry_list::iterator> index_;
+	entry_list window_;
+	entry_list probation_;
+	entry_list protected_;
+	std::uint64_t window_size_ = 0;
+	std::uint64_t probation_size_ = 0;
+	std::uint64_t protected_size_ = 0;
+}; // class object_cache::shard
+
+irods::s3::object_cache::object_cache(
+	std::uint64_t _capacity_in_bytes,
+	std::uint64_t _max_object_size_in_bytes,
+	std::size_t _shard_count)
+	: max_object_size_{std::max<std::uint64_t>(_max_object_size_in_bytes, 1)}
+{
+	// Every shard must be able to hold its window and at least one object in the main segment.
+	const auto max_shards = std::max<std::uint64_t>(_capacity_in_bytes / (2 * max_object_size_), 1);
+	const auto shard_count = static_cast<std::size_t>(std::clamp<std::uint64_t>(_shard_count, 1, max_shards));
+	const auto shard_capacity = std::max(_capacity_in_bytes / shard_count, 2 * max_object_size_);
+
+	shards_.reserve(shard_count);
+	for (std::size_t i = 0; i < shard_count; ++i) {
+		shards_.push_back(std::make_unique<shard>(shard_capacity, max_object_size_));
+	}
+
+	logging::info(
+		"{}: Caching objects of up to [{}] bytes in [{}] shards of [{}] bytes.",
+		__func__,
+		max_object_size_,
+		shard_count,
+		shard_capacity);
+} // constructor
+
+irods::s3::object_cache::~object_cache() = default;
+
+auto irods::s3::object_cache::max_object_size_in_bytes() const noexcept -> std::uint64_t
+{
+	return max_object_size_;
+} // max_object_size_in_bytes
+
+auto irods::s3::object_cache::find(const std::string& _path, const version& _version)
+	-> std::shared_ptr<const std::vector<char>>
+{
+	auto data = shard_for(_path).find(_path, _version);
+	++(data ? hits_ : misses_);
+	return data;
+} // find
+
+auto irods::s3::object_cache::insert(
+	const std::string& _path,
+	const version& _version,
+	std::shared_ptr<const std::vector<char>> _data) -> void
+{
+	if (!_data || _data->size() > max_object_size_) {
+		return;
+	}
+
+	shard_for(_path).insert(_path, _version, std::move(_data));
+} // insert
+
+auto irods::s3::object_cache::contains(const std::string& _path, const version& _version) const -> bool
+{
+	return shard_for(_path).contains(_path, _version);
+} // contains
+
+auto irods::s3::object_cache::invalidate(const std::string& _path) -> void
+{
+	shard_for(_path).invalidate(_path);
+} // invalidate
+
+auto irods::s3::object_cache::record_bytes_saved(std::uint64_t _bytes) noexcept -> void
+{
+	bytes_saved_ += _bytes;
+} // record_bytes_saved
+
+auto irods::s3::object_cache::stats() const -> statistics
+{
+	statistics result;
+	result.hits = hits_.load();
+	result.misses = misses_.load();
+	result.bytes_saved = bytes_saved_.load();
+
+	for (const auto& s : shards_) {
+		s->add_stats(result);
+	}
+
+	return result;
+} // stats
+
+auto irods::s3::object_cache::log_report() const -> void
+{
+	const auto s = stats();
+	const auto lookups = s.hits + s.misses;
+
+	logging::info(
+		"{}: Object cache hit ratio [{:.3f}] ([{}] of [{}] lookups), [{}] bytes saved, [{}] entries using [{}] bytes.",
+		__func__,
+		lookups > 0 ? static_cast<double>(s.hits) / static_cast<double>(lookups) : 0.0,
+		s.hits,
+		lookups,
+		s.bytes_saved,
+		s.entries,
+		s.size_in_bytes);
+} // log_report
+
+auto irods::s3::object_cache::shard_for(const std::string& _path) const -> shard&
+{
+	return *shards_[std::hash<std::string>{}(_path) % shards_.size()];
+} // shard_for
+
+auto irods::s3::invalidate_cached_object(const std::string& _path) -> void
+{
+	if (auto* cache = irods::http::globals::object_cache(); cache) {
+		cache->invalidate(_path);
+	}
+
+	if (auto* cache = irods::http::globals::disk_cache(); cache) {
+		cache->invalidate(_path);
+	}
+
+	if (auto* cache = irods::http::globals::open_handle_cache(); cache) {
+		cache->invalidate(_path);
+	}
+} // invalidate_cached_object
@@ -0,0 +1,222 @@
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/common.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+#include "irods/private/s3_api/singleflight.hpp"
+
+#include <irods/irods_exception.hpp>
+#include <irods/irods_query.hpp>
+#include <irods/query_builder.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// Concurrent lookups of the same object by the same user share a single query.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	irods::s3::singleflight<std::optional<irods::s3::object_stat>> g_stat_calls;
+
+	// False if the exception concerns the connection the lookup ran on rather than the object, in
+	// which case callers sharing the lookup run it on their own connections.
+	auto is_shareable_error(const std::exception_ptr& _e) -> bool
+	{
+		try {
+			std::rethrow_exception(_e);
+		}
+		catch (const irods::exception& e) {
+			return !irods::is_connection_error(static_cast<int>(e.code()));
+		}
+		catch (const std::system_error& e) {
+			return !irods::is_connection_error(e.code().value());
+		}
+		catch (...) {
+			return true;
+		}
+	} // is_shareable_error
+
+	// True if the permission allows reading the bytes of an object. The names differ between
+	// iRODS 4.2 and 4.3, and every permission above the metadata permissions includes reading.
+	auto allows_reading(const std::string& _access_name) -> bool
+	{
+		return !_access_name.empty() && _access_name != "null" && _access_name != "read metadata" &&
+		       _access_name != "read_metadata";
+	} // allows_reading
+
+	// Makes the condition "_column = '_value'", or a like condition matching a superset of _value if
+	// _value cannot be written as a GenQuery literal.
+	auto make_name_condition(std::string_view _column, std::string_view _value) -> std::string
+	{
+		if (_value.find('\'') == std::string_view::npos) {
+			return fmt::format("{} = '{}'", _column, _value);
+		}
+
+		// The backslash is the escape character of like patterns, so it is matched by a wildcard too.
+		std::string pattern{_value};
+		std::replace_if(
+			std::begin(pattern), std::end(pattern), [](char _c) { return _c == '\'' || _c == '\\'; }, '_');
+		return fmt::format("{} like '{}'", _column, pattern);
+	} // make_name_condition
+
+	// True if _username may read the object described by _access, which maps the users and groups
+	// holding a permission on the object to the permission.
+	auto may_read(
+		RcComm& _conn,
+		std::string_view _username,
+		const std::unordered_map<std::string, std::string>& _access) -> bool
+	{
+		const auto readable_by = [&_access](const std::string& _name) {
+			const auto iter = _access.find(_name);
+			return iter != std::end(_access) && allows_reading(iter->second);
+		};
+
+		const auto username = std::string{_username};
+		if (readable_by(username)) {
+			return true;
+		}
+
+		// GenQuery cannot join the access entries of an object with the groups of a user, so the groups
+		// are looked up in a second query. It only runs if a permission of someone else could apply.
+		// iRODS user names cannot contain quotes, so a name which does has no groups either.
+		const auto granted_to_others = std::any_of(std::begin(_access), std::end(_access), [&username](const auto& _e) {
+			return _e.first != username && allows_reading(_e.second);
+		});
+		if (!granted_to_others || username.find('\'') != std::string::npos) {
+			return false;
+		}
+
+		const auto query = fmt::format("select USER_GROUP_NAME where USER_NAME = '{}'", username);
+		logging::trace("{}: query={}", __func__, query);
+
+		const irods::s3::rpc_profiler::timer timer{"GEN_QUERY"};
+		for (auto&& row : irods::query<RcComm>(&_conn, query)) {
+			if (row[0] != username && readable_by(row[0])) {
+				return true;
+			}
+		}
+
+		return false;
+	} // may_read
+
+	auto query_object_stat(
+		RcComm& _conn,
+		const irods::experimental::filesystem::path& _path,
+		std::string_view _username) -> std::optional<irods::s3::object_stat>
+	{
+		// One row is returned for every combination of replica and access entry.
+		const auto query = fmt::format(
+			"select DATA_SIZE, DATA_MODIFY_TIME, DATA_CHECKSUM, DATA_OWNER_NAME, DATA_REPL_NUM, DATA_REPL_STATUS, "
+			"DATA_ACCESS_NAME, USER_NAME, DATA_RESC_HIER, COLL_NAME, DATA_NAME where {}",
+			irods::s3::make_data_object_condition(_path));
+		logging::trace("{}: query={}", __func__, query);
+
+		std::optional<irods::s3::object_stat> result;
+		std::vector<std::string> good_resources;
+		std::unordered_set<std::string> seen_replicas;
+		std::unordered_map<std::string, std::string> access;
+
+		{
+			const irods::s3::rpc_profiler::timer timer{"GEN_QUERY"};
+			for (auto&& row : irods::query<RcComm>(&_conn, query)) {
+				if (!irods::s3::is_data_object(_path, row[9], row[10])) {
+					continue;
+				}
+
+				const bool good_replica = row[5] == "1";
+
+				// Describe a good replica when there is one.
+				if (!result || (good_replica && !result->good_replica)) {
+					result = irods::s3::object_stat{
+						.size = std::stoull(row[0]),
+						.mtime = static_cast<std::time_t>(std::stoll(row[1])),
+						.checksum = row[2],
+						.owner = row[3],
+						.replica_number = std::stoi(row[4]),
+						.good_replica = good_replica};
+				}
+				else if (good_replica && result->checksum.empty()) {
+					// Good replicas hold the same bytes, so the checksum of any of them will do.
+					result->checksum = row[2];
+				}
+
+				// The leaf resource is the last element of the hierarchy.
+				if (good_replica && seen_replicas.insert(row[4]).second) {
+					const auto& hierarchy = row[8];
+					good_resources.push_back(hierarchy.substr(hierarchy.rfind(';') + 1));
+				}
+
+				if (!row[6].empty()) {
+					access.insert_or_assign(row[7], row[6]);
+				}
+			}
+		}
+
+		if (result) {
+			result->good_resources = std::move(good_resources);
+			result->accessible = may_read(_conn, _username, access);
+		}
+
+		return result;
+	} // query_object_stat
+} // anonymous namespace
+
+auto irods::s3::make_data_object_condition(const irods::experimental::filesystem::path& _path) -> std::string
+{
+	return fmt::format(
+		"{} and {}",
+		make_name_condition("COLL_NAME", _path.parent_path().c_str()),
+		make_name_condition("DATA_NAME", _path.object_name().c_str()));
+} // make_data_object_condition
+
+auto irods::s3::is_data_object(
+	const irods::experimental::filesystem::path& _path,
+	std::string_view _collection,
+	std::string_view _name) -> bool
+{
+	return _collection == _path.parent_path().c_str() && _name == _path.object_name().c_str();
+} // is_data_object
+
+auto irods::s3::stat_object(
+	RcComm& _conn,
+	const irods::experimental::filesystem::path& _path,
+	std::string_view _username,
+	stat_sharing _sharing) -> std::optional<object_stat>
+{
+	if (_sharing == stat_sharing::none) {
+		return query_object_stat(_conn, _path, _username);
+	}
+
+	// The permissions in the result depend on the user, so the user is part of the key.
+	auto key = std::string{_username};
+	key += '\0';
+	key += _path.string();
+
+	return g_stat_calls.run(
+		key, [&] { return query_object_stat(_conn, _path, _username); }, is_shareable_error);
+} // stat_object
+
+auto irods::s3::get_good_replica_numbers(RcComm& _conn, const irods::experimental::filesystem::path& _path)
+	-> std::vector<int>
+{
+	const auto query = fmt::format(
+		"select DATA_REPL_NUM, COLL_NAME, DATA_NAME where {} and DATA_REPL_STATUS = '1'",
+		make_data_object_condition(_path));
+
+	std::vector<int> replica_numbers;
+	const irods::s3::rpc_profiler::timer timer{"GEN_QUERY"};
+	for (auto&& row : irods::query<RcComm>(&_conn, query)) {
+		if (is_data_object(_path, row[1], row[2])) {
+			replica_numbers.push_back(std::stoi(row[0]));
+		}
+	}
+
+	return replica_numbers;
+} // get_good_replica_numbers
@@ -0,0 +1,196 @@
+#include "irods/private/s3_api/open_handle_cache.hpp"
+#include "irods/private/s3_api/log.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace logging = irods::http::logging;
+
+irods::s3::read_handle::read_handle(
+	std::shared_ptr<irods::experimental::client_connection> _conn,
+	std::string _username,
+	irods::experimental::filesystem::path _path,
+	object_stat _stat,
+	std::chrono::steady_clock::time_point _looked_up)
+	: conn{std::move(_conn)}
+	, transport{*conn}
+	, username{std::move(_username)}
+	, path{std::move(_path)}
+	, stat{std::move(_stat)}
+	, looked_up{_looked_up}
+	, last_used{_looked_up}
+{
+} // constructor
+
+irods::s3::open_handle_cache::open_handle_cache(const options& _options)
+	: options_{_options}
+{
+} // constructor
+
+irods::s3::open_handle_cache::~open_handle_cache() = default;
+
+auto irods::s3::open_handle_cache::take(
+	const std::string& _username,
+	const std::string& _path,
+	std::optional<int> _replica_number) -> std::unique_ptr<read_handle>
+{
+	// Handles are closed after the lock is released since closing them talks to iRODS.
+	std::vector<std::unique_ptr<read_handle>> closing;
+	std::unique_ptr<read_handle> handle;
+
+	{
+		std::lock_guard lk{mutex_};
+		const auto now = std::chrono::steady_clock::now();
+
+		auto [iter, end] = idle_.equal_range(make_key(_username, _path, _replica_number));
+		while (iter != end) {
+			if (now - iter->second->last_used > options_.idle_timeout || is_stale(*iter->second, now)) {
+				closing.push_back(std::move(iter->second));
+				iter = idle_.erase(iter);
+				continue;
+			}
+
+			handle = std::move(iter->second);
+			idle_.erase(iter);
+			break;
+		}
+	}
+
+	closed_ += closing.size();
+	++(handle ? hits_ : misses_);
+
+	return handle;
+} // take
+
+auto irods::s3::open_handle_cache::give_back(std::unique_ptr<read_handle> _handle) -> void
+{
+	if (!_handle || !_handle->in.is_open() || !_handle->in.good()) {
+		return;
+	}
+
+	std::unique_ptr<read_handle> closing;
+
+	{
+		std::lock_guard lk{mutex_};
+		const auto now = std::chrono::steady_clock::now();
+
+		if (is_stale(*_handle, now)) {
+			closing = std::move(_handle);
+		}
+		else {
+			if (idle_.size() >= std::max<std::size_t>(options_.max_handles, 1)) {
+				const auto by_last_use = [](const auto& _a, const auto& _b) {
+					return _a.second->last_used < _b.second->last_used;
+				};
+				const auto lru = std::min_element(std::begin(idle_), std::end(idle_), by_last_use);
+				closing = std::move(lru->second);
+				idle_.erase(lru);
+			}
+
+			_handle->last_used = now;
+			auto key = make_key(_handle->username, _handle->path.string(), _handle->replica_number);
+			idle_.emplace(std::move(key), std::move(_handle));
+		}
+	}
+
+	if (closing) {
+		++closed_;
+	}
+} // give_back
+
+auto irods::s3::open_handle_cache::invalidate(const std::string& _path) -> void
+{
+	std::vector<std::unique_ptr<read_handle>> closing;
+
+	{
+		std::lock_guard lk{mutex_};
+		written_.insert_or_assign(_path, std::chrono::steady_clock::now());
+
+		// The handles of every user are keyed separately, so all of them are checked.
+		for (auto iter = std::begin(idle_); iter != std::end(idle_);) {
+			if (iter->second->path.string() == _path) {
+				closing.push_back(std::move(iter->second));
+				iter = idle_.erase(iter);
+			}
+			else {
+				++iter;
+			}
+		}
+	}
+
+	closed_ += closing.size();
+} // invalidate
+
+auto irods::s3::open_handle_cache::expire() -> void
+{
+	std::vector<std::unique_ptr<read_handle>> closing;
+
+	{
+		std::lock_guard lk{mutex_};
+		const auto now = std::chrono::steady_clock::now();
+
+		for (auto iter = std::begin(idle_); iter != std::end(idle_);) {
+			if (now - iter->second->last_used > options_.idle_timeout || is_stale(*iter->second, now)) {
+				closing.push_back(std::move(iter->second));
+				iter = idle_.erase(iter);
+			}
+			else {
+				++iter;
+			}
+		}
+
+		// Handles which looked their object up before a write are older than the maximum age by
+		// now, so the write no longer needs to be remembered.
+		std::erase_if(written_, [this, now](const auto& _entry) { return now - _entry.second > options_.max_age; });
+	}
+
+	closed_ += closing.size();
+} // expire
+
+auto irods::s3::open_handle_cache::log_report() const -> void
+{
+	std::size_t idle = 0;
+	{
+		std::lock_guard lk{mutex_};
+		idle = idle_.size();
+	}
+
+	const auto hits = hits_.load();
+	const auto lookups = hits + misses_.load();
+
+	logging::info(
+		"{}: Open handle hit ratio [{:.3f}] ([{}] of [{}] ranged reads), [{}] handles idle, [{}] closed.",
+		__func__,
+		lookups > 0 ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0,
+		hits,
+		lookups,
+		idle,
+		closed_.load());
+} // log_report
+
+auto irods::s3::open_handle_cache::make_key(
+	const std::string& _username,
+	const std::string& _path,
+	std::optional<int> _replica_number) -> std::string
+{
+	std::string key;
+	key.reserve(_username.size() + 1 + _path.size() + 1 + 8);
+	key.append(_username).push_back('\0');
+	key.append(_path).push_back('\0');
+	if (_replica_number) {
+		key.append(std::to_string(*_replica_number));
+	}
+	return key;
+} // make_key
+
+auto irods::s3::open_handle_cache::is_stale(const read_handle& _handle, std::chrono::steady_clock::time_point _now)
+	const -> bool
+{
+	if (_now - _handle.looked_up > options_.max_age) {
+		return true;
+	}
+
+	const auto iter = written_.find(_handle.path.string());
+	return iter != std::end(written_) && iter->second >= _handle.looked_up;
+} // is_stale
@@ -0,0 +1,478 @@
+#include "irods/private/s3_api/parallel_transfer.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+
+#include <irods/client_connection.hpp>
+#include <irods/dstream.hpp>
+#include <irods/filesystem.hpp>
+#include <irods/transport/default_transport.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace fs = irods::experimental::filesystem;
+namespace logging = irods::http::logging;
+
+using irods_default_transport = irods::experimental::io::client::default_transport;
+
+struct irods::s3::parallel_writer::stream
+{
+	explicit stream(std::shared_ptr<irods::experimental::client_connection> _conn)
+		: conn{std::move(_conn)}
+		, xtrans{*conn}
+	{
+	}
+
+	std::shared_ptr<irods::experimental::client_connection> conn;
+	irods_default_transport xtrans;
+	irods::experimental::io::odstream out;
+}; // struct parallel_writer::stream
+
+irods::s3::parallel_writer::parallel_writer(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path,
+	std::size_t _stream_count)
+	: path_{_path}
+{
+	// All streams share the first stream's replica token, so every connection must be opened
+	// against the same server.
+	auto conns = get_data_connections(_client_username, _path, data_transfer_direction::write, _stream_count);
+
+	streams_.reserve(conns.size());
+	for (auto& conn : conns) {
+		streams_.push_back(std::make_unique<stream>(std::move(conn)));
+	}
+
+	auto& primary = streams_.front()->out;
+	irods::s3::rpc_profiler::timer open_timer{"DATA_OBJ_OPEN"};
+	primary.open(
+		streams_.front()->xtrans,
+		path_,
+		irods::experimental::io::root_resource_name{irods::s3::get_resource()},
+		std::ios::out | std::ios::trunc);
+	open_timer.stop(!primary.is_open());
+
+	if (!primary.is_open()) {
+		logging::error("{}: Failed to open iRODS data object [{}].", __func__, path_.c_str());
+		return;
+	}
+
+	const auto token = primary.replica_token();
+	const auto number = primary.replica_number();
+
+	for (std::size_t i = 1; i < streams_.size(); ++i) {
+		irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
+		streams_[i]->out.open(streams_[i]->xtrans, token, path_, number, std::ios::out | std::ios::in);
+		timer.stop(!streams_[i]->out.is_open());
+
+		if (!streams_[i]->out.is_open()) {
+			logging::error(
+				"{}: Failed to open secondary stream [{}] for iRODS data object [{}].", __func__, i, path_.c_str());
+			return;
+		}
+	}
+
+	idle_streams_.reserve(streams_.size());
+	for (std::size_t i = 0; i < streams_.size(); ++i) {
+		idle_streams_.push_back(i);
+	}
+
+	opened_ = true;
+} // constructor
+
+irods::s3::parallel_writer::~parallel_writer()
+{
+	// Outstanding writes keep the writer alive, so the streams are idle. They are only still open if
+	// neither close() nor abandon() was called.
+	try {
+		if (!closed_) {
+			close_streams();
+		}
+	}
+	catch (...) {
+	}
+} // destructor
+
+auto irods::s3::parallel_writer::is_open() const noexcept -> bool
+{
+	return opened_;
+} // is_open
+
+auto irods::s3::parallel_writer::write(std::uint64_t _offset, std::vector<char> _block) -> bool
+{
+	std::lock_guard lk{mutex_};
+
+	if (!opened_ || failed_ || closing_) {
+		return false;
+	}
+
+	queued_blocks_.push_back({_offset, std::move(_block)});
+	start_writes();
+
+	return true;
+} // write
+
+auto irods::s3::parallel_writer::when_ready(std::function<void()> _callback) -> void
+{
+	{
+		std::lock_guard lk{mutex_};
+
+		if (!queued_blocks_.empty()) {
+			on_ready_ = std::move(_callback);
+			return;
+		}
+	}
+
+	_callback();
+} // when_ready
+
+auto irods::s3::parallel_writer::close(std::function<void(bool)> _on_closed) -> void
+{
+	{
+		std::lock_guard lk{mutex_};
+
+		if (closed_) {
+			irods::http::globals::background_task(
+				[f = std::move(_on_closed), closed = opened_ && !failed_] { f(closed); });
+			return;
+		}
+
+		on_closed_.push_back(std::move(_on_closed));
+
+		// Otherwise the write which completes last closes the streams. Streams are only handed out
+		// once all of them have been opened.
+		if (std::exchange(closing_, true) || (opened_ && idle_streams_.size() != streams_.size())) {
+			return;
+		}
+	}
+
+	close_streams();
+} // close
+
+auto irods::s3::parallel_writer::abandon(bool _remove_object) -> void
+{
+	// The callback keeps the writer alive until the streams are closed.
+	close([self = shared_from_this(), _remove_object](bool) {
+		// Writes are only accepted once every stream has been opened.
+		if (!self->opened_ || !_remove_object) {
+			return;
+		}
+
+		// The connections stay usable after the streams are closed.
+		const auto removed = irods::s3::rpc_profiler::timed(
+			"DATA_OBJ_UNLINK", [&self] { return fs::client::remove(*self->streams_.front()->conn, self->path_); });
+		if (!removed) {
+			logging::error("{}: Failed to remove partial iRODS data object [{}].", __func__, self->path_.c_str());
+		}
+	});
+} // abandon
+
+// Hands queued blocks to idle streams. Called with mutex_ held.
+auto irods::s3::parallel_writer::start_writes() -> void
+{
+	while (!queued_blocks_.empty() && !idle_streams_.empty()) {
+		const auto index = idle_streams_.back();
+		idle_streams_.pop_back();
+
+		// Tasks must be copyable, so the block is shared rather than copied.
+		auto block = std::make_shared<queued_block>(std::move(queued_blocks_.front()));
+		queued_blocks_.pop_front();
+
+		irods::http::globals::transfer_task([self = shared_from_this(), index, block] {
+			self->write_block(index, *block);
+		});
+	}
+} // start_writes
+
+auto irods::s3::parallel_writer::write_block(std::size_t _stream_index, const queued_block& _block) -> void
+{
+	auto& out = streams_[_stream_index]->out;
+	irods::s3::rpc_profiler::timer timer{"DATA_OBJ_WRITE"};
+	out.seekp(static_cast<std::streamoff>(_block.offset));
+	out.write(_block.data.data(), static_cast<std::streamsize>(_block.data.size()));
+	const bool failed = out.fail();
+	timer.stop(failed);
+
+	if (failed) {
+		logging::error(
+			"{}: Failed to write [{}] bytes at offset [{}] to iRODS data object [{}].",
+			__func__,
+			_block.data.size(),
+			_block.offset,
+			path_.c_str());
+	}
+
+	std::function<void()> on_ready;
+	bool last_write = false;
+
+	{
+		std::lock_guard lk{mutex_};
+		idle_streams_.push_back(_stream_index);
+
+		// The transfer is lost, so the queued blocks are never written.
+		if (failed) {
+			failed_ = true;
+			queued_blocks_.clear();
+		}
+
+		start_writes();
+
+		if (queued_blocks_.empty()) {
+			on_ready = std::exchange(on_ready_, nullptr);
+		}
+
+		last_write = closing_ && idle_streams_.size() == streams_.size();
+	}
+
+	if (on_ready) {
+		irods::http::globals::background_task(std::move(on_ready));
+	}
+
+	if (last_write) {
+		close_streams();
+	}
+} // write_block
+
+// Runs once no write is outstanding.
+auto irods::s3::parallel_writer::close_streams() -> void
+{
+	// Only the stream which created the replica may finalize it. If a secondary stream updated the
+	// size, status or checksum, the replica would look complete before every stream is done.
+	irods::experimental::io::on_close_success secondary_close;
+	secondary_close.update_size = false;
+	secondary_close.update_status = false;
+	secondary_close.compute_checksum = false;
+	secondary_close.send_notifications = false;
+
+	for (auto iter = std::rbegin(streams_); iter != std::rend(streams_); ++iter) {
+		const bool primary = std::next(iter) == std::rend(streams_);
+
+		if ((*iter)->out.is_open()) {
+			const irods::s3::rpc_profiler::timer timer{"DATA_OBJ_CLOSE"};
+			(*iter)->out.close(primary ? nullptr : &secondary_close);
+		}
+	}
+
+	std::vector<std::function<void(bool)>> on_closed;
+	bool closed{};
+
+	{
+		std::lock_guard lk{mutex_};
+		closed_ = true;
+		on_closed.swap(on_closed_);
+		closed = opened_ && !failed_;
+	}
+
+	for (auto& f : on_closed) {
+		irods::http::globals::background_task([f = std::move(f), closed] { f(closed); });
+	}
+} // close_streams
+
+struct irods::s3::parallel_reader::stream
+{
+	explicit stream(std::shared_ptr<irods::experimental::client_connection> _conn)
+		: conn{std::move(_conn)}
+		, xtrans{*conn}
+	{
+	}
+
+	std::shared_ptr<irods::experimental::client_connection> conn;
+	irods_default_transport xtrans;
+	irods::experimental::io::idstream in;
+}; // struct parallel_reader::stream
+
+irods::s3::parallel_reader::parallel_reader(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path,
+	std::size_t _stream_count,
+	bool _spread_across_replicas)
+	: path_{_path}
+{
+	auto conns = get_data_connections(_client_username, _path, data_transfer_direction::read, _stream_count);
+
+	std::vector<int> replica_numbers;
+	if (_spread_across_replicas && !conns.empty()) {
+		replica_numbers = irods::s3::get_good_replica_numbers(*conns.front(), _path);
+		logging::debug(
+			"{}: Spreading [{}] streams over [{}] good replicas of [{}].",
+			__func__,
+			conns.size(),
+			replica_numbers.size(),
+			path_.c_str());
+	}
+
+	streams_.reserve(conns.size());
+	for (auto& conn : conns) {
+		auto s = std::make_unique<stream>(std::move(conn));
+		irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
+
+		if (replica_numbers.size() > 1) {
+			const auto replica_number = replica_numbers[streams_.size() % replica_numbers.size()];
+			s->in.open(s->xtrans, path_, irods::experimental::io::replica_number{replica_number}, std::ios_base::in);
+		}
+		else {
+			s->in.open(
+				s->xtrans,
+				path_,
+				irods::experimental::io::root_resource_name{irods::s3::get_resource()},
+				std::ios_base::in);
+		}
+
+		timer.stop(!s->in.is_open());
+
+		if (!s->in.is_open()) {
+			logging::error(
+				"{}: Failed to open stream [{}] for iRODS data object [{}].", __func__, streams_.size(), path_.c_str());
+		}
+
+		streams_.push_back(std::move(s));
+	}
+} // constructor
+
+irods::s3::parallel_reader::~parallel_reader()
+{
+	cancel();
+} // destructor
+
+auto irods::s3::parallel_reader::is_open() const noexcept -> bool
+{
+	return !streams_.empty() &&
+	       std::all_of(std::begin(streams_), std::end(streams_), [](const auto& _s) { return _s->in.is_open(); });
+} // is_open
+
+auto irods::s3::parallel_reader::stream_count() const noexcept -> std::size_t
+{
+	return streams_.size();
+} // stream_count
+
+auto irods::s3::parallel_reader::start(
+	std::uint64_t _offset,
+	std::uint64_t _length,
+	std::uint64_t _block_size,
+	std::size_t _max_buffered_blocks) -> void
+{
+	{
+		std::lock_guard lk{mutex_};
+		block_size_ = std::max<std::uint64_t>(_block_size, 1);
+		max_buffered_bytes_ = block_size_ * std::max(_max_buffered_blocks, streams_.size());
+		next_claim_ = _offset;
+		next_return_ = _offset;
+		end_ = _offset + _length;
+	}
+
+	for (std::size_t i = 0; i < streams_.size(); ++i) {
+		schedule_read(i);
+	}
+} // start
+
+auto irods::s3::parallel_reader::schedule_read(std::size_t _stream_index) -> void
+{
+	irods::http::globals::transfer_task([self = shared_from_this(), _stream_index] {
+		if (self->read_stripe(_stream_index)) {
+			self->schedule_read(_stream_index);
+		}
+	});
+} // schedule_read
+
+auto irods::s3::parallel_reader::read_stripe(std::size_t _stream_index) -> bool
+{
+	std::uint64_t offset{};
+	std::uint64_t size{};
+
+	{
+		// Only claim a stripe once it fits in the reorder buffer. Stripes which have been claimed but
+		// not yet returned count against the limit, whether or not they have been read. A stream
+		// which finds no room gives its thread back and is rescheduled by next().
+		std::lock_guard lk{mutex_};
+
+		if (stopping_ || failed_ || next_claim_ >= end_) {
+			return false;
+		}
+
+		if (next_claim_ - next_return_ >= max_buffered_bytes_) {
+			parked_streams_.push_back(_stream_index);
+			return false;
+		}
+
+		offset = next_claim_;
+		size = std::min(block_size_, end_ - offset);
+		next_claim_ += size;
+	}
+
+	auto& in = streams_[_stream_index]->in;
+	std::vector<char> block(size);
+	irods::s3::rpc_profiler::timer timer{"DATA_OBJ_READ"};
+	in.seekg(static_cast<std::streamoff>(offset));
+	in.read(block.data(), static_cast<std::streamsize>(size));
+	const bool short_read = static_cast<std::uint64_t>(in.gcount()) != size;
+	timer.stop(short_read);
+
+	if (short_read) {
+		logging::error(
+			"{}: Read [{}] of [{}] bytes at offset [{}] from iRODS data object [{}].",
+			__func__,
+			in.gcount(),
+			size,
+			offset,
+			path_.c_str());
+	}
+
+	{
+		std::lock_guard lk{mutex_};
+		if (short_read) {
+			failed_ = true;
+		}
+		else {
+			reorder_buffer_.emplace(offset, std::move(block));
+		}
+	}
+
+	cv_.notify_all();
+
+	return !short_read;
+} // read_stripe
+
+auto irods::s3::parallel_reader::next() -> std::optional<std::vector<char>>
+{
+	std::unique_lock lk{mutex_};
+
+	if (next_return_ >= end_) {
+		return std::nullopt;
+	}
+
+	cv_.wait(lk, [this] { return stopping_ || failed_ || reorder_buffer_.count(next_return_) > 0; });
+
+	if (stopping_ || failed_) {
+		return std::nullopt;
+	}
+
+	auto node = reorder_buffer_.extract(next_return_);
+	next_return_ += node.mapped().size();
+
+	// Returning a stripe frees room in the reorder buffer.
+	std::vector<std::size_t> parked;
+	parked.swap(parked_streams_);
+	lk.unlock();
+
+	for (const auto index : parked) {
+		schedule_read(index);
+	}
+
+	return std::move(node.mapped());
+} // next
+
+auto irods::s3::parallel_reader::cancel() -> void
+{
+	{
+		std::lock_guard lk{mutex_};
+		stopping_ = true;
+	}
+
+	cv_.notify_all();
+} // cancel
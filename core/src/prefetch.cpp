@@ -0,0 +1,250 @@
+#include "irods/private/s3_api/prefetch.hpp"
+#include "irods/private/s3_api/archive.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/disk_cache.hpp"
+#include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_cache.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+#include "irods/private/s3_api/small_object.hpp"
+
+#include <irods/dstream.hpp>
+#include <irods/transport/default_transport.hpp>
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace logging = irods::http::logging;
+
+irods::s3::prefetcher::prefetcher(const options& _options)
+	: options_{_options}
+	, tokens_{static_cast<double>(_options.max_bytes_per_second)}
+	, refilled_{std::chrono::steady_clock::now()}
+	, workers_{std::max<std::size_t>(_options.thread_count, 1)}
+{
+} // constructor
+
+irods::s3::prefetcher::~prefetcher()
+{
+	workers_.stop();
+	workers_.join();
+} // destructor
+
+auto irods::s3::prefetcher::remember_listing(const std::string& _client_username, std::vector<listed_object> _objects)
+	-> void
+{
+	if (_objects.empty()) {
+		return;
+	}
+
+	// The keys are downloaded in lexicographic order, which is not necessarily the catalog's order.
+	std::sort(std::begin(_objects), std::end(_objects), [](const auto& _a, const auto& _b) {
+		return _a.path < _b.path;
+	});
+	const auto duplicates = std::unique(std::begin(_objects), std::end(_objects), [](const auto& _a, const auto& _b) {
+		return _a.path == _b.path;
+	});
+	_objects.erase(duplicates, std::end(_objects));
+
+	listing l;
+	l.positions.reserve(_objects.size());
+	for (std::size_t i = 0; i < _objects.size(); ++i) {
+		l.positions.emplace(_objects[i].path, i);
+	}
+	l.prefetched.resize(_objects.size());
+	l.objects = std::move(_objects);
+	l.last_used = std::chrono::steady_clock::now();
+
+	std::lock_guard lk{mutex_};
+	forget_expired_listings();
+	listings_.insert_or_assign(_client_username, std::move(l));
+} // remember_listing
+
+auto irods::s3::prefetcher::on_get(const std::string& _client_username, const std::string& _path) -> void
+{
+	auto* cache = irods::http::globals::object_cache();
+	auto* disk = irods::http::globals::disk_cache();
+
+	// The objects to prefetch and the bytes of the memory budget each of them holds.
+	std::vector<std::pair<listed_object, std::uint64_t>> batch;
+
+	{
+		std::lock_guard lk{mutex_};
+		forget_expired_listings();
+
+		const auto iter = listings_.find(_client_username);
+		if (iter == std::end(listings_)) {
+			return;
+		}
+
+		auto& l = iter->second;
+		const auto position = l.positions.find(_path);
+		if (position == std::end(l.positions)) {
+			return;
+		}
+
+		const auto index = position->second;
+		if (l.prefetched[index]) {
+			++used_;
+		}
+
+		l.last_used = std::chrono::steady_clock::now();
+		l.furthest = std::max(l.furthest, index + 1);
+
+		// A single request says nothing about the order. The second one shows that the client is
+		// working through the listing.
+		if (++l.gets < 2) {
+			return;
+		}
+
+		// Objects the client has already passed are of no use.
+		l.scheduled = std::max(l.scheduled, l.furthest);
+
+		const auto end = std::min(l.objects.size(), l.furthest + options_.object_count);
+		for (; l.scheduled < end; ++l.scheduled) {
+			const auto& object = l.objects[l.scheduled];
+
+			const bool in_memory = cache && object.size > 0 && object.size <= cache->max_object_size_in_bytes();
+			if (!in_memory && !(disk && disk->accepts(object.size))) {
+				continue;
+			}
+
+			// The remaining objects are considered again on the next request.
+			const auto memory = in_memory ? object.size : 0;
+			if (!reserve(memory, object.size)) {
+				break;
+			}
+
+			l.prefetched[l.scheduled] = true;
+			batch.emplace_back(object, memory);
+		}
+	}
+
+	for (auto& [object, memory] : batch) {
+		boost::asio::post(workers_, [this, _client_username, object = std::move(object), memory = memory] {
+			++(fetch(_client_username, object) ? prefetched_ : failed_);
+
+			std::lock_guard lk{mutex_};
+			bytes_in_flight_ -= memory;
+		});
+	}
+} // on_get
+
+auto irods::s3::prefetcher::log_report() const -> void
+{
+	std::size_t listings = 0;
+	{
+		std::lock_guard lk{mutex_};
+		listings = listings_.size();
+	}
+
+	logging::info(
+		"{}: [{}] objects prefetched, [{}] requested by clients, [{}] failed. [{}] listings remembered.",
+		__func__,
+		prefetched_.load(),
+		used_.load(),
+		failed_.load(),
+		listings);
+} // log_report
+
+auto irods::s3::prefetcher::reserve(std::uint64_t _memory, std::uint64_t _size) -> bool
+{
+	// A single object is always allowed, even if it is larger than the memory budget.
+	if (_memory > 0 && bytes_in_flight_ > 0 && bytes_in_flight_ + _memory > options_.max_bytes_in_flight) {
+		return false;
+	}
+
+	if (const auto rate = static_cast<double>(options_.max_bytes_per_second); rate > 0) {
+		const auto now = std::chrono::steady_clock::now();
+		const auto elapsed = std::chrono::duration<double>(now - refilled_).count();
+		tokens_ = std::min(rate, tokens_ + elapsed * rate);
+		refilled_ = now;
+
+		if (tokens_ <= 0) {
+			return false;
+		}
+
+		tokens_ -= static_cast<double>(_size);
+	}
+
+	bytes_in_flight_ += _memory;
+	return true;
+} // reserve
+
+auto irods::s3::prefetcher::forget_expired_listings() -> void
+{
+	const auto now = std::chrono::steady_clock::now();
+	std::erase_if(listings_, [this, now](const auto& _entry) {
+		return now - _entry.second.last_used > options_.listing_ttl;
+	});
+} // forget_expired_listings
+
+auto irods::s3::prefetcher::fetch(const std::string& _client_username, const listed_object& _object) -> bool
+{
+	// Prefetches are not part of any request, so they are profiled on their own.
+	const irods::s3::rpc_profiler::scope profile{"GetObject (prefetch)"};
+
+	try {
+		const irods::experimental::filesystem::path path{_object.path};
+		auto conn = irods::s3::get_data_connection(_client_username, path, data_transfer_direction::read);
+
+		const auto stat = irods::s3::stat_object(*conn, path, _client_username);
+		if (!stat || !stat->accessible || irods::s3::needs_restore(*stat)) {
+			return false;
+		}
+
+		const object_cache::version version{stat->size, stat->mtime, stat->checksum};
+
+		if (auto* cache = irods::http::globals::object_cache();
+		    cache && stat->size > 0 && stat->size <= cache->max_object_size_in_bytes())
+		{
+			if (cache->contains(_object.path, version)) {
+				return true;
+			}
+
+			std::shared_ptr<std::vector<char>> contents;
+			if (stat->size <= irods::s3::get_get_object_small_object_threshold_in_bytes()) {
+				contents = irods::s3::read_small_object(*conn, path, stat->size, std::nullopt);
+			}
+
+			if (!contents) {
+				irods::experimental::io::client::default_transport xtrans{*conn};
+				irods::s3::rpc_profiler::timer open_timer{"DATA_OBJ_OPEN"};
+				irods::experimental::io::idstream in{
+					xtrans,
+					path,
+					irods::experimental::io::root_resource_name{irods::s3::get_resource()},
+					std::ios_base::in};
+				open_timer.stop(!in.is_open());
+
+				auto buffer = std::make_shared<std::vector<char>>(stat->size);
+				irods::s3::rpc_profiler::timer read_timer{"DATA_OBJ_READ"};
+				in.read(buffer->data(), static_cast<std::streamsize>(stat->size));
+				read_timer.stop(static_cast<std::uint64_t>(in.gcount()) != stat->size);
+				if (!in.is_open() || static_cast<std::uint64_t>(in.gcount()) != stat->size) {
+					return false;
+				}
+				contents = std::move(buffer);
+			}
+
+			cache->insert(_object.path, version, std::move(contents));
+			return true;
+		}
+
+		if (auto* disk = irods::http::globals::disk_cache(); disk && disk->accepts(stat->size)) {
+			if (!disk->contains(_object.path, version)) {
+				disk->fill_async(_client_username, path, version);
+			}
+			return true;
+		}
+	}
+	catch (const std::exception& e) {
+		logging::warn("{}: Could not prefetch [{}]: {}", __func__, _object.path, e.what());
+	}
+
+	return false;
+} // fetch
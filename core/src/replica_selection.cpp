@@ -0,0 +1,180 @@
+#include "irods/private/s3_api/replica_selection.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+
+#include <irods/irods_query.hpp>
+#include <irods/query_builder.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// What this server has observed about reads from a single leaf resource.
+	struct resource_stats
+	{
+		std::uint64_t reads_in_progress = 0;
+
+		// A moving average of the first-byte latency, in microseconds. Zero until measured.
+		double latency = 0;
+	};
+
+	// The weight of the newest sample in the moving average.
+	constexpr double latency_weight = 0.2;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::mutex g_stats_mutex;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::unordered_map<std::string, resource_stats> g_stats;
+
+	auto stats_of(const std::vector<irods::s3::replica_location>& _replicas)
+		-> std::unordered_map<std::string, resource_stats>
+	{
+		std::unordered_map<std::string, resource_stats> result;
+
+		std::lock_guard lk{g_stats_mutex};
+		for (const auto& r : _replicas) {
+			if (const auto iter = g_stats.find(r.resource); iter != std::end(g_stats)) {
+				result.emplace(r.resource, iter->second);
+			}
+		}
+
+		return result;
+	} // stats_of
+
+	// Orders _replicas in place. The order among equally ranked replicas is kept.
+	auto rank(std::vector<irods::s3::replica_location>& _replicas, irods::s3::replica_selection_policy _policy)
+		-> void
+	{
+		using policy = irods::s3::replica_selection_policy;
+
+		switch (_policy) {
+			case policy::resource:
+				break;
+
+			case policy::nearest: {
+				const auto& local_hosts = irods::s3::get_replica_selection_local_hosts();
+				std::stable_partition(std::begin(_replicas), std::end(_replicas), [&local_hosts](const auto& _r) {
+					return std::find(std::begin(local_hosts), std::end(local_hosts), _r.host) != std::end(local_hosts);
+				});
+				break;
+			}
+
+			case policy::fastest: {
+				// Resources which have not been measured yet come first so that they get measured.
+				const auto stats = stats_of(_replicas);
+				const auto latency = [&stats](const auto& _r) {
+					const auto iter = stats.find(_r.resource);
+					return iter == std::end(stats) ? 0.0 : iter->second.latency;
+				};
+				std::stable_sort(
+					std::begin(_replicas), std::end(_replicas), [&latency](const auto& _a, const auto& _b) {
+						return latency(_a) < latency(_b);
+					});
+				break;
+			}
+
+			case policy::least_loaded: {
+				const auto stats = stats_of(_replicas);
+				const auto load = [&stats](const auto& _r) {
+					const auto iter = stats.find(_r.resource);
+					return iter == std::end(stats) ? std::pair<std::uint64_t, double>{}
+					                               : std::pair{iter->second.reads_in_progress, iter->second.latency};
+				};
+				std::stable_sort(std::begin(_replicas), std::end(_replicas), [&load](const auto& _a, const auto& _b) {
+					return load(_a) < load(_b);
+				});
+				break;
+			}
+		}
+	} // rank
+} // anonymous namespace
+
+auto irods::s3::select_replicas(RcComm& _conn, const irods::experimental::filesystem::path& _path)
+	-> std::vector<replica_location>
+{
+	const auto query = fmt::format(
+		"select DATA_REPL_NUM, DATA_RESC_HIER, RESC_LOC where COLL_NAME = '{}' and DATA_NAME = '{}' and "
+		"DATA_REPL_STATUS = '1'",
+		_path.parent_path().c_str(),
+		_path.object_name().c_str());
+	logging::trace("{}: query={}", __func__, query);
+
+	std::vector<replica_location> replicas;
+	{
+		const irods::s3::rpc_profiler::timer timer{"GEN_QUERY"};
+		for (auto&& row : irods::query<RcComm>(&_conn, query)) {
+			// The leaf resource is the last element of the hierarchy.
+			const auto& hierarchy = row[1];
+			const auto leaf = hierarchy.substr(hierarchy.rfind(';') + 1);
+			replicas.push_back({std::stoi(row[0]), leaf, row[2]});
+		}
+	}
+
+	rank(replicas, irods::s3::get_replica_selection_policy());
+
+	return replicas;
+} // select_replicas
+
+auto irods::s3::get_replica_connection(
+	const std::string& _client_username,
+	const irods::experimental::filesystem::path& _path,
+	const std::vector<replica_location>& _replicas) -> std::shared_ptr<irods::experimental::client_connection>
+{
+	if (!_replicas.empty() && irods::s3::get_enable_data_redirection()) {
+		const auto& host = _replicas.front().host;
+
+		// Coordinating resources have no host.
+		if (!host.empty() && host != "EMPTY_RESC_HOST") {
+			try {
+				logging::debug(
+					"{}: Reading replica [{}] of [{}] from [{}].",
+					__func__,
+					_replicas.front().replica_number,
+					_path.c_str(),
+					host);
+				return irods::s3::get_dedicated_connection(_client_username, host);
+			}
+			catch (const std::exception& e) {
+				logging::warn("{}: Could not connect to [{}]: {}", __func__, host, e.what());
+			}
+		}
+	}
+
+	return irods::s3::get_data_connection(_client_username, _path, irods::s3::data_transfer_direction::read);
+} // get_replica_connection
+
+irods::s3::replica_read_tracker::replica_read_tracker(std::string _resource)
+	: resource_{std::move(_resource)}
+{
+	std::lock_guard lk{g_stats_mutex};
+	++g_stats[resource_].reads_in_progress;
+} // constructor
+
+irods::s3::replica_read_tracker::~replica_read_tracker()
+{
+	std::lock_guard lk{g_stats_mutex};
+	--g_stats[resource_].reads_in_progress;
+} // destructor
+
+auto irods::s3::replica_read_tracker::resource() const noexcept -> const std::string&
+{
+	return resource_;
+} // resource
+
+auto irods::s3::replica_read_tracker::record_first_byte_latency(std::chrono::steady_clock::duration _latency) -> void
+{
+	const auto us = std::chrono::duration<double, std::micro>(_latency).count();
+
+	std::lock_guard lk{g_stats_mutex};
+	auto& latency = g_stats[resource_].latency;
+	latency = (latency == 0) ? us : (1 - latency_weight) * latency + latency_weight * us;
+} // record_first_byte_latency
@@ -0,0 +1,194 @@
+#include "irods/private/s3_api/rpc_profiler.hpp"
+#include "irods/private/s3_api/log.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <utility>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<bool> g_enabled{false};
+
+	// The profile of the request being served by this thread.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	thread_local std::shared_ptr<irods::s3::rpc_profiler::request_profile> t_current;
+
+	// Process-wide totals keyed by S3 operation and then iRODS operation.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::mutex g_totals_mutex;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::map<std::string, std::map<std::string, irods::s3::rpc_profiler::api_stats>> g_totals;
+
+	auto merge(irods::s3::rpc_profiler::api_stats& _into, const irods::s3::rpc_profiler::api_stats& _from) -> void
+	{
+		_into.calls += _from.calls;
+		_into.errors += _from.errors;
+		_into.total += _from.total;
+		_into.max = std::max(_into.max, _from.max);
+	} // merge
+
+	auto to_microseconds(std::chrono::nanoseconds _d) -> std::int64_t
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(_d).count();
+	} // to_microseconds
+} // anonymous namespace
+
+namespace irods::s3::rpc_profiler
+{
+	request_profile::request_profile(std::string _operation)
+		: operation_{std::move(_operation)}
+		, start_{std::chrono::steady_clock::now()}
+	{
+	} // constructor
+
+	request_profile::~request_profile()
+	{
+		try {
+			const auto elapsed = std::chrono::steady_clock::now() - start_;
+
+			std::uint64_t calls = 0;
+			std::chrono::nanoseconds in_irods{};
+			std::string breakdown;
+
+			for (const auto& [name, s] : stats_) {
+				calls += s.calls;
+				in_irods += s.total;
+				breakdown += fmt::format(
+					"{}{} x{} {}us",
+					breakdown.empty() ? "" : ", ",
+					name,
+					s.calls,
+					to_microseconds(s.total));
+			}
+
+			logging::debug(
+				"{}: [{}] made [{}] iRODS operations taking [{}us] of [{}us] total: [{}]",
+				__func__,
+				operation_,
+				calls,
+				to_microseconds(in_irods),
+				to_microseconds(elapsed),
+				breakdown);
+
+			std::lock_guard lk{g_totals_mutex};
+			auto& totals = g_totals[operation_];
+			for (const auto& [name, s] : stats_) {
+				merge(totals[name], s);
+			}
+		}
+		catch (...) {
+		}
+	} // destructor
+
+	auto request_profile::operation() const noexcept -> const std::string&
+	{
+		return operation_;
+	} // operation
+
+	auto request_profile::record(const std::string& _name, std::chrono::nanoseconds _elapsed, bool _failed) -> void
+	{
+		std::lock_guard lk{mutex_};
+		auto& s = stats_[_name];
+		++s.calls;
+		s.errors += _failed ? 1 : 0;
+		s.total += _elapsed;
+		s.max = std::max(s.max, _elapsed);
+	} // record
+
+	auto request_profile::stats() const -> std::map<std::string, api_stats>
+	{
+		std::lock_guard lk{mutex_};
+		return stats_;
+	} // stats
+
+	scope::scope(std::string _operation)
+		: previous_{std::exchange(
+			  t_current,
+			  is_enabled() ? std::make_shared<request_profile>(std::move(_operation)) : nullptr)}
+	{
+	} // constructor
+
+	scope::scope(std::shared_ptr<request_profile> _profile) noexcept
+		: previous_{std::exchange(t_current, std::move(_profile))}
+	{
+	} // constructor
+
+	scope::~scope()
+	{
+		t_current = std::move(previous_);
+	} // destructor
+
+	auto current() noexcept -> std::shared_ptr<request_profile>
+	{
+		return t_current;
+	} // current
+
+	auto set_enabled(bool _enabled) noexcept -> void
+	{
+		g_enabled.store(_enabled);
+	} // set_enabled
+
+	auto is_enabled() noexcept -> bool
+	{
+		return g_enabled.load(std::memory_order_relaxed);
+	} // is_enabled
+
+	timer::timer(const char* _name) noexcept
+		: profile_{is_enabled() ? t_current : nullptr}
+		, name_{_name}
+		, start_{profile_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}}
+		, uncaught_exceptions_{std::uncaught_exceptions()}
+	{
+	} // constructor
+
+	timer::~timer()
+	{
+		stop(std::uncaught_exceptions() > uncaught_exceptions_);
+	} // destructor
+
+	auto timer::stop(bool _failed) noexcept -> void
+	{
+		if (!profile_) {
+			return;
+		}
+
+		try {
+			profile_->record(name_, std::chrono::steady_clock::now() - start_, _failed);
+		}
+		catch (...) {
+		}
+
+		profile_.reset();
+	} // stop
+
+	auto snapshot() -> nlohmann::json
+	{
+		auto result = nlohmann::json::object();
+
+		std::lock_guard lk{g_totals_mutex};
+		for (const auto& [operation, apis] : g_totals) {
+			auto& op = result[operation];
+			for (const auto& [name, s] : apis) {
+				op[name] = {
+					{"calls", s.calls},
+					{"errors", s.errors},
+					{"total_in_microseconds", to_microseconds(s.total)},
+					{"max_in_microseconds", to_microseconds(s.max)}};
+			}
+		}
+
+		return result;
+	} // snapshot
+
+	auto log_report() -> void
+	{
+		logging::info("{}: iRODS operations by S3 operation: {}", __func__, snapshot().dump());
+	} // log_report
+} // namespace irods::s3::rpc_profiler
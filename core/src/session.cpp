@@ -2,8 +2,10 @@
 
 #include "irods/private/s3_api/globals.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/s3_api.hpp"
 #include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/zerocopy.hpp"
 
 #include <boost/beast/version.hpp>
 #include <boost/asio/dispatch.hpp>
@@ -17,6 +19,9 @@
 
 #include <nlohmann/json.hpp>
 
+#include <sys/socket.h>
+
+#include <cerrno>
 #include <chrono>
 #include <iterator>
 #include <utility>
@@ -53,6 +58,15 @@ namespace irods::http
 	{
 	} // session (constructor)
 
+	session::~session()
+	{
+		// The socket is closed once the stream is destroyed. Zero-copy sends which the kernel has not
+		// released yet must not be retransmitted from buffers which are about to be reused.
+		if (zerocopy_writer_ && *zerocopy_writer_) {
+			(*zerocopy_writer_)->detach();
+		}
+	} // session (destructor)
+
 	auto session::ip() const -> std::string
 	{
 		return stream_.socket().remote_endpoint().address().to_string();
@@ -147,7 +161,8 @@ namespace irods::http
 					if (f != params.end() && (*f).value == "2") {
 						logging::debug("{}: ListObjects detected", __func__);
 						auto shared_this = shared_from_this();
-						irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+						irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+							const irods::s3::rpc_profiler::scope profile{"ListObjectsV2"};
 							// build the url_view - must be done within background task as url_view is not copyable
 							boost::urls::url url;
 							get_url_from_parser(*parser, url);
@@ -160,7 +175,8 @@ namespace irods::http
 					if (req_.target() == "/") {
 						logging::debug("{}: ListBuckets detected", __func__);
 						auto shared_this = shared_from_this();
-						irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+						irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+							const irods::s3::rpc_profiler::scope profile{"ListBuckets"};
 							// build the url_view - must be done within background task as url_view is not copyable
 							boost::urls::url url;
 							get_url_from_parser(*parser, url);
@@ -204,6 +220,7 @@ namespace irods::http
 						logging::debug("{}: GetObject detected", __func__);
 						auto shared_this = shared_from_this();
 						irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+							const irods::s3::rpc_profiler::scope profile{"GetObject"};
 							// build the url_view - must be done within background task as url_view is not copyable
 							boost::urls::url url;
 							get_url_from_parser(*parser, url);
@@ -218,6 +235,7 @@ namespace irods::http
 					logging::debug("{}: CopyObject detected", __func__);
 					auto shared_this = shared_from_this();
 					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"CopyObject"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -230,6 +248,7 @@ namespace irods::http
 					logging::debug("{}: PutObject detected", __func__);
 					auto shared_this = shared_from_this();
 					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"PutObject"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -246,7 +265,8 @@ namespace irods::http
 				else if (params.find("uploadId") != params.end()) {
 					logging::debug("{}: AbortMultipartUpload detected", __func__);
 					auto shared_this = shared_from_this();
-					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+					irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"AbortMultipartUpload"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -257,7 +277,8 @@ namespace irods::http
 				else {
 					logging::debug("{}: DeleteObject detected", __func__);
 					auto shared_this = shared_from_this();
-					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+					irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"DeleteObject"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -271,7 +292,8 @@ namespace irods::http
 				if (1 == segments.size()) {
 					logging::debug("{}: HeadBucket detected", __func__);
 					auto shared_this = shared_from_this();
-					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+					irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"HeadBucket"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -282,7 +304,8 @@ namespace irods::http
 				else {
 					logging::debug("{}: HeadObject detected", __func__);
 					auto shared_this = shared_from_this();
-					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+					irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"HeadObject"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -296,7 +319,8 @@ namespace irods::http
 				if (params.contains("delete")) {
 					logging::debug("{}: DeleteObjects detected", __func__);
 					auto shared_this = shared_from_this();
-					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+					irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"DeleteObjects"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -304,11 +328,24 @@ namespace irods::http
 						irods::s3::actions::handle_deleteobjects(shared_this, *parser, url_view);
 					});
 				}
+				else if (params.contains("restore")) {
+					logging::debug("{}: RestoreObject detected", __func__);
+					auto shared_this = shared_from_this();
+					irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"RestoreObject"};
+						// build the url_view - must be done within background task as url_view is not copyable
+						boost::urls::url url;
+						get_url_from_parser(*parser, url);
+						boost::urls::url_view url_view = url;
+						irods::s3::actions::handle_restoreobject(shared_this, *parser, url_view);
+					});
+				}
 				else if (const auto upload_id_param = url.params().find("uploadId");
 				         upload_id_param != url.params().end()) {
 					logging::debug("{}: CompleteMultipartUpload detected", __func__);
 					auto shared_this = shared_from_this();
 					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"CompleteMultipartUpload"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -319,7 +356,8 @@ namespace irods::http
 				else {
 					logging::debug("{}: CreateMultipartUpload detected", __func__);
 					auto shared_this = shared_from_this();
-					irods::http::globals::background_task([shared_this, &parser = this->parser_]() mutable {
+					irods::http::globals::metadata_task([shared_this, &parser = this->parser_]() mutable {
+						const irods::s3::rpc_profiler::scope profile{"CreateMultipartUpload"};
 						// build the url_view - must be done within background task as url_view is not copyable
 						boost::urls::url url;
 						get_url_from_parser(*parser, url);
@@ -357,6 +395,58 @@ namespace irods::http
 		do_read();
 	} // on_write
 
+	auto session::watch_for_disconnect(std::function<void()> _on_disconnect) -> void
+	{
+		// The watch must not keep the session alive once the response is complete.
+		stream_.socket().async_wait(
+			boost::asio::socket_base::wait_read,
+			[weak = weak_from_this(), on_disconnect = std::move(_on_disconnect), fn = __func__](
+				boost::beast::error_code _ec) mutable {
+				const auto self = weak.lock();
+				if (!self) {
+					return;
+				}
+
+				// The wait was cancelled, e.g. by another operation on the socket. That is not a disconnect.
+				if (_ec == boost::asio::error::operation_aborted) {
+					return;
+				}
+
+				if (!_ec) {
+					// The socket is readable. Peek to tell the end of the stream from another request.
+					char c{};
+					const auto n = ::recv(self->stream_.socket().native_handle(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+
+					if (n > 0) {
+						return;
+					}
+
+					if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+						self->watch_for_disconnect(std::move(on_disconnect));
+						return;
+					}
+				}
+
+				logging::debug("{}: Client disconnected.", fn);
+				self->stream_.cancel();
+				on_disconnect();
+			});
+	} // watch_for_disconnect
+
+	auto session::zerocopy_writer() -> std::shared_ptr<irods::s3::zerocopy_writer>
+	{
+		// A kernel without MSG_ZEROCOPY is only asked once per session.
+		if (!zerocopy_writer_) {
+			zerocopy_writer_.emplace();
+			if (irods::s3::get_zerocopy_enabled()) {
+				const auto min_write_size = irods::s3::get_zerocopy_min_write_size_in_bytes();
+				*zerocopy_writer_ = irods::s3::zerocopy_writer::create(stream_.socket(), min_write_size);
+			}
+		}
+
+		return *zerocopy_writer_;
+	} // zerocopy_writer
+
 	auto session::do_close() -> void
 	{
 		// Send a TCP shutdown.
@@ -0,0 +1,114 @@
+#include "irods/private/s3_api/small_object.hpp"
+#include "irods/private/s3_api/common.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+
+#include <irods/dataObjGet.h>
+#include <irods/dataObjInpOut.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/oprComplete.h>
+#include <irods/rcMisc.h>
+#include <irods/rodsKeyWdDef.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// The number of idle buffers kept for later requests. Buffers beyond that are freed.
+	constexpr std::size_t max_pooled_buffers = 64;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::mutex g_pool_mutex;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::vector<std::unique_ptr<std::vector<char>>> g_pool;
+
+	// Returns a buffer of _size bytes which goes back to the pool when the last reference is dropped.
+	auto acquire_buffer(std::size_t _size) -> std::shared_ptr<std::vector<char>>
+	{
+		std::unique_ptr<std::vector<char>> buffer;
+		{
+			std::lock_guard lk{g_pool_mutex};
+			if (!g_pool.empty()) {
+				buffer = std::move(g_pool.back());
+				g_pool.pop_back();
+			}
+		}
+
+		if (!buffer) {
+			buffer = std::make_unique<std::vector<char>>();
+		}
+		buffer->resize(_size);
+
+		return {buffer.release(), [](std::vector<char>* _buffer) {
+					std::unique_ptr<std::vector<char>> buffer{_buffer};
+
+					std::lock_guard lk{g_pool_mutex};
+					if (g_pool.size() < max_pooled_buffers) {
+						g_pool.push_back(std::move(buffer));
+					}
+				}};
+	} // acquire_buffer
+} // anonymous namespace
+
+auto irods::s3::read_small_object(
+	RcComm& _conn,
+	const irods::experimental::filesystem::path& _path,
+	std::uint64_t _size,
+	std::optional<int> _replica_number) -> std::shared_ptr<std::vector<char>>
+{
+	DataObjInp input{};
+	irods::at_scope_exit clear_options{[&input] { clearKeyVal(&input.condInput); }};
+	irods::strncpy_null_terminated(input.objPath, _path.c_str());
+	input.dataSize = static_cast<rodsLong_t>(_size);
+	input.oprType = GET_OPR;
+
+	if (_replica_number) {
+		addKeyVal(&input.condInput, REPL_NUM_KW, std::to_string(*_replica_number).c_str());
+	}
+	else if (const auto resource = irods::s3::get_resource(); !resource.empty()) {
+		addKeyVal(&input.condInput, RESC_NAME_KW, resource.c_str());
+	}
+
+	// The server returns the bytes in the reply when they fit in a single buffer. Otherwise it opens
+	// a portal for a parallel transfer, which the caller is better off doing through a stream.
+	PortalOprOut* portal = nullptr;
+	BytesBuf contents{};
+	irods::at_scope_exit free_outputs{[&portal, &contents] {
+		std::free(portal); // NOLINT(cppcoreguidelines-no-malloc)
+		std::free(contents.buf); // NOLINT(cppcoreguidelines-no-malloc)
+	}};
+
+	const auto ec = irods::s3::rpc_profiler::timed(
+		"DATA_OBJ_GET", [&] { return _rcDataObjGet(&_conn, &input, &portal, &contents); });
+	if (ec < 0) {
+		logging::debug("{}: Could not read [{}] in one call. ec=[{}]", __func__, _path.c_str(), ec);
+		return nullptr;
+	}
+
+	if (ec > 0 && contents.len == 0) {
+		if (portal) {
+			irods::s3::rpc_profiler::timed("OPR_COMPLETE", [&] { return rcOprComplete(&_conn, portal->l1descInx); });
+		}
+		logging::debug("{}: iRODS chose a parallel transfer for [{}].", __func__, _path.c_str());
+		return nullptr;
+	}
+
+	// The object changed since it was looked up in the catalog.
+	if (static_cast<std::uint64_t>(contents.len) != _size) {
+		logging::debug(
+			"{}: Expected [{}] bytes of [{}] but received [{}].", __func__, _size, _path.c_str(), contents.len);
+		return nullptr;
+	}
+
+	auto buffer = acquire_buffer(_size);
+	std::memcpy(buffer->data(), contents.buf, _size);
+
+	return buffer;
+} // read_small_object
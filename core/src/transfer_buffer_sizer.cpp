@@ -0,0 +1,106 @@
+#include "irods/private/s3_api/transfer_buffer_sizer.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/log.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// The bytes held by the buffers of all transfers.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_reserved_bytes{0};
+
+	// Reserves _bytes from the budget if they fit.
+	auto try_reserve(std::uint64_t _bytes) -> bool
+	{
+		const auto budget = irods::s3::get_transfer_buffer_budget_in_bytes();
+		auto reserved = g_reserved_bytes.load();
+
+		do {
+			if (reserved + _bytes > budget) {
+				return false;
+			}
+		} while (!g_reserved_bytes.compare_exchange_weak(reserved, reserved + _bytes));
+
+		return true;
+	} // try_reserve
+
+	// A buffer must move at least this much more data per second than the best smaller buffer to
+	// justify growing again.
+	constexpr double required_improvement = 1.1;
+
+	// The number of samples at a size which may fail to improve before growth stops.
+	constexpr int max_misses = 3;
+} // anonymous namespace
+
+irods::s3::transfer_buffer_sizer::transfer_buffer_sizer(
+	std::uint64_t _initial_size,
+	std::uint64_t _expected_bytes,
+	std::uint64_t _buffer_count)
+	: buffer_count_{std::max<std::uint64_t>(_buffer_count, 1)}
+{
+	const auto initial = std::max<std::uint64_t>(_initial_size, 1);
+	maximum_ = std::max(initial, irods::s3::get_max_transfer_buffer_size_in_bytes());
+	size_ = initial;
+
+	if (_expected_bytes > 0) {
+		// Large transfers start with larger buffers and no buffer is larger than the transfer.
+		maximum_ = std::min(maximum_, _expected_bytes);
+		size_ = std::min(std::max(initial, _expected_bytes / 1024), maximum_);
+	}
+
+	// The starting size is granted even if the budget is exhausted.
+	reserved_ = size_ * buffer_count_;
+	g_reserved_bytes += reserved_;
+} // constructor
+
+irods::s3::transfer_buffer_sizer::~transfer_buffer_sizer()
+{
+	g_reserved_bytes -= reserved_;
+} // destructor
+
+auto irods::s3::transfer_buffer_sizer::size() const noexcept -> std::uint64_t
+{
+	return size_;
+} // size
+
+auto irods::s3::transfer_buffer_sizer::record(std::uint64_t _bytes, std::chrono::steady_clock::duration _elapsed)
+	-> std::uint64_t
+{
+	if (settled_ || _bytes < size_) {
+		return size_;
+	}
+
+	const auto seconds = std::max(std::chrono::duration<double>(_elapsed).count(), 1e-6);
+	const auto rate = static_cast<double>(_bytes) / seconds;
+
+	if (best_rate_ > 0 && rate < best_rate_ * required_improvement) {
+		settled_ = ++misses_ >= max_misses;
+		return size_;
+	}
+
+	best_rate_ = std::max(best_rate_, rate);
+	misses_ = 0;
+
+	if (size_ >= maximum_) {
+		settled_ = true;
+		return size_;
+	}
+
+	const auto new_size = std::min(size_ * 2, maximum_);
+	const auto additional_bytes = (new_size - size_) * buffer_count_;
+
+	if (!try_reserve(additional_bytes)) {
+		logging::debug("{}: Transfer buffer budget exhausted. Keeping buffers at [{}] bytes.", __func__, size_);
+		settled_ = true;
+		return size_;
+	}
+
+	reserved_ += additional_bytes;
+	size_ = new_size;
+
+	return size_;
+} // record
@@ -0,0 +1,140 @@
+#include "irods/private/s3_api/vault_read.hpp"
+#include "irods/private/s3_api/configuration.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+
+#include <irods/irods_exception.hpp>
+#include <irods/irods_query.hpp>
+#include <irods/query_builder.hpp>
+
+#include <fmt/format.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <string>
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_lookups{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_opened{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_no_local_replica{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_failed_opens{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_bytes_served{0};
+
+	auto is_local(const std::string& _host) -> bool
+	{
+		const auto& local_hosts = irods::s3::get_replica_selection_local_hosts();
+		return std::find(std::begin(local_hosts), std::end(local_hosts), _host) != std::end(local_hosts);
+	} // is_local
+
+	// Opens _physical_path if it is a regular file of _size bytes.
+	auto open_vault_file(const std::string& _physical_path, std::uint64_t _size)
+		-> std::optional<irods::s3::disk_cache::file>
+	{
+		const auto fd = ::open(_physical_path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			logging::debug("{}: Could not open [{}]. errno=[{}]", __func__, _physical_path, errno);
+			return std::nullopt;
+		}
+
+		irods::s3::disk_cache::file file{fd};
+
+		// A file whose size differs from the catalog's is being written, or was changed outside of
+		// iRODS. Either way, iRODS knows better what to return.
+		struct stat st{};
+		if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || static_cast<std::uint64_t>(st.st_size) != _size) {
+			logging::debug("{}: [{}] does not match the catalog.", __func__, _physical_path);
+			return std::nullopt;
+		}
+
+		return file;
+	} // open_vault_file
+} // anonymous namespace
+
+auto irods::s3::vault_reads::open(
+	RcComm& _conn,
+	const irods::experimental::filesystem::path& _path,
+	std::uint64_t _size) -> std::optional<disk_cache::file>
+{
+	++g_lookups;
+
+	const auto query = fmt::format(
+		"select DATA_REPL_NUM, DATA_PATH, RESC_TYPE_NAME, RESC_LOC, COLL_NAME, DATA_NAME where {} and "
+		"DATA_REPL_STATUS = '1'",
+		make_data_object_condition(_path));
+	logging::trace("{}: query={}", __func__, query);
+
+	bool found_local_replica = false;
+
+	try {
+		for (auto&& row : irods::query<RcComm>(&_conn, query)) {
+			if (!is_data_object(_path, row[4], row[5]) || row[2] != "unixfilesystem" || !is_local(row[3])) {
+				continue;
+			}
+
+			found_local_replica = true;
+
+			if (auto file = open_vault_file(row[1], _size); file) {
+				logging::debug("{}: Reading replica [{}] of [{}] from [{}].", __func__, row[0], _path.c_str(), row[1]);
+				++g_opened;
+				return file;
+			}
+		}
+	}
+	catch (const irods::exception& e) {
+		logging::warn(
+			"{}: Could not look up the replicas of [{}]: {}", __func__, _path.c_str(), e.client_display_what());
+		++g_failed_opens;
+		return std::nullopt;
+	}
+
+	++(found_local_replica ? g_failed_opens : g_no_local_replica);
+	return std::nullopt;
+} // open
+
+auto irods::s3::vault_reads::record_bytes_served(std::uint64_t _bytes) noexcept -> void
+{
+	g_bytes_served += _bytes;
+} // record_bytes_served
+
+auto irods::s3::vault_reads::stats() -> statistics
+{
+	statistics result;
+	result.lookups = g_lookups.load();
+	result.opened = g_opened.load();
+	result.no_local_replica = g_no_local_replica.load();
+	result.failed_opens = g_failed_opens.load();
+	result.bytes_served = g_bytes_served.load();
+	return result;
+} // stats
+
+auto irods::s3::vault_reads::log_report() -> void
+{
+	const auto s = stats();
+
+	logging::info(
+		"{}: Served [{}] of [{}] reads from a local vault, [{}] bytes in total. [{}] reads had no local "
+		"replica and [{}] could not open it.",
+		__func__,
+		s.opened,
+		s.lookups,
+		s.bytes_served,
+		s.no_local_replica,
+		s.failed_opens);
+} // log_report
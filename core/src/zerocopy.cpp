@@ -0,0 +1,466 @@
+#include "irods/private/s3_api/zerocopy.hpp"
+#include "irods/private/s3_api/log.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// Older C library headers lack the constants of MSG_ZEROCOPY (Linux 4.14).
+#ifndef SO_ZEROCOPY
+#  define SO_ZEROCOPY 60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#  define MSG_ZEROCOPY 0x4000000
+#endif
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#  define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#  define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_bytes_sent_zerocopy{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_bytes_sent_copied{0};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::atomic<std::uint64_t> g_sends_copied_by_kernel{0};
+
+	// The release callbacks of writes whose connection could not be reset. The kernel may still send
+	// from their buffers, so the callbacks are kept, and never run, for the life of the process.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::mutex g_leaked_writes_mutex;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::vector<std::function<void()>> g_leaked_writes;
+
+	// The totals at the time of the previous report.
+	struct report_state
+	{
+		std::uint64_t bytes_sent_zerocopy = 0;
+		std::uint64_t bytes_sent_copied = 0;
+		std::uint64_t sends_copied_by_kernel = 0;
+		double cpu_seconds = 0;
+	}; // struct report_state
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::mutex g_report_mutex;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	report_state g_last_report;
+
+	auto process_cpu_seconds() -> double
+	{
+		rusage usage{};
+		if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+			return 0;
+		}
+
+		const auto seconds = [](const timeval& _tv) {
+			return static_cast<double>(_tv.tv_sec) + static_cast<double>(_tv.tv_usec) / 1e6;
+		};
+
+		return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+	} // process_cpu_seconds
+} // anonymous namespace
+
+auto irods::s3::zerocopy_writer::create(boost::asio::ip::tcp::socket& _socket, std::size_t _min_write_size)
+	-> std::shared_ptr<zerocopy_writer>
+{
+	const int enable = 1;
+	if (::setsockopt(_socket.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) != 0) {
+		logging::debug("{}: MSG_ZEROCOPY is not available. errno=[{}]", __func__, errno);
+		return nullptr;
+	}
+
+	return std::make_shared<zerocopy_writer>(_socket, _min_write_size);
+} // create
+
+irods::s3::zerocopy_writer::zerocopy_writer(boost::asio::ip::tcp::socket& _socket, std::size_t _min_write_size)
+	: socket_{_socket}
+	, min_write_size_{_min_write_size}
+	, timer_{_socket.get_executor()}
+	, notification_timer_{_socket.get_executor()}
+{
+} // constructor
+
+auto irods::s3::zerocopy_writer::write(
+	const char* _data,
+	std::size_t _size,
+	std::chrono::seconds _timeout,
+	std::function<void(boost::system::error_code)> _on_sent,
+	std::function<void()> _on_released) -> void
+{
+	data_ = _data;
+	remaining_ = _size;
+	timeout_ = _timeout;
+	on_sent_ = std::move(_on_sent);
+	copy_ = false;
+
+	{
+		std::lock_guard lk{mutex_};
+		++write_id_;
+		pending_[write_id_].on_released = std::move(_on_released);
+	}
+
+	send();
+} // write
+
+auto irods::s3::zerocopy_writer::send() -> void
+{
+	const auto fd = socket_.native_handle();
+
+	while (remaining_ > 0) {
+		const bool zerocopy = !copy_ && remaining_ >= min_write_size_;
+		const auto flags = MSG_DONTWAIT | MSG_NOSIGNAL | (zerocopy ? MSG_ZEROCOPY : 0);
+		const auto n = ::send(fd, data_, remaining_, flags);
+
+		if (n > 0) {
+			// The kernel numbers every send with MSG_ZEROCOPY which takes bytes.
+			if (zerocopy) {
+				std::lock_guard lk{mutex_};
+				write_of_sequence_.emplace(next_sequence_++, write_id_);
+				++pending_[write_id_].unreleased;
+			}
+
+			zerocopy::record_bytes_sent(static_cast<std::uint64_t>(n), zerocopy);
+			data_ += n;
+			remaining_ -= static_cast<std::size_t>(n);
+			continue;
+		}
+
+		if (errno == EINTR) {
+			continue;
+		}
+
+		// The notifications of the socket exceed net.core.optmem_max. The rest of the write is copied.
+		if (errno == ENOBUFS && zerocopy) {
+			copy_ = true;
+			continue;
+		}
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			// The stream's timeout does not cover waits on the socket, so the wait has its own.
+			timer_.expires_after(timeout_);
+			timer_.async_wait([weak = weak_from_this()](boost::system::error_code _ec) {
+				if (const auto self = weak.lock(); self && !_ec) {
+					std::lock_guard lk{self->mutex_};
+					if (!self->detached_) {
+						self->socket_.cancel();
+					}
+				}
+			});
+
+			socket_.async_wait(
+				boost::asio::socket_base::wait_write, [self = shared_from_this()](boost::system::error_code _ec) {
+					self->timer_.cancel();
+
+					if (_ec) {
+						self->finish_write(_ec);
+						return;
+					}
+
+					self->send();
+				});
+			return;
+		}
+
+		finish_write({errno, boost::system::system_category()});
+		return;
+	}
+
+	finish_write({});
+} // send
+
+auto irods::s3::zerocopy_writer::finish_write(boost::system::error_code _ec) -> void
+{
+	auto on_sent = std::move(on_sent_);
+	std::function<void()> on_released;
+
+	{
+		std::lock_guard lk{mutex_};
+		const auto iter = pending_.find(write_id_);
+		iter->second.sent = true;
+
+		if (iter->second.unreleased == 0) {
+			on_released = std::move(iter->second.on_released);
+			pending_.erase(iter);
+		}
+		else {
+			wait_for_notifications();
+		}
+	}
+
+	on_sent(_ec);
+
+	if (on_released) {
+		on_released();
+	}
+
+	// The notifications may never arrive once a write has failed, even if the socket still works.
+	if (_ec) {
+		release_all();
+	}
+} // finish_write
+
+auto irods::s3::zerocopy_writer::detach() -> void
+{
+	release_all();
+
+	std::lock_guard lk{mutex_};
+	detached_ = true;
+	timer_.cancel();
+	notification_timer_.cancel();
+} // detach
+
+auto irods::s3::zerocopy_writer::wait_for_notifications() -> void
+{
+	if (detached_) {
+		return;
+	}
+
+	if (write_of_sequence_.empty()) {
+		notification_timer_.cancel();
+		return;
+	}
+
+	if (waiting_) {
+		return;
+	}
+
+	// Notifications raise an error condition on the socket without an error, which wakes the wait.
+	waiting_ = true;
+	socket_.async_wait(
+		boost::asio::socket_base::wait_error, [self = shared_from_this()](boost::system::error_code _ec) {
+			{
+				std::lock_guard lk{self->mutex_};
+				self->waiting_ = false;
+			}
+
+			if (_ec) {
+				self->release_all();
+				return;
+			}
+
+			self->read_notifications();
+		});
+
+	// The reactor only reports an error condition which arises after the wait was started, so
+	// notifications queued in the meantime are read once more.
+	boost::asio::post(socket_.get_executor(), [weak = weak_from_this()] {
+		if (const auto self = weak.lock(); self) {
+			self->read_notifications();
+		}
+	});
+
+	notification_timer_.expires_after(timeout_);
+	notification_timer_.async_wait([weak = weak_from_this()](boost::system::error_code _ec) {
+		if (const auto self = weak.lock(); self && !_ec) {
+			self->on_notification_timeout();
+		}
+	});
+} // wait_for_notifications
+
+auto irods::s3::zerocopy_writer::read_notifications() -> void
+{
+	std::vector<std::function<void()>> released;
+
+	{
+		std::lock_guard lk{mutex_};
+
+		if (detached_ || !socket_.is_open()) {
+			return;
+		}
+
+		const auto fd = socket_.native_handle();
+
+		const auto release = [this, &released](std::uint32_t _sequence) {
+			const auto iter = write_of_sequence_.find(_sequence);
+			if (iter == std::end(write_of_sequence_)) {
+				return;
+			}
+
+			const auto write = pending_.find(iter->second);
+			write_of_sequence_.erase(iter);
+
+			if (write != std::end(pending_) && --write->second.unreleased == 0 && write->second.sent) {
+				released.push_back(std::move(write->second.on_released));
+				pending_.erase(write);
+			}
+		};
+
+		while (true) {
+			std::array<char, 128> control{};
+			msghdr message{};
+			message.msg_control = control.data();
+			message.msg_controllen = control.size();
+
+			if (::recvmsg(fd, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+
+				// The error queue is empty.
+				break;
+			}
+
+			for (auto* cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+				const bool ip_error = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+				                      (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+				if (!ip_error) {
+					continue;
+				}
+
+				sock_extended_err error{};
+				std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+				if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+					continue;
+				}
+
+				// The kernel copied the bytes after all, e.g. because the route does not support
+				// sending from user pages.
+				if ((error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0) {
+					++g_sends_copied_by_kernel;
+				}
+
+				// A notification covers the inclusive range of sends [ee_info, ee_data].
+				for (auto sequence = error.ee_info;; ++sequence) {
+					release(sequence);
+					if (sequence == error.ee_data) {
+						break;
+					}
+				}
+			}
+		}
+
+		wait_for_notifications();
+	}
+
+	for (auto& on_released : released) {
+		on_released();
+	}
+} // read_notifications
+
+auto irods::s3::zerocopy_writer::on_notification_timeout() -> void
+{
+	read_notifications();
+
+	{
+		std::lock_guard lk{mutex_};
+		if (write_of_sequence_.empty()) {
+			return;
+		}
+
+		logging::warn(
+			"{}: The kernel has not released [{}] zero-copy sends in time. Resetting the connection.",
+			__func__,
+			write_of_sequence_.size());
+	}
+
+	release_all();
+} // on_notification_timeout
+
+auto irods::s3::zerocopy_writer::reset_connection() -> bool
+{
+	if (detached_ || !socket_.is_open()) {
+		return false;
+	}
+
+	// With a zero linger time, closing the socket sends a reset and discards the unacknowledged bytes.
+	boost::system::error_code ec;
+	socket_.set_option(boost::asio::socket_base::linger{true, 0}, ec);
+	socket_.close(ec);
+	return true;
+} // reset_connection
+
+auto irods::s3::zerocopy_writer::release_all() -> void
+{
+	std::vector<std::function<void()>> released;
+
+	{
+		std::lock_guard lk{mutex_};
+
+		// The write in progress, if any, is released when it finishes.
+		for (auto iter = std::begin(pending_); iter != std::end(pending_);) {
+			if (iter->second.sent) {
+				released.push_back(std::move(iter->second.on_released));
+				iter = pending_.erase(iter);
+			}
+			else {
+				++iter;
+			}
+		}
+
+		// The kernel still references the pages of the unreleased sends. It sends from them again if
+		// the client asks for a retransmission, even once the socket is closed.
+		if (!write_of_sequence_.empty() && !reset_connection()) {
+			logging::warn(
+				"{}: Could not reset the connection. Keeping the buffers of [{}] zero-copy writes.",
+				__func__,
+				released.size());
+
+			std::lock_guard leaked_lk{g_leaked_writes_mutex};
+			std::move(std::begin(released), std::end(released), std::back_inserter(g_leaked_writes));
+			released.clear();
+		}
+
+		std::erase_if(write_of_sequence_, [this](const auto& _entry) { return !pending_.contains(_entry.second); });
+	}
+
+	for (auto& on_released : released) {
+		on_released();
+	}
+} // release_all
+
+auto irods::s3::zerocopy::record_bytes_sent(std::uint64_t _bytes, bool _zerocopy) -> void
+{
+	(_zerocopy ? g_bytes_sent_zerocopy : g_bytes_sent_copied) += _bytes;
+} // record_bytes_sent
+
+auto irods::s3::zerocopy::log_report() -> void
+{
+	report_state now;
+	now.bytes_sent_zerocopy = g_bytes_sent_zerocopy.load();
+	now.bytes_sent_copied = g_bytes_sent_copied.load();
+	now.sends_copied_by_kernel = g_sends_copied_by_kernel.load();
+	now.cpu_seconds = process_cpu_seconds();
+
+	report_state last;
+	{
+		std::lock_guard lk{g_report_mutex};
+		last = std::exchange(g_last_report, now);
+	}
+
+	const auto zerocopy_bytes = now.bytes_sent_zerocopy - last.bytes_sent_zerocopy;
+	const auto bytes = zerocopy_bytes + (now.bytes_sent_copied - last.bytes_sent_copied);
+	const auto gigabytes = static_cast<double>(bytes) / 1e9;
+
+	logging::info(
+		"{}: Sent [{}] bytes of GetObject bodies, [{}] of them with MSG_ZEROCOPY. The kernel copied [{}] "
+		"zero-copy sends. The process used [{:.3f}] CPU seconds per GB sent.",
+		__func__,
+		bytes,
+		zerocopy_bytes,
+		now.sends_copied_by_kernel - last.sends_copied_by_kernel,
+		gigabytes > 0 ? (now.cpu_seconds - last.cpu_seconds) / gigabytes : 0.0);
+} // log_report
@@ -4,6 +4,9 @@
 #include "irods/private/s3_api/common_routines.hpp"
 #include "irods/private/s3_api/connection.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_cache.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/session.hpp"
 
@@ -60,7 +63,20 @@ void irods::s3::actions::handle_copyobject(
 		return;
 	}
 	try {
-		fs::client::copy(conn, source_path, destination_path, fs::copy_options::overwrite_existing);
+		if (!irods::s3::stat_object(conn, source_path, *irods_username, irods::s3::stat_sharing::none)) {
+			return irods::s3::api::common_routines::send_error_response(
+				session_ptr,
+				beast::http::status::not_found,
+				"NoSuchKey",
+				"The specified key does not exist.",
+				url2.path(),
+				__FUNCTION__);
+		}
+
+		irods::s3::rpc_profiler::timed("DATA_OBJ_COPY", [&] {
+			fs::client::copy(conn, source_path, destination_path, fs::copy_options::overwrite_existing);
+		});
+		irods::s3::invalidate_cached_object(destination_path.string());
 	}
 	catch (irods::experimental::filesystem::filesystem_error& ex) {
 		switch (ex.code().value()) {
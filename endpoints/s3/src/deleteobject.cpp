@@ -4,6 +4,9 @@
 #include "irods/private/s3_api/common_routines.hpp"
 #include "irods/private/s3_api/connection.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_cache.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/session.hpp"
 
@@ -56,10 +59,6 @@ void irods::s3::actions::handle_deleteobject(
 		return;
 	}
 
-	// Reconnect to the iRODS server as the target user.
-	// The rodsadmin account from the config file will act as the proxy for the user.
-	auto conn = irods::get_connection(*irods_username);
-
 	fs::path path;
 	if (auto bucket = irods::s3::resolve_bucket(url.segments()); bucket.has_value()) {
 		path = bucket.value();
@@ -75,9 +74,23 @@ void irods::s3::actions::handle_deleteobject(
 	logging::debug("{}: Requested to delete {}", __FUNCTION__, path.string());
 
 	try {
-		if (fs::client::exists(conn, path) && not fs::client::is_collection(conn, path)) {
-			if (fs::client::remove(conn, path, experimental::filesystem::remove_options::no_trash)) {
+		// The lookup is idempotent, so it is retried on a new connection if the pooled connection
+		// turns out to be stale. The removal itself is never retried.
+		const bool is_data_object = irods::with_catalog_retry(*irods_username, [&path, &irods_username](auto& conn) {
+			return irods::s3::stat_object(conn, path, *irods_username, irods::s3::stat_sharing::none).has_value();
+		});
+
+		if (is_data_object) {
+			// Reconnect to the iRODS server as the target user.
+			// The rodsadmin account from the config file will act as the proxy for the user.
+			auto conn = irods::get_connection(*irods_username);
+
+			const auto removed = irods::s3::rpc_profiler::timed("DATA_OBJ_UNLINK", [&] {
+				return fs::client::remove(conn, path, experimental::filesystem::remove_options::no_trash);
+			});
+			if (removed) {
 				logging::debug("{}: Remove {} successful", __FUNCTION__, path.string());
+				irods::s3::invalidate_cached_object(path.string());
 				response.result(beast::http::status::ok);
 			}
 			else {
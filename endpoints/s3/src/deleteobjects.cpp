@@ -3,7 +3,11 @@
 #include "irods/private/s3_api/bucket.hpp"
 #include "irods/private/s3_api/common_routines.hpp"
 #include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/globals.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_cache.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/session.hpp"
 
@@ -44,6 +48,16 @@ namespace beast = boost::beast;
 namespace fs = irods::experimental::filesystem;
 namespace logging = irods::http::logging;
 
+namespace
+{
+	// Deletes the objects listed in the request body.
+	void delete_objects(
+		irods::http::session_pointer_type session_ptr,
+		const std::string& irods_username,
+		const std::string& request_body,
+		const boost::urls::url_view& url);
+} // namespace
+
 void irods::s3::actions::handle_deleteobjects(
 	irods::http::session_pointer_type session_ptr,
 	boost::beast::http::request_parser<boost::beast::http::empty_body>& empty_body_parser,
@@ -61,175 +75,195 @@ void irods::s3::actions::handle_deleteobjects(
 		return;
 	}
 
-	// change the parser to a string_body parser and read the body
-	empty_body_parser.eager(true);
-	beast::http::request_parser<boost::beast::http::string_body> parser{std::move(empty_body_parser)};
-	beast::http::read(session_ptr->stream().socket(), session_ptr->get_buffer(), parser);
+	// change the parser to a string_body parser and read the body without blocking this thread
+	irods::s3::api::common_routines::read_string_body_async(
+		session_ptr,
+		empty_body_parser,
+		irods::http::globals::metadata_task,
+		[session_ptr, irods_username = *irods_username, url = boost::urls::url{url}](auto _parser) {
+			delete_objects(session_ptr, irods_username, _parser->get().body(), url);
+		},
+		__FUNCTION__);
+} // handle_deleteobjects
 
-	// Reconnect to the iRODS server as the target user.
-	// The rodsadmin account from the config file will act as the proxy for the user.
-	auto conn = irods::get_connection(*irods_username);
+namespace
+{
+	void delete_objects(
+		irods::http::session_pointer_type session_ptr,
+		const std::string& irods_username,
+		const std::string& request_body,
+		const boost::urls::url_view& url)
+	{
+		beast::http::response<beast::http::string_body> response;
 
-	fs::path path;
-	if (auto bucket = irods::s3::resolve_bucket(url.segments()); bucket.has_value()) {
-		path = bucket.value();
-	}
-	else {
-		response.result(beast::http::status::not_found);
-		logging::debug("{}: Could not find bucket", __FUNCTION__);
-		logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
-		session_ptr->send(std::move(response));
-		return;
-	}
+		// Reconnect to the iRODS server as the target user.
+		// The rodsadmin account from the config file will act as the proxy for the user.
+		auto conn = irods::get_connection(irods_username);
 
-	// read and parse the body
-	std::string& request_body = parser.get().body();
+		fs::path path;
+		if (auto bucket = irods::s3::resolve_bucket(url.segments()); bucket.has_value()) {
+			path = bucket.value();
+		}
+		else {
+			response.result(beast::http::status::not_found);
+			logging::debug("{}: Could not find bucket", __FUNCTION__);
+			logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+			session_ptr->send(std::move(response));
+			return;
+		}
 
-	logging::debug("{}: request_body:\n{}", __FUNCTION__, request_body);
-	boost::property_tree::ptree request_body_property_tree;
-	try {
-		std::stringstream ss;
-		ss << request_body;
-		boost::property_tree::read_xml(ss, request_body_property_tree);
-	}
-	catch (boost::property_tree::xml_parser_error& e) {
-		logging::debug("{}: Could not parse XML body.", __FUNCTION__);
-		response.result(boost::beast::http::status::bad_request);
-		logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
-		session_ptr->send(std::move(response));
-		return;
-	}
-	catch (...) {
-		logging::debug("{}: Unknown error parsing XML body.", __FUNCTION__);
-		response.result(boost::beast::http::status::bad_request);
-		logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
-		session_ptr->send(std::move(response));
-		return;
-	}
+		// parse the body
+		logging::debug("{}: request_body:\n{}", __FUNCTION__, request_body);
+		boost::property_tree::ptree request_body_property_tree;
+		try {
+			std::stringstream ss;
+			ss << request_body;
+			boost::property_tree::read_xml(ss, request_body_property_tree);
+		}
+		catch (boost::property_tree::xml_parser_error& e) {
+			logging::debug("{}: Could not parse XML body.", __FUNCTION__);
+			response.result(boost::beast::http::status::bad_request);
+			logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+			session_ptr->send(std::move(response));
+			return;
+		}
+		catch (...) {
+			logging::debug("{}: Unknown error parsing XML body.", __FUNCTION__);
+			response.result(boost::beast::http::status::bad_request);
+			logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+			session_ptr->send(std::move(response));
+			return;
+		}
 
-	bool quiet_flag = true;
-
-	// build a map to hold the key and a string indicating success or failure with reason
-	std::map<std::string, std::string> key_map;
-	try {
-		for (boost::property_tree::ptree::value_type& v : request_body_property_tree.get_child("Delete")) {
-			const std::string& tag = v.first;
-			if (tag == "Quiet") {
-				quiet_flag = v.second.get_value<bool>();
-				logging::debug("{}: quiet tag value={}", __FUNCTION__, v.second.data());
-				continue;
-			}
-			else if (tag == "Object") {
-				const boost::property_tree::ptree& v2 = v.second;
-				std::string key = path.string() + "/" + v2.get<std::string>("Key");
-				key_map[key] = "";
+		bool quiet_flag = true;
+
+		// build a map to hold the key and a string indicating success or failure with reason
+		std::map<std::string, std::string> key_map;
+		try {
+			for (boost::property_tree::ptree::value_type& v : request_body_property_tree.get_child("Delete")) {
+				const std::string& tag = v.first;
+				if (tag == "Quiet") {
+					quiet_flag = v.second.get_value<bool>();
+					logging::debug("{}: quiet tag value={}", __FUNCTION__, v.second.data());
+					continue;
+				}
+				else if (tag == "Object") {
+					const boost::property_tree::ptree& v2 = v.second;
+					std::string key = path.string() + "/" + v2.get<std::string>("Key");
+					key_map[key] = "";
+				}
 			}
 		}
-	}
-	catch (...) {
-		logging::debug("{}: Error parsing XML body.", __FUNCTION__);
-		response.result(boost::beast::http::status::bad_request);
-		logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
-		session_ptr->send(std::move(response));
-		return;
-	}
-	logging::debug("{}: quiet_flag={}", __FUNCTION__, quiet_flag);
-	for (const auto& [key, value] : key_map) {
-		logging::debug("{}: key={}", __FUNCTION__, key);
-		try {
-			if (fs::client::exists(conn, key) && not fs::client::is_collection(conn, key)) {
-				if (fs::client::remove(conn, key, experimental::filesystem::remove_options::no_trash)) {
-					logging::debug("{}: Remove {} successful", __FUNCTION__, key);
-					key_map[key] = "Success";
+		catch (...) {
+			logging::debug("{}: Error parsing XML body.", __FUNCTION__);
+			response.result(boost::beast::http::status::bad_request);
+			logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+			session_ptr->send(std::move(response));
+			return;
+		}
+		logging::debug("{}: quiet_flag={}", __FUNCTION__, quiet_flag);
+		for (const auto& [key, value] : key_map) {
+			logging::debug("{}: key={}", __FUNCTION__, key);
+			try {
+				// Collections and missing objects have no stat.
+				if (irods::s3::stat_object(conn, key, irods_username, irods::s3::stat_sharing::none)) {
+					const auto removed = irods::s3::rpc_profiler::timed("DATA_OBJ_UNLINK", [&] {
+						return fs::client::remove(conn, key, experimental::filesystem::remove_options::no_trash);
+					});
+					if (removed) {
+						logging::debug("{}: Remove {} successful", __FUNCTION__, key);
+						irods::s3::invalidate_cached_object(key);
+						key_map[key] = "Success";
+					}
+					else {
+						logging::debug("{}: Deletion of key {} failed", __FUNCTION__, key);
+						key_map[key] = "InternalError";
+					}
 				}
 				else {
-					logging::debug("{}: Deletion of key {} failed", __FUNCTION__, key);
-					key_map[key] = "InternalError";
+					logging::debug("{}: Could not find object {}", __FUNCTION__, key);
+					key_map[key] = "NoSuchKey";
 				}
 			}
-			else {
-				logging::debug("{}: Could not find object {}", __FUNCTION__, key);
-				key_map[key] = "NoSuchKey";
+			catch (irods::exception& e) {
+				beast::http::response<beast::http::empty_body> response;
+				logging::debug("{}: Exception encountered", __FUNCTION__);
+
+				switch (e.code()) {
+					case USER_ACCESS_DENIED:
+					case CAT_NO_ACCESS_PERMISSION:
+						logging::debug("{}: No access to delete key {}", __FUNCTION__, key);
+						key_map[key] = "AccessDenied";
+						// keep the value false meaning the deletion for this key failed
+						break;
+					default:
+						// unknown exception, just keep the deletion status as false for this object
+						logging::debug("{}: Unknown exception when deleting key {}", __FUNCTION__, key);
+						key_map[key] = "InternalError";
+						break;
+				}
 			}
 		}
-		catch (irods::exception& e) {
-			beast::http::response<beast::http::empty_body> response;
-			logging::debug("{}: Exception encountered", __FUNCTION__);
-
-			switch (e.code()) {
-				case USER_ACCESS_DENIED:
-				case CAT_NO_ACCESS_PERMISSION:
-					logging::debug("{}: No access to delete key {}", __FUNCTION__, key);
-					key_map[key] = "AccessDenied";
-					// keep the value false meaning the deletion for this key failed
-					break;
-				default:
-					// unknown exception, just keep the deletion status as false for this object
-					logging::debug("{}: Unknown exception when deleting key {}", __FUNCTION__, key);
-					key_map[key] = "InternalError";
-					break;
+
+		// Now send the response
+		// Example response:
+		// <DeleteResult>
+		//     <Deleted>
+		//         <Key>key1</Key>
+		//     </Deleted>
+		//     <Deleted>
+		//         <Key>key2</Key>
+		//     <Deleted>
+		//     <Error>
+		//         <Key>key3</Key>
+		//         <Code>AccessDenied</Code>
+		//         <Message>Access Denied</Message>
+		//     </Error>
+		//     <Error>
+		//         <Key>key4</Key>
+		//         <Code>AccessDenied</Code>
+		//         <Message>Access Denied</Message>
+		//     </Error>
+		// </DeleteResult>
+
+		boost::property_tree::ptree document;
+		boost::property_tree::xml_parser::xml_writer_settings<std::string> settings;
+		settings.indent_char = ' ';
+		settings.indent_count = 4;
+		std::stringstream s;
+
+		// iterate over key_map and write all successes
+		bool element_logged = false;
+		if (!quiet_flag) {
+			for (const auto& [key, value] : key_map) {
+				if (value == "Success") {
+					element_logged = true;
+					boost::property_tree::ptree deleted_element;
+					deleted_element.add("Key", key);
+					document.add_child("DeleteResult.Deleted", deleted_element);
+				}
 			}
 		}
-	}
-
-	// Now send the response
-	// Example response:
-	// <DeleteResult>
-	//     <Deleted>
-	//         <Key>key1</Key>
-	//     </Deleted>
-	//     <Deleted>
-	//         <Key>key2</Key>
-	//     <Deleted>
-	//     <Error>
-	//         <Key>key3</Key>
-	//         <Code>AccessDenied</Code>
-	//         <Message>Access Denied</Message>
-	//     </Error>
-	//     <Error>
-	//         <Key>key4</Key>
-	//         <Code>AccessDenied</Code>
-	//         <Message>Access Denied</Message>
-	//     </Error>
-	// </DeleteResult>
-
-	boost::property_tree::ptree document;
-	boost::property_tree::xml_parser::xml_writer_settings<std::string> settings;
-	settings.indent_char = ' ';
-	settings.indent_count = 4;
-	std::stringstream s;
-
-	// iterate over key_map and write all successes
-	bool element_logged = false;
-	if (!quiet_flag) {
+		// iterate over key_map and write all failures
 		for (const auto& [key, value] : key_map) {
-			if (value == "Success") {
+			if (value != "Success") {
 				element_logged = true;
-				boost::property_tree::ptree deleted_element;
-				deleted_element.add("Key", key);
-				document.add_child("DeleteResult.Deleted", deleted_element);
+				boost::property_tree::ptree error_element;
+				error_element.add("Key", key);
+				error_element.add("Code", value);
+				error_element.add("Message", value);
+				document.add_child("DeleteResult.Error", error_element);
 			}
 		}
-	}
-	// iterate over key_map and write all failures
-	for (const auto& [key, value] : key_map) {
-		if (value != "Success") {
-			element_logged = true;
-			boost::property_tree::ptree error_element;
-			error_element.add("Key", key);
-			error_element.add("Code", value);
-			error_element.add("Message", value);
-			document.add_child("DeleteResult.Error", error_element);
+		if (!element_logged) {
+			document.add("DeleteResult", "");
 		}
-	}
-	if (!element_logged) {
-		document.add("DeleteResult", "");
-	}
 
-	boost::property_tree::write_xml(s, document, settings);
-	response.body() = s.str();
-	logging::debug("{}: response\n{}", __FUNCTION__, s.str());
-	response.result(boost::beast::http::status::ok);
-	logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
-	session_ptr->send(std::move(response));
-}
+		boost::property_tree::write_xml(s, document, settings);
+		response.body() = s.str();
+		logging::debug("{}: response\n{}", __FUNCTION__, s.str());
+		response.result(boost::beast::http::status::ok);
+		logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+		session_ptr->send(std::move(response));
+	} // delete_objects
+} // namespace
@@ -1,13 +1,28 @@
 #include "irods/private/s3_api/s3_api.hpp"
+#include "irods/private/s3_api/archive.hpp"
 #include "irods/private/s3_api/authentication.hpp"
 #include "irods/private/s3_api/bucket.hpp"
 #include "irods/private/s3_api/common_routines.hpp"
+#include "irods/private/s3_api/conditional_request.hpp"
 #include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/disk_cache.hpp"
+#include "irods/private/s3_api/hedged_read.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_cache.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/open_handle_cache.hpp"
 #include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/session.hpp"
 #include "irods/private/s3_api/configuration.hpp"
 #include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/parallel_transfer.hpp"
+#include "irods/private/s3_api/prefetch.hpp"
+#include "irods/private/s3_api/replica_selection.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+#include "irods/private/s3_api/small_object.hpp"
+#include "irods/private/s3_api/transfer_buffer_sizer.hpp"
+#include "irods/private/s3_api/vault_read.hpp"
+#include "irods/private/s3_api/zerocopy.hpp"
 
 #include <irods/filesystem.hpp>
 
@@ -33,49 +48,1373 @@
 #include <irods/irods_query.hpp>
 #include <irods/query_builder.hpp>
 #include <irods/rodsErrorTable.h>
+#include <irods/dataObjChksum.h>
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/stacktrace.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 namespace asio = boost::asio;
 namespace beast = boost::beast;
 namespace fs = irods::experimental::filesystem;
 namespace logging = irods::http::logging;
 
-using irods_connection = irods::http::connection_facade;
-using irods_default_transport = irods::experimental::io::client::default_transport;
-using buffer_body_serializer = beast::http::response_serializer<beast::http::buffer_body>;
-using buffer_body_response = beast::http::response<beast::http::buffer_body>;
+using irods_connection = irods::http::connection_facade;
+using irods_default_transport = irods::experimental::io::client::default_transport;
+using buffer_body_serializer = beast::http::response_serializer<beast::http::buffer_body>;
+using buffer_body_response = beast::http::response<beast::http::buffer_body>;
+
+// These are things that need to persist and will be wrapped in std::shared_ptr
+namespace
+{
+	class solo_read;
+
+	struct persistent_data
+	{
+		persistent_data(std::shared_ptr<irods::experimental::client_connection> conn, fs::path path)
+			: conn_ptr{conn}
+			, serializer{response}
+			, xtrans{*conn}
+			, path{std::move(path)}
+		{
+		}
+
+		// The data object is opened once the size is known since large objects are read
+		// over parallel streams instead.
+		//
+		// The replicas chosen by irods_client.replica_selection are tried in order. If none of
+		// them can be opened, iRODS picks a replica in irods_client.resource.
+		auto open() -> void
+		{
+			open(xtrans, d);
+		}
+
+		// Opens the data object into _in, e.g. the stream of a handle which is kept open afterwards.
+		auto open(irods_default_transport& _xtrans, irods::experimental::io::idstream& _in) -> void
+		{
+			for (const auto& replica : replicas) {
+				const irods::experimental::io::replica_number replica_number{replica.replica_number};
+				irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
+				_in.open(_xtrans, path, replica_number, std::ios_base::in);
+				timer.stop(!_in.is_open());
+				if (_in.is_open()) {
+					tracker.emplace(replica.resource);
+					opened_replica_number = replica.replica_number;
+					return;
+				}
+
+				logging::warn(
+					"{}: Could not open replica [{}] of [{}] on [{}]. Trying the next replica.",
+					__func__,
+					replica.replica_number,
+					path.c_str(),
+					replica.resource);
+				_in.clear();
+			}
+
+			irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
+			_in.open(
+				_xtrans,
+				path,
+				irods::experimental::io::root_resource_name{irods::s3::get_resource()},
+				std::ios_base::in);
+			timer.stop(!_in.is_open());
+		}
+
+		// Stops the transfer early, e.g. because the client has gone away. Reads in progress
+		// complete, but no further reads are started. May be called from any thread.
+		auto cancel() -> void
+		{
+			cancelled = true;
+			if (reader) {
+				reader->cancel();
+			}
+		}
+
+		// Closes the data object and the connection to iRODS once a transfer stops early, instead
+		// of whenever the last reference to this object happens to go away. Must not run while a
+		// read is in progress.
+		auto release() -> void
+		{
+			cancel();
+			if (d.is_open()) {
+				irods::s3::rpc_profiler::timed("DATA_OBJ_CLOSE", [this] { d.close(); });
+			}
+			handle.reset();
+			conn_ptr->disconnect();
+
+			if (alternate) {
+				if (alternate->in.is_open()) {
+					irods::s3::rpc_profiler::timed("DATA_OBJ_CLOSE", [this] { alternate->in.close(); });
+				}
+				alternate->conn->disconnect();
+			}
+		}
+
+		// Offers the handle the object was read through to the open handle cache once the response
+		// has been sent, so that the next ranged request skips opening the object. Must not run while
+		// a read is in progress.
+		auto keep_handle() -> void
+		{
+			// The connection of the primary stream is shut down once an alternate replica has won.
+			if (auto* cache = irods::http::globals::open_handle_cache(); cache && handle && !alternate && !cancelled) {
+				cache->give_back(std::move(handle));
+			}
+		}
+
+		// The stream the object is read from. This is the replica which won the hedged read, if
+		// there was one, or the handle kept open for ranged requests.
+		auto stream() -> irods::experimental::io::idstream&
+		{
+			if (alternate) {
+				return alternate->in;
+			}
+			return handle ? handle->in : d;
+		}
+
+		// Reads the next bytes of the object from stream() and returns the number of bytes read, or
+		// 0 on failure. The first read is hedged if hedge is set.
+		auto read(char* _buffer, std::size_t _count) -> std::size_t
+		{
+			const auto start = std::chrono::steady_clock::now();
+			irods::s3::rpc_profiler::timer timer{"DATA_OBJ_READ"};
+			std::size_t count = 0;
+
+			if (auto h = std::move(hedge); h) {
+				count = h->read(*conn_ptr, stream(), _buffer, _count);
+				alternate = h->take_alternate();
+			}
+			else {
+				auto& in = stream();
+				in.read(_buffer, static_cast<std::streamsize>(_count));
+				count = in.bad() ? 0 : static_cast<std::size_t>(in.gcount());
+			}
+
+			timer.stop(count == 0);
+
+			// The first read tells how quickly the chosen resource answers.
+			if (std::exchange(first_read, false) && tracker) {
+				tracker->record_first_byte_latency(std::chrono::steady_clock::now() - start);
+			}
+
+			return count;
+		}
+
+		std::shared_ptr<irods::experimental::client_connection> conn_ptr;
+		buffer_body_response response;
+		buffer_body_serializer serializer;
+		irods_default_transport xtrans;
+		fs::path path;
+		irods::experimental::io::idstream d;
+		std::shared_ptr<irods::s3::parallel_reader> reader;
+
+		// Set when a single range is read through a handle of the open handle cache. The handle holds
+		// a stream on conn_ptr which is used instead of d.
+		std::unique_ptr<irods::s3::read_handle> handle;
+
+		// The good replicas in the order they are tried, or empty if iRODS chooses.
+		std::vector<irods::s3::replica_location> replicas;
+
+		// The replica open() opened, or empty if iRODS chose one.
+		std::optional<int> opened_replica_number;
+
+		// Set while the whole object is read for this request alone, so that a request for the same
+		// version arriving meanwhile starts a shared read.
+		std::unique_ptr<solo_read> solo;
+
+		std::optional<irods::s3::replica_read_tracker> tracker;
+		bool first_read = true;
+
+		// Set when the first read may be hedged against another replica.
+		std::unique_ptr<irods::s3::hedged_read> hedge;
+		std::unique_ptr<irods::s3::replica_stream> alternate;
+
+		// The whole object when it is served from memory instead of the stream.
+		std::shared_ptr<const std::vector<char>> contents;
+
+		std::atomic<bool> cancelled{false};
+	};
+
+	// Streams a byte range of a data object to the client.
+	//
+	// Reads from iRODS and writes to the client socket overlap. Buffers cycle between the two: the
+	// reader fills free buffers on a background thread while the socket sends filled buffers in
+	// order. The buffers grow as the transfer_buffer_sizer sees fit. Together they never hold more
+	// than the read-ahead, or two buffers if that is more, which bounds the memory held by a request.
+	class read_pipeline : public std::enable_shared_from_this<read_pipeline>
+	{
+	  public:
+		read_pipeline(
+			irods::http::session_pointer_type _session_ptr,
+			std::shared_ptr<persistent_data> _data,
+			std::size_t _offset,
+			std::size_t _range_end,
+			std::uint64_t _buffer_size)
+			: session_ptr_{std::move(_session_ptr)}
+			, data_{std::move(_data)}
+			, read_offset_{_offset}
+			, range_end_{_range_end}
+			, read_ahead_{irods::s3::get_get_object_read_ahead_in_bytes()}
+			// Note that ranges are inclusive which is why the +1 exists.
+			, sizer_{_buffer_size, _range_end + 1 - _offset, 2}
+		{
+			// Large bodies are sent with MSG_ZEROCOPY if s3_server.zerocopy is enabled.
+			if (_range_end + 1 - _offset >= irods::s3::get_zerocopy_min_response_size_in_bytes()) {
+				zerocopy_ = session_ptr_->zerocopy_writer();
+			}
+		}
+
+		auto start() -> void
+		{
+			// Nothing to send for an empty object. The header has already been written.
+			if (range_end_ + 1 == read_offset_) {
+				return;
+			}
+
+			reader_idle_ = false;
+			schedule_read();
+		}
+
+	  private:
+		auto schedule_read() -> void
+		{
+			irods::http::globals::background_task([self = shared_from_this()] { self->read(); });
+		}
+
+		// Fills the next free buffer from iRODS. Runs on a background thread.
+		auto read() -> void
+		{
+			const irods::s3::rpc_profiler::scope profile{profile_};
+
+			std::size_t index{};
+			char* buffer{};
+			std::size_t read_length{};
+
+			bool stop = false;
+
+			{
+				std::lock_guard lk{mutex_};
+				if (failed_ || data_->cancelled) {
+					failed_ = true;
+					reader_idle_ = true;
+					stop = true;
+				}
+				else if (read_offset_ > range_end_) {
+					reader_idle_ = true;
+					return;
+				}
+				else {
+					const auto size = sizer_.size();
+
+					// Buffers which are smaller than the current size are released so that they can be
+					// replaced by larger ones.
+					while (!free_.empty() && buffers_[free_.front()].size() < size) {
+						const auto i = free_.front();
+						free_.pop_front();
+						allocated_ -= buffers_[i].size();
+						std::vector<char>{}.swap(buffers_[i]);
+						spare_.push_back(i);
+					}
+
+					if (!free_.empty()) {
+						index = free_.front();
+						free_.pop_front();
+					}
+					else if (allocated_ + size <= std::max<std::uint64_t>(read_ahead_, 2 * size)) {
+						if (spare_.empty()) {
+							spare_.push_back(buffers_.size());
+							buffers_.emplace_back();
+						}
+						index = spare_.back();
+						spare_.pop_back();
+						buffers_[index].resize(size);
+						allocated_ += size;
+					}
+					else {
+						reader_idle_ = true;
+						return;
+					}
+
+					buffer = buffers_[index].data();
+					read_length = std::min<std::size_t>(buffers_[index].size(), range_end_ + 1 - read_offset_);
+				}
+			}
+
+			// The transfer has stopped early. The reader owns the data object, so it closes it.
+			if (stop) {
+				data_->release();
+				return;
+			}
+
+			const auto read_start = std::chrono::steady_clock::now();
+			const auto count = data_->read(buffer, read_length);
+
+			// Only this thread uses the sizer.
+			sizer_.record(count, std::chrono::steady_clock::now() - read_start);
+
+			bool start_writer = false;
+
+			{
+				std::lock_guard lk{mutex_};
+
+				if (count == 0) {
+					// An error occurred on reading from iRODS. We have already sent
+					// the response in the header. All we can do is bail.
+					logging::error("{}: Badbit set on read from iRODS. Bailing...", __func__);
+					failed_ = true;
+				}
+
+				if (failed_ || data_->cancelled) {
+					failed_ = true;
+					reader_idle_ = true;
+					stop = true;
+				}
+				else {
+					read_offset_ += count;
+					filled_.emplace_back(index, count);
+
+					start_writer = writer_idle_;
+					writer_idle_ = false;
+				}
+			}
+
+			if (stop) {
+				data_->release();
+				return;
+			}
+
+			if (start_writer) {
+				write();
+			}
+
+			schedule_read();
+		}
+
+		// Sends the oldest filled buffer to the client.
+		auto write() -> void
+		{
+			std::size_t index{};
+			char* buffer{};
+			std::size_t count{};
+			bool last = false;
+
+			{
+				std::lock_guard lk{mutex_};
+				if (failed_ || filled_.empty()) {
+					writer_idle_ = true;
+					return;
+				}
+				std::tie(index, count) = filled_.front();
+				filled_.pop_front();
+				buffer = buffers_[index].data();
+				last = filled_.empty() && read_offset_ > range_end_;
+			}
+
+			// With MSG_ZEROCOPY, the kernel sends from the buffer itself. The buffer is reused once
+			// the kernel has released it, which may be long after the write has completed.
+			if (zerocopy_) {
+				zerocopy_->write(
+					buffer,
+					count,
+					session_ptr_->timeout(),
+					[self = shared_from_this(), last](beast::error_code _ec) {
+						self->on_written(_ec, std::nullopt, last);
+					},
+					// The writer is owned by the session, which this pipeline holds on to. The buffers
+					// stay allocated even if the pipeline is gone by the time the kernel releases them.
+					[weak = weak_from_this(), storage = storage_, index] {
+						if (const auto self = weak.lock(); self) {
+							self->release(index);
+						}
+					});
+				return;
+			}
+
+			auto& response = data_->response;
+			response.body().data = buffer;
+			response.body().size = count;
+			response.body().more = !last;
+
+			session_ptr_->stream().expires_after(session_ptr_->timeout());
+			beast::http::async_write(
+				session_ptr_->stream(),
+				data_->serializer,
+				[self = shared_from_this(), index, count, last](beast::error_code _ec, std::size_t) {
+					if (_ec == beast::http::error::need_buffer) {
+						_ec = {};
+					}
+
+					if (!_ec) {
+						irods::s3::zerocopy::record_bytes_sent(count, false);
+					}
+
+					self->on_written(_ec, index, last);
+				});
+		}
+
+		// Continues with the next buffer once a write has completed. _index is the buffer written if
+		// it can be reused right away.
+		auto on_written(beast::error_code _ec, std::optional<std::size_t> _index, bool _last) -> void
+		{
+			bool start_reader = false;
+
+			{
+				std::lock_guard lk{mutex_};
+
+				if (_ec) {
+					// An error occurred writing the body data. We have already sent
+					// the response in the header. All we can do is bail.
+					logging::error(
+						"{}: Error {} occurred while sending socket data. Bailing...", __func__, _ec.message());
+					failed_ = true;
+					writer_idle_ = true;
+
+					// Wake an idle reader so that it closes the data object.
+					start_reader = std::exchange(reader_idle_, false);
+				}
+				else if (_last) {
+					logging::debug("{}: returned [{}]", __func__, data_->response.reason());
+					writer_idle_ = true;
+					irods::http::globals::background_task([data = data_] { data->keep_handle(); });
+					return;
+				}
+				else {
+					if (_index) {
+						free_.push_back(*_index);
+					}
+					start_reader = reader_idle_ && read_offset_ <= range_end_;
+					if (start_reader) {
+						reader_idle_ = false;
+					}
+				}
+			}
+
+			if (start_reader) {
+				schedule_read();
+			}
+
+			if (_ec) {
+				return;
+			}
+
+			write();
+		}
+
+		// Returns a buffer sent with MSG_ZEROCOPY to the free buffers once the kernel has released it.
+		auto release(std::size_t _index) -> void
+		{
+			bool start_reader = false;
+
+			{
+				std::lock_guard lk{mutex_};
+				free_.push_back(_index);
+				start_reader = !failed_ && reader_idle_ && read_offset_ <= range_end_;
+				if (start_reader) {
+					reader_idle_ = false;
+				}
+			}
+
+			if (start_reader) {
+				schedule_read();
+			}
+		}
+
+		irods::http::session_pointer_type session_ptr_;
+		std::shared_ptr<persistent_data> data_;
+		std::size_t read_offset_;
+		std::size_t range_end_;
+		std::uint64_t read_ahead_;
+		irods::s3::transfer_buffer_sizer sizer_;
+
+		// Set when the body is sent with MSG_ZEROCOPY.
+		std::shared_ptr<irods::s3::zerocopy_writer> zerocopy_;
+
+		std::mutex mutex_;
+
+		// The kernel may still send from a buffer written with MSG_ZEROCOPY after the pipeline is gone,
+		// so the buffers are kept apart from it.
+		std::shared_ptr<std::vector<std::vector<char>>> storage_{std::make_shared<std::vector<std::vector<char>>>()};
+		std::vector<std::vector<char>>& buffers_{*storage_};
+		std::uint64_t allocated_ = 0;
+		std::deque<std::size_t> spare_;
+		std::deque<std::size_t> free_;
+		std::deque<std::pair<std::size_t, std::size_t>> filled_;
+		bool reader_idle_ = true;
+		bool writer_idle_ = true;
+		bool failed_ = false;
+
+		// Reads are scheduled from socket completion handlers, which do not carry the request's profile.
+		std::shared_ptr<irods::s3::rpc_profiler::request_profile> profile_{irods::s3::rpc_profiler::current()};
+	};
+
+	class shared_read;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::mutex g_shared_reads_mutex;
+
+	// The shared reads which can still be joined, keyed by object version.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::unordered_map<std::string, std::weak_ptr<shared_read>> g_shared_reads;
+
+	// The bytes reserved by all shared reads which still exist.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::uint64_t g_shared_read_bytes = 0;
+
+	// The number of requests reading the whole of an object version on their own, keyed like
+	// g_shared_reads.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::unordered_map<std::string, std::size_t> g_solo_reads;
+
+	// Counts a request in g_solo_reads for as long as it exists.
+	class solo_read
+	{
+	  public:
+		// Must be called with g_shared_reads_mutex held.
+		explicit solo_read(std::string _key)
+			: key_{std::move(_key)}
+		{
+			++g_solo_reads[key_];
+		}
+
+		~solo_read()
+		{
+			std::lock_guard lk{g_shared_reads_mutex};
+			if (const auto iter = g_solo_reads.find(key_); iter != std::end(g_solo_reads) && --iter->second == 0) {
+				g_solo_reads.erase(iter);
+			}
+		}
+
+		solo_read(const solo_read&) = delete;
+		auto operator=(const solo_read&) -> solo_read& = delete;
+
+	  private:
+		std::string key_;
+	};
+
+	// A read of a whole data object which every GetObject of the same version joins while the read
+	// is in progress, instead of opening the data object itself.
+	//
+	// A shared read is only started by a request which finds the same version already being read,
+	// so a request without company reads through the pipeline like any other. The reader stays up
+	// to the read-ahead ahead of the fastest client and never waits for slower ones. A chunk is
+	// dropped once every client has moved past it, and clients only join while no chunk has been
+	// dropped. The size of the object is reserved against
+	// irods_client.get_object_coalescing.budget_in_bytes for the lifetime of the read, which bounds
+	// the memory held by all shared reads.
+	class shared_read : public std::enable_shared_from_this<shared_read>
+	{
+	  public:
+		using chunk = std::shared_ptr<const std::vector<char>>;
+
+		// Called with the requested chunk, or nullptr if the read failed.
+		using chunk_handler = std::function<void(chunk)>;
+
+		struct join_result
+		{
+			// The read to send from, or nullptr if the caller reads the object on its own.
+			std::shared_ptr<shared_read> read;
+
+			// The caller's client in read. The caller detaches it once it is done.
+			std::size_t client = 0;
+
+			// True if read was started by this call, in which case the caller opens the data object
+			// and calls start() or fail().
+			bool started = false;
+
+			// Set if the caller reads the object on its own. It is kept for as long as the read.
+			std::unique_ptr<solo_read> solo;
+		};
+
+		// Joins the read in progress for _key, or starts a new one if the version is already being
+		// read and the budget allows.
+		static auto join(const std::string& _key, std::uint64_t _size) -> join_result
+		{
+			// Outlives the lock, since destroying the last reference to a read takes the lock.
+			std::shared_ptr<shared_read> read;
+
+			std::lock_guard lk{g_shared_reads_mutex};
+			join_result result;
+
+			bool in_progress = g_solo_reads.contains(_key);
+
+			if (const auto iter = g_shared_reads.find(_key); iter != std::end(g_shared_reads)) {
+				read = iter->second.lock();
+				if (read) {
+					if (const auto client = read->attach(); client) {
+						result.read = std::move(read);
+						result.client = *client;
+						return result;
+					}
+
+					// The read has dropped chunks a new client would need.
+					in_progress = true;
+				}
+				g_shared_reads.erase(iter);
+			}
+
+			if (!in_progress || g_shared_read_bytes + _size > irods::s3::get_get_object_coalescing_budget_in_bytes()) {
+				result.solo = std::make_unique<solo_read>(_key);
+				return result;
+			}
+
+			g_shared_read_bytes += _size;
+			result.read = std::make_shared<shared_read>(_key, _size);
+			result.client = *result.read->attach();
+			result.started = true;
+			g_shared_reads.emplace(_key, result.read);
+			return result;
+		}
+
+		shared_read(std::string _key, std::uint64_t _size)
+			: key_{std::move(_key)}
+			, size_{_size}
+			, read_ahead_{irods::s3::get_get_object_read_ahead_in_bytes()}
+			, sizer_{irods::s3::get_get_object_buffer_size_in_bytes(), _size}
+		{
+		}
+
+		~shared_read()
+		{
+			std::lock_guard lk{g_shared_reads_mutex};
+			g_shared_read_bytes -= size_;
+
+			// A newer read of the same object may have taken the entry.
+			if (const auto iter = g_shared_reads.find(key_);
+			    iter != std::end(g_shared_reads) && iter->second.expired()) {
+				g_shared_reads.erase(iter);
+			}
+		}
+
+		shared_read(const shared_read&) = delete;
+		auto operator=(const shared_read&) -> shared_read& = delete;
+
+		auto size() const noexcept -> std::uint64_t
+		{
+			return size_;
+		}
+
+		// Starts reading from the data object opened by _source. Only the reader uses _source from
+		// now on, and closes it once the whole object has been read.
+		auto start(std::shared_ptr<persistent_data> _source) -> void
+		{
+			source_ = std::move(_source);
+
+			{
+				std::lock_guard lk{mutex_};
+				started_ = true;
+				reader_idle_ = false;
+			}
+
+			schedule_read();
+		}
+
+		// Fails the read, e.g. because the data object could not be opened.
+		auto fail() -> void
+		{
+			std::vector<std::pair<std::size_t, chunk_handler>> waiting;
+
+			{
+				std::lock_guard lk{mutex_};
+				failed_ = true;
+				waiting.swap(waiting_);
+			}
+
+			forget();
+
+			for (auto& [index, handler] : waiting) {
+				handler(nullptr);
+			}
+		}
+
+		// Removes _client, e.g. because it has sent the whole object or has gone away.
+		auto detach(std::size_t _client) -> void
+		{
+			std::lock_guard lk{mutex_};
+			positions_.erase(_client);
+			drop_consumed();
+		}
+
+		// Hands chunk _index to _handler once it has been read. If the chunk is already there,
+		// _handler runs on the calling thread. _client is done with the chunks before _index.
+		auto get(std::size_t _client, std::size_t _index, chunk_handler _handler) -> void
+		{
+			chunk c;
+			bool failed = false;
+			bool start_reader = false;
+
+			{
+				std::lock_guard lk{mutex_};
+				wanted_ = std::max(wanted_, _index);
+
+				if (const auto iter = positions_.find(_client); iter != std::end(positions_)) {
+					iter->second = _index;
+				}
+
+				if (_index < chunks_.size()) {
+					c = chunks_[_index];
+				}
+				else if (failed_) {
+					failed = true;
+				}
+				else {
+					waiting_.emplace_back(_index, std::move(_handler));
+				}
+
+				start_reader = started_ && reader_idle_ && !failed_ && read_offset_ < size_ && !ahead();
+				if (start_reader) {
+					reader_idle_ = false;
+				}
+
+				drop_consumed();
+			}
+
+			if (start_reader) {
+				schedule_read();
+			}
+
+			if (c || failed) {
+				_handler(std::move(c));
+			}
+		}
+
+	  private:
+		// Adds a client at the start of the object, unless chunks it would need have been dropped.
+		auto attach() -> std::optional<std::size_t>
+		{
+			std::lock_guard lk{mutex_};
+			if (dropped_ > 0) {
+				return std::nullopt;
+			}
+
+			const auto client = next_client_++;
+			positions_.emplace(client, 0);
+			return client;
+		}
+
+		// Drops the chunks every client has moved past. The clients hold on to the chunks they are
+		// sending. Must be called with mutex_ held.
+		auto drop_consumed() -> void
+		{
+			auto first_needed = chunks_.size();
+			for (const auto& [client, index] : positions_) {
+				first_needed = std::min(first_needed, index);
+			}
+
+			for (; dropped_ < first_needed; ++dropped_) {
+				chunks_[dropped_].reset();
+			}
+		}
+
+		// True if the reader is far enough ahead of the fastest client. Must be called with mutex_ held.
+		auto ahead() const -> bool
+		{
+			return wanted_ < chunks_.size() && read_offset_ - offsets_[wanted_] >= read_ahead_;
+		}
+
+		// Forgets the read so that later requests start a new one.
+		auto forget() -> void
+		{
+			std::lock_guard lk{g_shared_reads_mutex};
+			if (const auto iter = g_shared_reads.find(key_);
+			    iter != std::end(g_shared_reads) && iter->second.lock().get() == this) {
+				g_shared_reads.erase(iter);
+			}
+		}
+
+		auto schedule_read() -> void
+		{
+			irods::http::globals::background_task([self = shared_from_this()] { self->read(); });
+		}
+
+		// Reads the next chunk from iRODS. Runs on a background thread.
+		auto read() -> void
+		{
+			const irods::s3::rpc_profiler::scope profile{profile_};
+
+			std::uint64_t length{};
+			{
+				std::lock_guard lk{mutex_};
+				length = std::min<std::uint64_t>(sizer_.size(), size_ - read_offset_);
+			}
+
+			auto buffer = std::make_shared<std::vector<char>>(length);
+
+			const auto read_start = std::chrono::steady_clock::now();
+			const auto count = source_->read(buffer->data(), length);
+
+			// Only this thread uses the sizer.
+			sizer_.record(count, std::chrono::steady_clock::now() - read_start);
+
+			if (count == 0) {
+				// The clients have already been sent the response header. All they can do is bail.
+				logging::error("{}: Badbit set on read from iRODS. Bailing...", __func__);
+				source_.reset();
+				fail();
+				return;
+			}
+
+			buffer->resize(count);
+
+			std::vector<chunk_handler> ready;
+			bool done = false;
+			bool keep_reading = false;
+
+			{
+				std::lock_guard lk{mutex_};
+
+				offsets_.push_back(read_offset_);
+				chunks_.push_back(buffer);
+				read_offset_ += count;
+
+				const auto index = chunks_.size() - 1;
+				for (auto iter = std::begin(waiting_); iter != std::end(waiting_);) {
+					if (iter->first == index) {
+						ready.push_back(std::move(iter->second));
+						iter = waiting_.erase(iter);
+					}
+					else {
+						++iter;
+					}
+				}
+
+				done = read_offset_ == size_;
+				keep_reading = !done && !ahead();
+				reader_idle_ = !keep_reading;
+			}
+
+			if (done) {
+				forget();
+				irods::s3::rpc_profiler::timed("DATA_OBJ_CLOSE", [this] { source_->d.close(); });
+				source_.reset();
+			}
+
+			for (auto& handler : ready) {
+				handler(buffer);
+			}
+
+			if (keep_reading) {
+				schedule_read();
+			}
+		}
+
+		const std::string key_;
+		const std::uint64_t size_;
+		const std::uint64_t read_ahead_;
+		irods::s3::transfer_buffer_sizer sizer_;
+		std::shared_ptr<persistent_data> source_;
+
+		std::mutex mutex_;
+		std::vector<chunk> chunks_;
+		std::vector<std::uint64_t> offsets_;
+		std::vector<std::pair<std::size_t, chunk_handler>> waiting_;
+		std::uint64_t read_offset_ = 0;
+		std::size_t wanted_ = 0;
+		bool started_ = false;
+		bool reader_idle_ = true;
+		bool failed_ = false;
+
+		// The next chunk each client asks for, and the number of chunks dropped from the front.
+		std::unordered_map<std::size_t, std::size_t> positions_;
+		std::size_t next_client_ = 0;
+		std::size_t dropped_ = 0;
+
+		// Reads are scheduled from socket completion handlers, which do not carry the request's profile.
+		std::shared_ptr<irods::s3::rpc_profiler::request_profile> profile_{irods::s3::rpc_profiler::current()};
+	};
+
+	// Sends the bytes of a shared_read to one client. The client is detached from the read once the
+	// sender goes away, e.g. because the response header could not be sent.
+	class shared_read_sender : public std::enable_shared_from_this<shared_read_sender>
+	{
+	  public:
+		shared_read_sender(
+			irods::http::session_pointer_type _session_ptr,
+			std::shared_ptr<persistent_data> _data,
+			std::shared_ptr<shared_read> _read,
+			std::size_t _client)
+			: session_ptr_{std::move(_session_ptr)}
+			, data_{std::move(_data)}
+			, read_{std::move(_read)}
+			, client_{_client}
+		{
+		}
+
+		~shared_read_sender()
+		{
+			read_->detach(client_);
+		}
+
+		shared_read_sender(const shared_read_sender&) = delete;
+		auto operator=(const shared_read_sender&) -> shared_read_sender& = delete;
+
+		auto start() -> void
+		{
+			send(0);
+		}
+
+	  private:
+		auto send(std::size_t _index) -> void
+		{
+			read_->get(client_, _index, [self = shared_from_this(), _index](shared_read::chunk _chunk) {
+				if (!_chunk) {
+					// An error occurred on reading from iRODS. We have already sent
+					// the response in the header. All we can do is bail.
+					logging::error("{}: The shared read failed. Bailing...", __func__);
+					return;
+				}
+
+				if (self->data_->cancelled) {
+					return;
+				}
+
+				self->sent_ += _chunk->size();
+
+				auto& response = self->data_->response;
+				response.body().data = const_cast<char*>(_chunk->data());
+				response.body().size = _chunk->size();
+				response.body().more = self->sent_ < self->read_->size();
+
+				self->session_ptr_->stream().expires_after(self->session_ptr_->timeout());
+				beast::http::async_write(
+					self->session_ptr_->stream(),
+					self->data_->serializer,
+					[self, _index, _chunk](beast::error_code _ec, std::size_t) {
+						if (_ec && _ec != beast::http::error::need_buffer) {
+							// An error occurred writing the body data. We have already sent
+							// the response in the header. All we can do is bail.
+							logging::error(
+								"{}: Error {} occurred while sending socket data. Bailing...", __func__, _ec.message());
+							return;
+						}
+
+						if (self->sent_ == self->read_->size()) {
+							logging::debug("{}: returned [{}]", __func__, self->data_->response.reason());
+							return;
+						}
 
-// These are things that need to persist and will be wrapped in std::shared_ptr
-namespace
-{
-	struct persistent_data
+						self->send(_index + 1);
+					});
+			});
+		}
+
+		irods::http::session_pointer_type session_ptr_;
+		std::shared_ptr<persistent_data> data_;
+		std::shared_ptr<shared_read> read_;
+		const std::size_t client_;
+		std::uint64_t sent_ = 0;
+	};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::mutex g_checksums_in_progress_mutex;
+
+	// The data objects whose checksums are being computed.
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	std::unordered_set<std::string> g_checksums_in_progress;
+
+	// Asks iRODS to compute and store the checksum of a data object without waiting for it. Only
+	// one computation per data object is in flight at a time.
+	auto schedule_checksum(const std::string& _username, const fs::path& _path) -> void
 	{
-		persistent_data(std::shared_ptr<irods::experimental::client_connection> conn, fs::path path)
-			: conn_ptr{conn}
-			, serializer{response}
-			, xtrans{*conn}
-			, d{xtrans, path, irods::experimental::io::root_resource_name{irods::s3::get_resource()}, std::ios_base::in}
 		{
+			std::lock_guard lk{g_checksums_in_progress_mutex};
+			if (!g_checksums_in_progress.insert(_path.string()).second) {
+				return;
+			}
 		}
 
-		std::shared_ptr<irods::experimental::client_connection> conn_ptr;
-		buffer_body_response response;
-		buffer_body_serializer serializer;
-		irods_default_transport xtrans;
-		irods::experimental::io::idstream d;
+		irods::http::globals::compute_task([_username, _path] {
+			try {
+				auto conn = irods::get_connection(_username);
+
+				DataObjInp input{};
+				irods::strncpy_null_terminated(input.objPath, _path.c_str());
+
+				char* checksum = nullptr;
+				const auto ec = irods::s3::rpc_profiler::timed(
+					"DATA_OBJ_CHKSUM", [&] { return rcDataObjChksum(static_cast<RcComm*>(conn), &input, &checksum); });
+				std::free(checksum);
+				clearKeyVal(&input.condInput);
+
+				if (ec < 0) {
+					logging::error(
+						"{}: Failed to compute checksum of [{}]. error code=[{}]", __func__, _path.c_str(), ec);
+				}
+				else {
+					logging::debug("{}: Computed checksum of [{}].", __func__, _path.c_str());
+				}
+			}
+			catch (const std::exception& e) {
+				logging::error("{}: Failed to compute checksum of [{}]: {}", __func__, _path.c_str(), e.what());
+			}
+
+			std::lock_guard lk{g_checksums_in_progress_mutex};
+			g_checksums_in_progress.erase(_path.string());
+		});
+	} // schedule_checksum
+
+	// An inclusive range of bytes within a data object.
+	struct byte_range
+	{
+		std::uint64_t first;
+		std::uint64_t last;
+	};
+
+	// Parses the ranges of a "bytes=" Range header, without the "bytes=" prefix, against an
+	// object of _size bytes. Supports "first-last", "first-" and suffix ("-length") ranges.
+	//
+	// Returns the satisfiable ranges in ascending order with overlapping ranges combined, or an
+	// empty std::optional if the header is malformed. An empty list means that no range can be
+	// satisfied.
+	auto parse_byte_ranges(std::string_view _spec, std::uint64_t _size) -> std::optional<std::vector<byte_range>>
+	{
+		std::vector<std::string> specs;
+		boost::split(specs, _spec, boost::is_any_of(","));
+
+		std::vector<byte_range> ranges;
+
+		try {
+			for (auto& spec : specs) {
+				boost::trim(spec);
+
+				const auto dash = spec.find('-');
+				if (dash == std::string::npos || spec.find('-', dash + 1) != std::string::npos) {
+					return std::nullopt;
+				}
+
+				const auto first = spec.substr(0, dash);
+				const auto last = spec.substr(dash + 1);
+
+				// A suffix range selects the final bytes of the object.
+				if (first.empty()) {
+					const auto length = boost::lexical_cast<std::uint64_t>(last);
+					if (length > 0 && _size > 0) {
+						ranges.push_back({_size - std::min(length, _size), _size - 1});
+					}
+					continue;
+				}
+
+				byte_range range{boost::lexical_cast<std::uint64_t>(first), _size - 1};
+				if (!last.empty()) {
+					range.last = boost::lexical_cast<std::uint64_t>(last);
+					if (range.last < range.first) {
+						return std::nullopt;
+					}
+				}
+
+				if (range.first < _size) {
+					range.last = std::min(range.last, _size - 1);
+					ranges.push_back(range);
+				}
+			}
+		}
+		catch (const boost::bad_lexical_cast&) {
+			return std::nullopt;
+		}
+
+		// Serve the ranges in the order they are found in the object so that the data object
+		// is read with forward seeks only.
+		std::sort(std::begin(ranges), std::end(ranges), [](const auto& _l, const auto& _r) {
+			return _l.first < _r.first;
+		});
+
+		std::vector<byte_range> combined;
+		for (const auto& range : ranges) {
+			if (!combined.empty() && range.first <= combined.back().last + 1) {
+				combined.back().last = std::max(combined.back().last, range.last);
+			}
+			else {
+				combined.push_back(range);
+			}
+		}
+
+		return combined;
+	} // parse_byte_ranges
+
+	// Sends several byte ranges of a data object as a multipart/byteranges body.
+	//
+	// All ranges are read from the single stream opened by persistent_data, in ascending order.
+	// One buffer is read per background task and written asynchronously, so neither long responses
+	// nor slow clients hold a background thread.
+	class byte_ranges_sender : public std::enable_shared_from_this<byte_ranges_sender>
+	{
+	  public:
+		byte_ranges_sender(
+			irods::http::session_pointer_type _session_ptr,
+			std::shared_ptr<persistent_data> _data,
+			std::vector<byte_range> _ranges,
+			std::uint64_t _object_size,
+			std::uint64_t _buffer_size)
+			: session_ptr_{std::move(_session_ptr)}
+			, data_{std::move(_data)}
+			, ranges_{std::move(_ranges)}
+			, buffer_(_buffer_size)
+		{
+			std::mt19937_64 generator{std::random_device{}()};
+			boundary_ = fmt::format("{:016x}{:016x}", generator(), generator());
+
+			part_headers_.reserve(ranges_.size());
+			for (const auto& range : ranges_) {
+				part_headers_.push_back(fmt::format(
+					"\r\n--{}\r\nContent-Type: application/octet-stream\r\nContent-Range: bytes {}-{}/{}\r\n\r\n",
+					boundary_,
+					range.first,
+					range.last,
+					_object_size));
+			}
+
+			trailer_ = fmt::format("\r\n--{}--\r\n", boundary_);
+		}
+
+		// The value of the Content-Type header of the response.
+		auto content_type() const -> std::string
+		{
+			return fmt::format("multipart/byteranges; boundary={}", boundary_);
+		}
+
+		// The number of bytes in the body, including the part headers.
+		auto content_length() const -> std::uint64_t
+		{
+			std::uint64_t length = trailer_.size();
+			for (std::size_t i = 0; i < ranges_.size(); ++i) {
+				length += part_headers_[i].size() + ranges_[i].last - ranges_[i].first + 1;
+			}
+			return length;
+		}
+
+		auto start() -> void
+		{
+			irods::http::globals::background_task([self = shared_from_this()] { self->send_next(); });
+		}
+
+	  private:
+		// Reads the next buffer from iRODS and hands it to the socket. Runs on a background thread.
+		auto send_next() -> void
+		{
+			const irods::s3::rpc_profiler::scope profile{profile_};
+
+			if (data_->cancelled) {
+				data_->release();
+				return;
+			}
+
+			if (index_ == ranges_.size()) {
+				write(trailer_.data(), trailer_.size(), false, [self = shared_from_this()] {
+					logging::debug("{}: returned [{}]", __func__, self->data_->response.reason());
+				});
+				return;
+			}
+
+			const auto& range = ranges_[index_];
+			auto& d = data_->d;
+
+			// Objects held in memory are sent one part per task.
+			if (const auto& contents = data_->contents; contents) {
+				const auto& header = part_headers_[index_];
+				write(header.data(), header.size(), true, [self = shared_from_this(), range] {
+					const auto* data = self->data_->contents->data() + range.first;
+					self->write(data, range.last - range.first + 1, true, [self] {
+						++self->index_;
+						self->start();
+					});
+				});
+				return;
+			}
+
+			if (!part_started_) {
+				d.seekg(static_cast<std::streamoff>(range.first));
+				offset_ = range.first;
+				part_started_ = true;
+				write(part_headers_[index_].data(), part_headers_[index_].size(), true, [self = shared_from_this()] {
+					self->start();
+				});
+				return;
+			}
+
+			const auto length = std::min<std::uint64_t>(buffer_.size(), range.last + 1 - offset_);
+			irods::s3::rpc_profiler::timer timer{"DATA_OBJ_READ"};
+			d.read(buffer_.data(), static_cast<std::streamsize>(length));
+			const auto count = static_cast<std::uint64_t>(d.gcount());
+			timer.stop(d.bad() || count == 0);
+
+			if (d.bad() || count == 0) {
+				// An error occurred on reading from iRODS. We have already sent
+				// the response in the header. All we can do is bail.
+				logging::error("{}: Badbit set on read from iRODS. Bailing...", __func__);
+				data_->release();
+				return;
+			}
+
+			write(buffer_.data(), count, true, [self = shared_from_this(), count] {
+				self->offset_ += count;
+				if (self->offset_ > self->ranges_[self->index_].last) {
+					++self->index_;
+					self->part_started_ = false;
+				}
+
+				self->start();
+			});
+		}
+
+		// Sends _size bytes to the client and calls _on_sent once the socket has taken them. The
+		// write completes on an I/O thread so a slow client never holds a background thread.
+		auto write(const char* _data, std::size_t _size, bool _more, std::function<void()> _on_sent) -> void
+		{
+			auto& response = data_->response;
+			response.body().data = const_cast<char*>(_data);
+			response.body().size = _size;
+			response.body().more = _more;
+
+			session_ptr_->stream().expires_after(session_ptr_->timeout());
+			beast::http::async_write(
+				session_ptr_->stream(),
+				data_->serializer,
+				[self = shared_from_this(), on_sent = std::move(_on_sent)](beast::error_code _ec, std::size_t) {
+					if (_ec && _ec != beast::http::error::need_buffer) {
+						// An error occurred writing the body data. We have already sent
+						// the response in the header. All we can do is bail.
+						logging::error(
+							"{}: Error {} occurred while sending socket data. Bailing...", __func__, _ec.message());
+						self->data_->cancel();
+						self->start();
+						return;
+					}
+
+					const irods::s3::rpc_profiler::scope profile{self->profile_};
+					on_sent();
+				});
+		}
+
+		irods::http::session_pointer_type session_ptr_;
+		std::shared_ptr<persistent_data> data_;
+		std::vector<byte_range> ranges_;
+		std::vector<char> buffer_;
+		std::string boundary_;
+		std::vector<std::string> part_headers_;
+		std::string trailer_;
+		std::size_t index_ = 0;
+		std::uint64_t offset_ = 0;
+		bool part_started_ = false;
+
+		// Tasks are started from socket completion handlers, which do not carry the request's profile.
+		std::shared_ptr<irods::s3::rpc_profiler::request_profile> profile_{irods::s3::rpc_profiler::current()};
+	};
+
+	// Sends part of an object from a local file, i.e. the disk cache or a vault on this host, with
+	// sendfile(2).
+	//
+	// The socket is put in non-blocking mode and filled until the kernel refuses more bytes. The
+	// sender then waits for the socket to become writable again without holding any thread.
+	class local_file_sender : public std::enable_shared_from_this<local_file_sender>
+	{
+	  public:
+		local_file_sender(
+			irods::http::session_pointer_type _session_ptr,
+			std::shared_ptr<irods::s3::disk_cache::file> _file,
+			std::function<void(std::uint64_t)> _record_bytes_served,
+			std::string _path,
+			std::uint64_t _offset,
+			std::uint64_t _count)
+			: session_ptr_{std::move(_session_ptr)}
+			, file_{std::move(_file)}
+			, record_bytes_served_{std::move(_record_bytes_served)}
+			, path_{std::move(_path)}
+			, offset_{_offset}
+			, count_{_count}
+			, total_{_count}
+			, timer_{session_ptr_->stream().get_executor()}
+		{
+		}
+
+		auto start() -> void
+		{
+			beast::error_code ec;
+			session_ptr_->stream().socket().native_non_blocking(true, ec);
+			if (ec) {
+				logging::error("{}: Error {} occurred while preparing the socket.", __func__, ec.message());
+				return;
+			}
+
+			send();
+		}
+
+	  private:
+		auto send() -> void
+		{
+			auto& socket = session_ptr_->stream().socket();
+			const auto error = irods::s3::send_file(socket.native_handle(), *file_, offset_, count_);
+
+			if (error == EAGAIN) {
+				// The stream's timeout does not cover waits on the socket, so the wait has its own.
+				timer_.expires_after(session_ptr_->timeout());
+				timer_.async_wait([weak = weak_from_this()](beast::error_code _ec) {
+					if (const auto self = weak.lock(); self && !_ec) {
+						self->session_ptr_->stream().socket().cancel();
+					}
+				});
+
+				socket.async_wait(
+					boost::asio::socket_base::wait_write, [self = shared_from_this()](beast::error_code _ec) {
+						self->timer_.cancel();
+
+						if (_ec) {
+							logging::error(
+								"{}: Error {} occurred while waiting on the socket. Bailing...",
+								__func__,
+								_ec.message());
+							return;
+						}
+
+						self->send();
+					});
+				return;
+			}
+
+			if (error != 0) {
+				logging::error("{}: Error {} occurred while sending the local file.", __func__, error);
+				return;
+			}
+
+			record_bytes_served_(total_);
+			logging::debug("{}: Sent [{}] bytes of [{}] from a local file.", __func__, total_, path_);
+		}
+
+		irods::http::session_pointer_type session_ptr_;
+		std::shared_ptr<irods::s3::disk_cache::file> file_;
+		std::function<void(std::uint64_t)> record_bytes_served_;
+		std::string path_;
+		std::uint64_t offset_;
+		std::uint64_t count_;
+		std::uint64_t total_;
+		boost::asio::steady_timer timer_;
 	};
 } //namespace
 
-void read_from_irods_send_to_client(
+void read_from_irods_in_parallel_send_to_client(
 	irods::http::session_pointer_type session_ptr,
 	std::shared_ptr<persistent_data> vars,
-	std::size_t range_start,
 	std::size_t range_end,
 	std::size_t offset,
-	uint64_t write_buffer_size,
 	const std::string func);
 
 const static std::string_view date_format{"{:%a, %d %b %Y %H:%M:%S GMT}"};
@@ -85,8 +1424,6 @@ void irods::s3::actions::handle_getobject(
 	beast::http::request_parser<boost::beast::http::empty_body>& parser,
 	const boost::urls::url_view& url)
 {
-	using json_pointer = nlohmann::json::json_pointer;
-
 	beast::http::response<beast::http::empty_body> response;
 
 	auto irods_username = irods::s3::authentication::authenticates(parser, url);
@@ -111,66 +1448,59 @@ void irods::s3::actions::handle_getobject(
 		return;
 	}
 
-	const auto& config = irods::http::globals::configuration();
-	const auto& irods_client_config = config.at("irods_client");
-	const auto& zone = irods_client_config.at("zone").get_ref<const std::string&>();
-
-	const auto& rodsadmin_username =
-		irods_client_config.at(json_pointer{"/proxy_admin_account/username"}).get_ref<const std::string&>();
-	auto rodsadmin_password =
-		irods_client_config.at(json_pointer{"/proxy_admin_account/password"}).get_ref<const std::string&>();
+	// Clients downloading a listing in order find the next objects in the caches.
+	if (auto* prefetcher = irods::http::globals::prefetcher(); prefetcher) {
+		prefetcher->on_get(*irods_username, path.string());
+	}
 
-	auto conn = std::make_shared<irods::experimental::client_connection>(
-		irods::experimental::defer_authentication,
-		irods_client_config.at("host").get_ref<const std::string&>(),
-		irods_client_config.at("port").get<int>(),
-		irods::experimental::fully_qualified_username{rodsadmin_username, zone},
-		irods::experimental::fully_qualified_username{*irods_username, zone});
+	// The replica to read is chosen by irods_client.replica_selection. The other good replicas are
+	// tried if it cannot be opened.
+	std::vector<irods::s3::replica_location> replicas;
+	if (irods::s3::get_replica_selection_policy() != irods::s3::replica_selection_policy::resource) {
+		try {
+			replicas = irods::with_catalog_retry(
+				*irods_username, [&path](auto& _conn) { return irods::s3::select_replicas(_conn, path); });
+		}
+		catch (const std::exception& e) {
+			logging::warn("{}: Could not list the replicas of [{}]: {}", __func__, path.c_str(), e.what());
+		}
+	}
 
-	auto* conn_ptr = static_cast<RcComm*>(*conn);
+	// A ranged request reuses a data object left open on the same replica by an earlier ranged
+	// request of the user. The handle brings its connection and catalog information, so the lookups
+	// below are skipped.
+	std::unique_ptr<irods::s3::read_handle> handle;
+	if (auto* handles = irods::http::globals::open_handle_cache(); handles && parser.get().count("range") > 0) {
+		const auto replica_number =
+			replicas.empty() ? std::nullopt : std::optional<int>{replicas.front().replica_number};
+		handle = handles->take(*irods_username, path.string(), replica_number);
+	}
 
-	if (const auto ec = clientLoginWithPassword(conn_ptr, rodsadmin_password.data()); ec < 0) {
-		logging::error("{}: clientLoginWithPassword error: {}", __func__, ec);
+	// Open the data connection against the server holding the replica so that the bytes do not
+	// have to pass through the catalog provider.
+	std::shared_ptr<irods::experimental::client_connection> conn;
+	try {
+		conn = handle ? handle->conn : irods::s3::get_replica_connection(*irods_username, path, replicas);
+	}
+	catch (const std::exception& e) {
+		logging::error("{}: Could not connect to iRODS: {}", __func__, e.what());
 		response.result(beast::http::status::internal_server_error);
 		session_ptr->send(std::move(response));
 		return;
 	}
 
 	std::shared_ptr<persistent_data> persistent_data_ptr = std::make_shared<persistent_data>(conn, path);
+	persistent_data_ptr->replicas = std::move(replicas);
+	persistent_data_ptr->handle = std::move(handle);
 
 	// read the range header if it exists
-	// Note:  We are only implementing range headers in the format range: bytes=<start>-[end]
-	std::size_t range_start = 0;
-	std::size_t range_end = 0;
+	// Note:  Only byte ranges are supported (range: bytes=<start>-[end], bytes=-<length>, or a
+	// comma-separated list of these). They are parsed once the size of the object is known.
+	std::optional<std::string> range_spec;
 	auto range_header = parser.get().find("range");
 	if (range_header != parser.get().end()) {
 		if (range_header->value().starts_with("bytes=")) {
-			std::string range = range_header->value().substr(6);
-
-			std::vector<std::string> range_parts;
-			boost::split(range_parts, range, boost::is_any_of("-"));
-
-			if (range_parts.size() != 2) {
-				logging::error("{}: The provided range format has not been implemented.", __FUNCTION__);
-				response.result(beast::http::status::not_implemented);
-				logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
-				session_ptr->send(std::move(response));
-				return;
-			}
-
-			try {
-				range_start = boost::lexical_cast<std::size_t>(range_parts[0]);
-				if (!range_parts[1].empty()) {
-					range_end = boost::lexical_cast<std::size_t>(range_parts[1]);
-				}
-			}
-			catch (const boost::bad_lexical_cast&) {
-				logging::error("{}: Could not cast the start or end range to a size_t.", __FUNCTION__);
-				response.result(beast::http::status::not_implemented);
-				logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
-				session_ptr->send(std::move(response));
-				return;
-			}
+			range_spec = range_header->value().substr(6);
 		}
 		else {
 			logging::error(
@@ -184,38 +1514,324 @@ void irods::s3::actions::handle_getobject(
 	}
 
 	try {
-		if (fs::client::exists(*(persistent_data_ptr->conn_ptr), path)) {
+		// Everything needed to answer the request is fetched from the catalog in one query. A reused
+		// handle carries the answer to the query made before it was opened.
+		const auto looked_up = std::chrono::steady_clock::now();
+		auto stat = persistent_data_ptr->handle
+		                ? std::optional{persistent_data_ptr->handle->stat}
+		                : irods::s3::stat_object(*(persistent_data_ptr->conn_ptr), path, *irods_username);
+		if (stat) {
 			uint64_t write_buffer_size = irods::s3::get_get_object_buffer_size_in_bytes();
 
-			auto file_size =
-				irods::experimental::filesystem::client::data_object_size(*(persistent_data_ptr->conn_ptr), path);
-			if (range_end == 0 || range_end > file_size - 1) {
-				range_end = file_size - 1;
+			auto file_size = stat->size;
+
+			// Set the Last-Mofified header
+			std::time_t last_write_time__time_t = stat->mtime;
+			std::string last_write_time__str =
+				irods::s3::api::common_routines::convert_time_t_to_str(last_write_time__time_t, date_format);
+			persistent_data_ptr->response.insert(beast::http::field::last_modified, last_write_time__str);
+
+			const auto etag = irods::s3::make_etag(path, file_size, last_write_time__time_t, stat->checksum);
+			persistent_data_ptr->response.set(beast::http::field::etag, etag);
+
+			// Conditional requests are answered before the data object is opened.
+			switch (irods::s3::evaluate_preconditions(parser.get(), etag, last_write_time__time_t)) {
+				case irods::s3::precondition_result::not_modified:
+					response.result(beast::http::status::not_modified);
+					response.set(beast::http::field::etag, etag);
+					response.set(beast::http::field::last_modified, last_write_time__str);
+					logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+					session_ptr->send(std::move(response));
+					return;
+
+				case irods::s3::precondition_result::precondition_failed:
+					return irods::s3::api::common_routines::send_error_response(
+						session_ptr,
+						beast::http::status::precondition_failed,
+						"PreconditionFailed",
+						"At least one of the preconditions you specified did not hold",
+						url.path(),
+						__FUNCTION__);
+
+				case irods::s3::precondition_result::proceed:
+					break;
+			}
+
+			// Archived objects are only read once RestoreObject has staged them. Reading from the
+			// archive could hold this thread and the client for longer than any timeout.
+			if (irods::s3::needs_restore(*stat)) {
+				return irods::s3::api::common_routines::send_error_response(
+					session_ptr,
+					beast::http::status::forbidden,
+					"InvalidObjectState",
+					"The operation is not valid for the object's storage class",
+					url.path(),
+					__FUNCTION__);
+			}
+
+			// A stale If-Range means the client's partial copy is out of date, so the whole object
+			// is sent instead of the requested ranges.
+			if (range_spec && !irods::s3::range_is_current(parser.get(), etag, last_write_time__time_t)) {
+				logging::debug("{}: If-Range does not match [{}]. Sending the whole object.", __FUNCTION__, etag);
+				range_spec.reset();
+			}
+
+			std::size_t range_start = 0;
+			std::size_t range_end = file_size - 1;
+
+			std::vector<byte_range> ranges;
+			if (range_spec) {
+				auto parsed = parse_byte_ranges(*range_spec, file_size);
+
+				if (!parsed) {
+					logging::error("{}: The provided range format has not been implemented.", __FUNCTION__);
+					response.result(beast::http::status::not_implemented);
+					logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+					session_ptr->send(std::move(response));
+					return;
+				}
+
+				if (parsed->empty()) {
+					response.result(beast::http::status::range_not_satisfiable);
+					response.set(beast::http::field::content_range, fmt::format("bytes */{}", file_size));
+					logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+					session_ptr->send(std::move(response));
+					return;
+				}
+
+				ranges = std::move(*parsed);
+				range_start = ranges.front().first;
+				range_end = ranges.front().last;
+
+				persistent_data_ptr->response.result(beast::http::status::partial_content);
+				if (ranges.size() == 1) {
+					persistent_data_ptr->response.set(
+						beast::http::field::content_range,
+						fmt::format("bytes {}-{}/{}", range_start, range_end, file_size));
+				}
 			}
 			auto content_length = range_end - range_start + 1; // ranges are inclusive
 
+			// Several ranges are sent as one multipart/byteranges body read from a single stream.
+			std::shared_ptr<byte_ranges_sender> multi_range_sender;
+			if (ranges.size() > 1) {
+				multi_range_sender = std::make_shared<byte_ranges_sender>(
+					session_ptr, persistent_data_ptr, std::move(ranges), file_size, write_buffer_size);
+				content_length = multi_range_sender->content_length();
+				persistent_data_ptr->response.set(beast::http::field::content_type, multi_range_sender->content_type());
+			}
+
 			// Set the Content-Length header
 			std::string length_field = std::to_string(content_length);
 			persistent_data_ptr->response.insert(beast::http::field::content_length, length_field);
 
-			// Get the file MD5 and set the Content-MD5 header
-			auto md5 =
-				irods::experimental::filesystem::client::data_object_checksum(*(persistent_data_ptr->conn_ptr), path);
-			persistent_data_ptr->response.insert("Content-MD5", md5);
+			// Set the Content-MD5 header from the catalog checksum. The checksum is never computed
+			// here since that would require reading the whole replica before sending the first byte.
+			const auto checksum_policy = irods::s3::get_get_object_checksum_policy();
+			if (checksum_policy != irods::s3::checksum_policy::none) {
+				if (!stat->checksum.empty()) {
+					persistent_data_ptr->response.insert("Content-MD5", stat->checksum);
+				}
+				else if (checksum_policy == irods::s3::checksum_policy::compute_async) {
+					schedule_checksum(*irods_username, path);
+				}
+			}
 
-			// Get the last write time and set the Last-Mofified header
-			auto last_write_time__time_point =
-				irods::experimental::filesystem::client::last_write_time(*(persistent_data_ptr->conn_ptr), path);
-			std::time_t last_write_time__time_t = std::chrono::system_clock::to_time_t(last_write_time__time_point);
-			std::string last_write_time__str =
-				irods::s3::api::common_routines::convert_time_t_to_str(last_write_time__time_t, date_format);
-			persistent_data_ptr->response.insert(beast::http::field::last_modified, last_write_time__str);
+			// Small objects are served from the object cache. On a miss, a request for the whole object
+			// offers what it reads to the cache. A ranged request never reads more than it asked for
+			// before its first byte is sent, so it leaves the cache alone.
+			//
+			// The cache holds bytes read on behalf of other users, so it only serves users who may read
+			// the object according to the catalog. Anyone else is left to iRODS to turn away.
+			auto* cache = irods::http::globals::object_cache();
+			const bool cacheable = cache && file_size > 0 && file_size <= cache->max_object_size_in_bytes();
+			const irods::s3::object_cache::version version{file_size, stat->mtime, stat->checksum};
+			if (cacheable && stat->accessible) {
+				persistent_data_ptr->contents = cache->find(path.string(), version);
+				if (persistent_data_ptr->contents) {
+					logging::debug("{}: Serving [{}] from the object cache.", __FUNCTION__, path.c_str());
+					cache->record_bytes_saved(content_length);
+				}
+			}
+
+			// Objects of a few KiB are read whole with a single call instead of opening, reading and
+			// closing a stream. Ranges are cut from the whole object since that costs no extra call.
+			if (!persistent_data_ptr->contents && file_size > 0 &&
+			    file_size <= irods::s3::get_get_object_small_object_threshold_in_bytes())
+			{
+				const auto& replicas = persistent_data_ptr->replicas;
+				auto contents = irods::s3::read_small_object(
+					static_cast<RcComm&>(*persistent_data_ptr->conn_ptr),
+					path,
+					file_size,
+					replicas.empty() ? std::nullopt : std::optional<int>{replicas.front().replica_number});
+
+				if (contents) {
+					if (cacheable) {
+						cache->insert(path.string(), version, contents);
+					}
+					persistent_data_ptr->contents = std::move(contents);
+				}
+			}
+
+			// A reused handle is kept for the next ranged request, so its connection never reads the
+			// whole object.
+			//
+			// If the object cannot be opened or read whole, it is streamed as if the cache had not been
+			// tried. The stream must then be left clear and at the first byte.
+			if (cacheable && !persistent_data_ptr->contents && ranges.empty() && !persistent_data_ptr->handle) {
+				auto& d = persistent_data_ptr->d;
+				persistent_data_ptr->open();
 
-			// seek to the start range
-			persistent_data_ptr->d.seekg(range_start);
+				if (d.is_open()) {
+					auto contents = std::make_shared<std::vector<char>>(file_size);
+					irods::s3::rpc_profiler::timer timer{"DATA_OBJ_READ"};
+					d.read(contents->data(), static_cast<std::streamsize>(file_size));
+					const auto count = static_cast<std::uint64_t>(d.gcount());
+					timer.stop(count != file_size);
+
+					if (count == file_size) {
+						cache->insert(path.string(), version, contents);
+						persistent_data_ptr->contents = std::move(contents);
+					}
+					else {
+						logging::debug(
+							"{}: Read [{}] of [{}] bytes of [{}]. Not caching it.",
+							__FUNCTION__,
+							count,
+							file_size,
+							path.c_str());
+						d.clear();
+						d.seekg(0);
+					}
+				}
+				else {
+					d.clear();
+				}
+			}
+
+			// Objects with a good replica in the vault of a unixfilesystem resource on this host are sent
+			// straight from the vault with sendfile. The catalog has vouched for the user's permissions
+			// by the time the vault is looked up.
+			std::shared_ptr<irods::s3::disk_cache::file> vault_file;
+			if (irods::s3::get_direct_vault_reads_enabled() && !persistent_data_ptr->contents && !multi_range_sender &&
+			    stat->accessible && file_size > 0)
+			{
+				auto f = irods::s3::vault_reads::open(
+					static_cast<RcComm&>(*persistent_data_ptr->conn_ptr), path, file_size);
+				if (f) {
+					logging::debug("{}: Serving [{}] from a local vault.", __FUNCTION__, path.c_str());
+					vault_file = std::make_shared<irods::s3::disk_cache::file>(std::move(*f));
+				}
+			}
+
+			// Large objects are sent from the disk cache with sendfile. On a miss, the object is
+			// copied to disk in the background while this request is served from iRODS. Like the object
+			// cache, the disk cache only serves users who may read the object.
+			std::shared_ptr<irods::s3::disk_cache::file> cached_file;
+			auto* disk_cache = irods::http::globals::disk_cache();
+			if (disk_cache && stat->accessible && !persistent_data_ptr->contents && !vault_file &&
+			    !multi_range_sender && disk_cache->accepts(file_size))
+			{
+				const irods::s3::disk_cache::version version{file_size, stat->mtime, stat->checksum};
+
+				if (auto f = disk_cache->open(path.string(), version); f) {
+					logging::debug("{}: Serving [{}] from the disk cache.", __FUNCTION__, path.c_str());
+					cached_file = std::make_shared<irods::s3::disk_cache::file>(std::move(*f));
+				}
+				else {
+					disk_cache->fill_async(*irods_username, path, version);
+				}
+			}
+
+			// Concurrent requests for the whole object share a single read from iRODS. Only users who
+			// may read the object according to the catalog join a read, since joining skips opening the
+			// object.
+			std::shared_ptr<shared_read_sender> shared;
+			if (irods::s3::get_get_object_coalescing_enabled() && !persistent_data_ptr->contents && !vault_file &&
+			    !cached_file && ranges.empty() && stat->accessible && file_size > 0 &&
+			    file_size <= irods::s3::get_get_object_coalescing_max_object_size_in_bytes())
+			{
+				const auto key = fmt::format("{}\n{}\n{}\n{}", path.string(), file_size, stat->mtime, stat->checksum);
+
+				auto joined = shared_read::join(key, file_size);
+				persistent_data_ptr->solo = std::move(joined.solo);
+
+				if (joined.read) {
+					shared = std::make_shared<shared_read_sender>(
+						session_ptr, persistent_data_ptr, joined.read, joined.client);
+				}
+
+				if (joined.started) {
+					persistent_data_ptr->open();
+					if (persistent_data_ptr->d.is_open() && !persistent_data_ptr->d.fail()) {
+						joined.read->start(persistent_data_ptr);
+					}
+					else {
+						joined.read->fail();
+						shared.reset();
+					}
+				}
+				else if (joined.read) {
+					logging::debug("{}: Joining the read of [{}] in progress.", __FUNCTION__, path.c_str());
+				}
+			}
+
+			// Large objects are read over several iRODS data streams, optionally from different
+			// replicas. Each stream reads its own stripes and the stripes are sent to the client in order.
+			const auto stream_count = irods::s3::get_parallel_transfer_stream_count();
+			const bool served_locally = persistent_data_ptr->contents || vault_file || cached_file || shared;
+			if (!served_locally && !multi_range_sender && stream_count > 1 &&
+			    content_length >= irods::s3::get_parallel_transfer_threshold_in_bytes()) {
+				logging::debug(
+					"{}: Reading [{}] bytes from [{}] over [{}] streams.",
+					__FUNCTION__,
+					content_length,
+					path.c_str(),
+					stream_count);
+				const auto spread = irods::s3::get_parallel_transfer_spread_reads_across_replicas();
+				persistent_data_ptr->reader =
+					std::make_shared<irods::s3::parallel_reader>(*irods_username, path, stream_count, spread);
+			}
+			else if (!served_locally) {
+				auto& data = *persistent_data_ptr;
+
+				// A single range is read through a handle which is kept open for the next ranged
+				// request. Anything else is read through a stream of its own.
+				if (multi_range_sender || ranges.empty()) {
+					data.handle.reset();
+				}
+
+				const bool reused = data.handle != nullptr;
+				if (!reused && !ranges.empty() && !data.d.is_open() && irods::http::globals::open_handle_cache()) {
+					data.handle = std::make_unique<irods::s3::read_handle>(
+						data.conn_ptr, *irods_username, path, *stat, looked_up);
+					data.open(data.handle->transport, data.handle->in);
+					data.handle->replica_number = data.opened_replica_number;
+				}
+				else if (!data.handle && !data.d.is_open()) {
+					data.open();
+				}
+
+				// seek to the start range
+				data.stream().seekg(range_start);
+
+				// A slow replica is raced against another good replica if the first bytes take too long.
+				// A reused handle has already shown how quickly its replica answers.
+				if (!multi_range_sender && !reused) {
+					const std::string bucket_name = *url.segments().begin();
+					if (const auto delay = irods::s3::hedged_reads::delay_for(bucket_name); delay) {
+						persistent_data_ptr->hedge =
+							std::make_unique<irods::s3::hedged_read>(*irods_username, path, range_start, *delay);
+					}
+				}
+			}
 			size_t offset = range_start;
 
-			if (persistent_data_ptr->d.fail() || persistent_data_ptr->d.bad()) {
+			if (!served_locally &&
+			    (persistent_data_ptr->reader ? !persistent_data_ptr->reader->is_open()
+			                                 : persistent_data_ptr->stream().fail()))
+			{
 				logging::error("{}: Fail/badbit set", __FUNCTION__);
 				persistent_data_ptr->response.result(beast::http::status::forbidden);
 				persistent_data_ptr->response.body().more = false;
@@ -223,20 +1839,116 @@ void irods::s3::actions::handle_getobject(
 				session_ptr->send(std::move(persistent_data_ptr->response));
 				return;
 			}
-			beast::error_code ec;
-			beast::http::write_header(session_ptr->stream().socket(), persistent_data_ptr->serializer, ec);
-			if (ec) {
-				persistent_data_ptr->response.result(beast::http::status::internal_server_error);
-				logging::debug("{}: returned [{}]", __FUNCTION__, persistent_data_ptr->response.reason());
-				session_ptr->send(std::move(persistent_data_ptr->response));
+			// The header and the body are written asynchronously so that a slow client never holds
+			// a background thread. Only the reads from iRODS run on background threads.
+			// Reads from iRODS stop as soon as the client goes away, not on the next write.
+			session_ptr->watch_for_disconnect([data = std::weak_ptr{persistent_data_ptr}] {
+				if (const auto p = data.lock(); p) {
+					p->cancel();
+				}
+			});
+
+			// Objects held in memory go out in one gathered write of the header and the body.
+			if (const auto& contents = persistent_data_ptr->contents; contents && !multi_range_sender) {
+				auto& body = persistent_data_ptr->response.body();
+				body.data = const_cast<char*>(contents->data() + offset);
+				body.size = content_length;
+				body.more = false;
+
+				session_ptr->stream().expires_after(session_ptr->timeout());
+				beast::http::async_write(
+					session_ptr->stream(),
+					persistent_data_ptr->serializer,
+					[persistent_data_ptr, fn = __FUNCTION__](beast::error_code _ec, std::size_t) {
+						if (_ec && _ec != beast::http::error::need_buffer) {
+							logging::error("{}: Error {} occurred while sending socket data.", fn, _ec.message());
+							return;
+						}
+
+						logging::debug("{}: returned [{}]", fn, persistent_data_ptr->response.reason());
+					});
 				return;
 			}
 
-			// set the response to ok
-			persistent_data_ptr->response.result(beast::http::status::ok);
+			session_ptr->stream().expires_after(session_ptr->timeout());
+			beast::http::async_write_header(
+				session_ptr->stream(),
+				persistent_data_ptr->serializer,
+				[session_ptr,
+			     persistent_data_ptr,
+			     multi_range_sender,
+			     shared,
+			     vault_file,
+			     cached_file,
+			     disk_cache,
+			     path,
+			     offset,
+			     range_end,
+			     content_length,
+			     write_buffer_size,
+			     profile = irods::s3::rpc_profiler::current(),
+			     fn = __FUNCTION__](beast::error_code _ec, std::size_t) {
+					if (_ec) {
+						logging::error("{}: Error {} occurred while sending the response header.", fn, _ec.message());
 
-			read_from_irods_send_to_client(
-				session_ptr, persistent_data_ptr, range_start, range_end, offset, write_buffer_size, __FUNCTION__);
+						// A shared read keeps reading for the other clients.
+						if (!shared) {
+							irods::http::globals::background_task(
+								[persistent_data_ptr] { persistent_data_ptr->release(); });
+						}
+						return;
+					}
+
+					const irods::s3::rpc_profiler::scope scope{profile};
+
+					if (multi_range_sender) {
+						multi_range_sender->start();
+						return;
+					}
+
+					if (shared) {
+						shared->start();
+						return;
+					}
+
+					if (vault_file) {
+						std::make_shared<local_file_sender>(
+							session_ptr,
+							vault_file,
+							irods::s3::vault_reads::record_bytes_served,
+							path.string(),
+							offset,
+							content_length)
+							->start();
+						return;
+					}
+
+					if (cached_file) {
+						const auto record_bytes_served = [disk_cache](std::uint64_t _bytes) {
+							disk_cache->record_bytes_served(_bytes);
+						};
+						std::make_shared<local_file_sender>(
+							session_ptr, cached_file, record_bytes_served, path.string(), offset, content_length)
+							->start();
+						return;
+					}
+
+					if (persistent_data_ptr->reader) {
+						// Note that ranges are inclusive which is why the +1 exists.
+						persistent_data_ptr->reader->start(
+							offset,
+							range_end + 1 - offset,
+							irods::s3::get_parallel_transfer_block_size_in_bytes(),
+							irods::s3::get_parallel_transfer_max_buffered_blocks());
+						read_from_irods_in_parallel_send_to_client(
+							session_ptr, persistent_data_ptr, range_end, offset, fn);
+						return;
+					}
+
+					std::make_shared<read_pipeline>(
+						session_ptr, persistent_data_ptr, offset, range_end, write_buffer_size)
+						->start();
+				});
 		}
 		else {
 			return irods::s3::api::common_routines::send_error_response(
@@ -280,65 +1992,63 @@ void irods::s3::actions::handle_getobject(
 	// all paths should have a return here
 }
 
-void read_from_irods_send_to_client(
+void read_from_irods_in_parallel_send_to_client(
 	irods::http::session_pointer_type session_ptr,
 	std::shared_ptr<persistent_data> persistent_data_ptr,
-	std::size_t range_start,
 	std::size_t range_end,
 	std::size_t offset,
-	uint64_t write_buffer_size,
 	const std::string func)
 {
-	irods::http::globals::background_task(
-		[session_ptr, persistent_data_ptr, range_start, range_end, offset, write_buffer_size, func]() mutable {
-			std::vector<char> buf_vector(write_buffer_size);
-
-			std::streampos current, size;
-
-			// Determine the length we need to read which is the smaller
-		    // of the write_buffer_size or the bytes to the end of the range.
-		    // Note that ranges are inclusive which is why the +1's exist.
-			std::size_t read_length =
-				write_buffer_size < range_end + 1 - offset ? write_buffer_size : range_end + 1 - offset;
-
-			// read from iRODS
-			persistent_data_ptr->d.read(buf_vector.data(), read_length);
-			current = persistent_data_ptr->d.gcount();
-			offset += current;
-			size += current;
-			persistent_data_ptr->response.body().data = buf_vector.data();
-			persistent_data_ptr->response.body().size = current;
-			if (persistent_data_ptr->d.bad()) {
-				// An error occurred on reading from iRODS. We have already sent
-			    // the response in the header. All we can do is bail.
-				logging::error("{}: Badbit set on read from iRODS. Bailing...", func);
-				return;
-			}
+	// Waiting for a stripe happens on a background thread. The write completes on an I/O thread,
+	// which schedules the wait for the following stripe.
+	irods::http::globals::background_task([session_ptr, persistent_data_ptr, range_end, offset, func]() {
+		// wait for the next stripe in offset order
+		auto next = persistent_data_ptr->reader->next();
+		if (!next) {
+			// An error occurred on reading from iRODS or the transfer was cancelled. We have
+			// already sent the response in the header. All we can do is bail.
+			logging::error("{}: Failed to read from iRODS. Bailing...", func);
+			persistent_data_ptr->release();
+			return;
+		}
 
-			// write to socket
-			boost::beast::error_code ec;
-			beast::http::write(session_ptr->stream().socket(), persistent_data_ptr->serializer, ec);
-			if (ec == beast::http::error::need_buffer) {
-				ec = {};
-			}
-			else if (ec) {
-				// An error occurred writing the body data. We have already sent
-			    // the response in the header. All we can do is bail.
-				logging::error("{}: Error {} occurred while sending socket data. Bailing...", func, ec.message());
-				return;
-			}
+		// The stripe must outlive the write.
+		auto block = std::make_shared<std::vector<char>>(std::move(*next));
 
-			logging::trace("{}: Wrote {} bytes total.  offset={}", func, size, offset);
+		const auto next_offset = offset + block->size();
+		persistent_data_ptr->response.body().data = block->data();
+		persistent_data_ptr->response.body().size = block->size();
+		persistent_data_ptr->response.body().more = next_offset <= range_end;
 
-			// If we have now read beyond the range_end then we are done. Return.
-			if (offset > range_end) {
-				persistent_data_ptr->response.body().more = false;
-				logging::debug(
-					"{} returned [{}] error={}", __FUNCTION__, persistent_data_ptr->response.reason(), ec.message());
-				return;
-			}
+		session_ptr->stream().expires_after(session_ptr->timeout());
+		beast::http::async_write(
+			session_ptr->stream(),
+			persistent_data_ptr->serializer,
+			[session_ptr,
+		     persistent_data_ptr,
+		     range_end,
+		     next_offset,
+		     func,
+		     block,
+		     profile = irods::s3::rpc_profiler::current()](beast::error_code _ec, std::size_t) {
+				if (_ec && _ec != beast::http::error::need_buffer) {
+					// An error occurred writing the body data. We have already sent
+					// the response in the header. All we can do is bail.
+					logging::error("{}: Error {} occurred while sending socket data. Bailing...", func, _ec.message());
+					irods::http::globals::background_task([persistent_data_ptr] { persistent_data_ptr->release(); });
+					return;
+				}
 
-			read_from_irods_send_to_client(
-				session_ptr, persistent_data_ptr, range_start, range_end, offset, write_buffer_size, func);
-		});
+				logging::trace("{}: Wrote {} bytes.  offset={}", func, block->size(), next_offset);
+
+				// If we have now read beyond the range_end then we are done. Return.
+				if (next_offset > range_end) {
+					return;
+				}
+
+				const irods::s3::rpc_profiler::scope scope{profile};
+				read_from_irods_in_parallel_send_to_client(
+					session_ptr, persistent_data_ptr, range_end, next_offset, func);
+			});
+	});
 }
@@ -4,6 +4,7 @@
 #include "irods/private/s3_api/common_routines.hpp"
 #include "irods/private/s3_api/connection.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/session.hpp"
 
@@ -46,7 +47,7 @@ void irods::s3::actions::handle_headbucket(
 			return;
 		}
 
-		if (fs::client::exists(conn, path)) {
+		if (irods::s3::rpc_profiler::timed("OBJ_STAT", [&] { return fs::client::exists(conn, path); })) {
 			response.result(boost::beast::http::status::ok);
 			std::cout << response.result() << std::endl;
 			logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
@@ -1,9 +1,13 @@
 #include "irods/private/s3_api/s3_api.hpp"
+#include "irods/private/s3_api/archive.hpp"
 #include "irods/private/s3_api/authentication.hpp"
 #include "irods/private/s3_api/bucket.hpp"
 #include "irods/private/s3_api/common_routines.hpp"
+#include "irods/private/s3_api/conditional_request.hpp"
 #include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/globals.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
 #include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/session.hpp"
 
@@ -11,6 +15,8 @@
 
 #include <fmt/format.h>
 
+#include <optional>
+
 namespace asio = boost::asio;
 namespace beast = boost::beast;
 namespace fs = irods::experimental::filesystem;
@@ -36,8 +42,6 @@ void irods::s3::actions::handle_headobject(
 			return;
 		}
 
-		auto conn = irods::get_connection(*irods_username);
-
 		fs::path path;
 		if (auto bucket = irods::s3::resolve_bucket(url.segments()); bucket.has_value()) {
 			path = bucket.value();
@@ -50,19 +54,17 @@ void irods::s3::actions::handle_headobject(
 			session_ptr->send(std::move(response));
 			return;
 		}
-		bool can_see = false;
 
-		if (fs::client::exists(conn, path)) {
-			// Ideally in the future exists won't return true on things that you're not allowed to see,
-			// But until then, check for any mentioned permission.
-			auto all_permissions = fs::client::status(conn, path).permissions();
-			for (const auto& i : all_permissions) {
-				if (i.name == *irods_username) {
-					can_see = true;
-				}
-			}
+		// The lookup is idempotent, so it is retried on a new connection if the pooled connection
+		// turns out to be stale.
+		auto info = irods::with_catalog_retry(*irods_username, [&path, &irods_username](auto& conn) {
+			return irods::s3::stat_object(conn, path, *irods_username);
+		});
 
-			if (!can_see) {
+		if (info) {
+			// Ideally in the future the catalog won't return objects that you're not allowed to see,
+			// But until then, check for any mentioned permission.
+			if (!info->accessible) {
 				response.result(boost::beast::http::status::forbidden);
 				logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
 				session_ptr->send(std::move(response));
@@ -71,15 +73,47 @@ void irods::s3::actions::handle_headobject(
 
 			// change response body to string_body
 			response.result(boost::beast::http::status::ok);
-			std::string length_field =
-				std::to_string(irods::experimental::filesystem::client::data_object_size(conn, path));
+			std::string length_field = std::to_string(info->size);
 			response.insert(beast::http::field::content_length, length_field);
 
-			auto last_write_time__time_point = irods::experimental::filesystem::client::last_write_time(conn, path);
-			std::time_t last_write_time__time_t = std::chrono::system_clock::to_time_t(last_write_time__time_point);
+			std::time_t last_write_time__time_t = info->mtime;
 			std::string last_write_time__str =
 				irods::s3::api::common_routines::convert_time_t_to_str(last_write_time__time_t, date_format);
 			response.insert(beast::http::field::last_modified, last_write_time__str);
+
+			const auto etag = irods::s3::make_etag(path, info->size, last_write_time__time_t, info->checksum);
+			response.set(beast::http::field::etag, etag);
+
+			// Objects on an archive resource report the state of their restore. There is no
+			// expiry date since iRODS decides when a staged replica is purged.
+			if (irods::s3::is_archived(*info)) {
+				response.set("x-amz-storage-class", "GLACIER");
+
+				const auto* restores = irods::http::globals::restore_queue();
+				if (restores && restores->is_ongoing(path.string())) {
+					response.set("x-amz-restore", R"(ongoing-request="true")");
+				}
+				else if (!irods::s3::needs_restore(*info)) {
+					response.set("x-amz-restore", R"(ongoing-request="false")");
+				}
+			}
+
+			switch (irods::s3::evaluate_preconditions(parser.get(), etag, last_write_time__time_t)) {
+				case irods::s3::precondition_result::not_modified:
+					response.result(boost::beast::http::status::not_modified);
+					response.erase(beast::http::field::content_length);
+					break;
+
+				case irods::s3::precondition_result::precondition_failed:
+					// Responses to HEAD carry no body, so the status alone reports the failure.
+					response.result(boost::beast::http::status::precondition_failed);
+					response.erase(beast::http::field::content_length);
+					break;
+
+				case irods::s3::precondition_result::proceed:
+					break;
+			}
+
 			logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
 			session_ptr->send(std::move(response));
 			return;
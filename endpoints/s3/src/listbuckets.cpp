@@ -5,6 +5,7 @@
 #include "irods/private/s3_api/connection.hpp"
 #include "irods/private/s3_api/log.hpp"
 #include "irods/private/s3_api/common.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/session.hpp"
 #include "irods/private/s3_api/globals.hpp"
 
@@ -72,10 +73,13 @@ void irods::s3::actions::handle_listbuckets(
 
 		logging::debug("{}: query = {}", __FUNCTION__, query);
 
-		for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
-			found = true;
-			create_collection_epoch_time = boost::lexical_cast<std::time_t>(row[0]);
-			break;
+		{
+			const irods::s3::rpc_profiler::timer timer{"GEN_QUERY"};
+			for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
+				found = true;
+				create_collection_epoch_time = boost::lexical_cast<std::time_t>(row[0]);
+				break;
+			}
 		}
 
 		// If creation time not found, user does not have access to the collection the bucket
@@ -2,8 +2,12 @@
 #include "irods/private/s3_api/authentication.hpp"
 #include "irods/private/s3_api/bucket.hpp"
 #include "irods/private/s3_api/common_routines.hpp"
+#include "irods/private/s3_api/conditional_request.hpp"
 #include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/globals.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/prefetch.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
 #include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/session.hpp"
 
@@ -21,8 +25,12 @@
 #include <irods/query_builder.hpp>
 
 #include <iostream>
+#include <unordered_map>
 #include <unordered_set>
 #include <chrono>
+#include <cstdlib>
+#include <optional>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -32,6 +40,193 @@ namespace logging = irods::http::logging;
 
 const static std::string_view date_format{"{:%Y-%m-%dT%H:%M:%S.000Z}"};
 
+namespace
+{
+	// Adds the data objects found by _query to the listing. The query selects COLL_NAME, DATA_NAME,
+	// DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME, DATA_CHECKSUM and DATA_REPL_STATUS, so it may
+	// return a row for every replica. Like stat_object(), an object is described by a good replica
+	// if it has one, so the ETag matches the one returned by HeadObject and GetObject.
+	auto add_data_objects(
+		RcComm& _conn,
+		const std::string& _query,
+		std::size_t _base_length,
+		boost::property_tree::ptree& _document,
+		std::vector<irods::s3::listed_object>* _listed) -> void
+	{
+		std::vector<std::vector<std::string>> objects;
+		std::unordered_map<std::string, std::size_t> index_of;
+
+		{
+			const irods::s3::rpc_profiler::timer timer{"GEN_QUERY"};
+			for (auto&& row : irods::query<RcComm>(&_conn, _query)) {
+				const auto [iter, inserted] = index_of.try_emplace(row[0] + "/" + row[1], objects.size());
+				if (inserted) {
+					objects.push_back(row);
+					continue;
+				}
+
+				auto& object = objects[iter->second];
+				if (row[6] == "1" && object[6] != "1") {
+					object = row;
+				}
+				else if (row[6] == "1" && object[5].empty()) {
+					object[5] = row[5];
+				}
+			}
+		}
+
+		for (const auto& row : objects) {
+			boost::property_tree::ptree object;
+			std::string key = (row[0].size() > _base_length ? row[0].substr(_base_length) : "") + "/" + row[1];
+			if (key.starts_with("/")) {
+				key = key.substr(1);
+			}
+
+			std::optional<std::time_t> modified_epoch_time;
+			try {
+				modified_epoch_time = boost::lexical_cast<std::time_t>(row[4]);
+			}
+			catch (const boost::bad_lexical_cast&) {
+				// do nothing - don't add LastModified tag
+			}
+
+			const auto path = irods::experimental::filesystem::path{row[0]} / row[1];
+			const auto size = std::strtoull(row[3].c_str(), nullptr, 10);
+			object.put("Key", key);
+			object.put("ETag", irods::s3::make_etag(path, size, modified_epoch_time.value_or(0), row[5]));
+			object.put("Owner", row[2]);
+			object.put("Size", atoi(row[3].c_str()));
+			if (modified_epoch_time) {
+				std::string modified_time_str =
+					irods::s3::api::common_routines::convert_time_t_to_str(*modified_epoch_time, date_format);
+				object.put("LastModified", modified_time_str);
+			}
+			_document.add_child("ListBucketResult.Contents", object);
+			if (_listed) {
+				_listed->push_back({path.string(), size});
+			}
+		}
+	} // add_data_objects
+
+	// Builds the listing. Every query is idempotent, so the listing can be rebuilt on a new connection
+	// if the pooled connection turns out to be stale.
+	auto build_listing(
+		RcComm* rcComm_t_ptr,
+		const irods::experimental::filesystem::path& bucket_base,
+		const irods::experimental::filesystem::path& the_prefix,
+		const irods::experimental::filesystem::path& full_path,
+		std::size_t base_length,
+		bool delimiter_in_request,
+		std::vector<irods::s3::listed_object>* listed) -> boost::property_tree::ptree
+	{
+		using namespace boost::property_tree;
+
+		ptree document;
+		std::string query;
+
+		document.add("ListBucketResult", "");
+		document.add("ListBucketResult.Name", bucket_base.c_str());
+		document.add("ListBucketResult.Prefix", the_prefix.c_str());
+		document.add("ListBucketResult.Marker", "");
+		document.add("ListBucketResult.IsTruncated", "false");
+
+		if (delimiter_in_request) {
+			if (full_path.object_name().empty()) {
+				// Path ends in a slash, this is an exact collection match
+				// and all objects in that collection
+
+				// Get exact collections underneath this collection
+				query = fmt::format(
+					"select COLL_NAME where COLL_NAME like '{}/%' and COLL_NAME not like '{}/%/%'",
+					full_path.parent_path().c_str(),
+					full_path.parent_path().c_str());
+				logging::debug("{}: query={}", __FUNCTION__, query);
+				{
+					const irods::s3::rpc_profiler::timer timer{"GEN_QUERY"};
+					for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
+						ptree object;
+						std::string key = (row[0].size() > base_length ? row[0].substr(base_length) : "");
+						if (key.starts_with("/")) {
+							key = key.substr(1);
+						}
+						key += "/";
+						object.put("Prefix", key);
+						document.add_child("ListBucketResult.CommonPrefixes", object);
+					}
+				}
+
+				// Get the data objects within the collection
+				query = fmt::format(
+					"select COLL_NAME, DATA_NAME, DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME, DATA_CHECKSUM, "
+					"DATA_REPL_STATUS where COLL_NAME = '{}'",
+					full_path.parent_path().c_str());
+				logging::debug("{}: query={}", __FUNCTION__, query);
+				add_data_objects(*rcComm_t_ptr, query, base_length, document, listed);
+			}
+			else {
+				// Path does not end in a slash.  This is a query for collections and data objects
+				// with a trailing wildcard.
+
+				// First get collections
+				query = fmt::format(
+					"select COLL_NAME where COLL_NAME like '{}%' and COLL_NAME not like '{}%/%'",
+					full_path.c_str(),
+					full_path.c_str());
+				logging::debug("{}: query={}", __FUNCTION__, query);
+				{
+					const irods::s3::rpc_profiler::timer timer{"GEN_QUERY"};
+					for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
+						ptree object;
+						std::string key = (row[0].size() > base_length ? row[0].substr(base_length) : "");
+						if (key.starts_with("/")) {
+							key = key.substr(1);
+						}
+						key += "/";
+						object.put("Prefix", key);
+						document.add_child("ListBucketResult.CommonPrefixes", object);
+					}
+				}
+
+				// Now get data objects
+				query = fmt::format(
+					"select COLL_NAME, DATA_NAME, DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME, DATA_CHECKSUM, "
+					"DATA_REPL_STATUS where COLL_NAME = '{}' and DATA_NAME like '{}%'",
+					full_path.parent_path().c_str(),
+					full_path.object_name().c_str());
+				logging::debug("{}: query={}", __FUNCTION__, query);
+				add_data_objects(*rcComm_t_ptr, query, base_length, document, listed);
+			}
+		}
+		else {
+			// No delimiter in request.  When there is no delimiter provided, for listing purposes AWS simply searches
+			// for all objects with the given prefix.  To make this behave similarly in iRODS, we need to perform two
+			// searches:
+			//
+			// 1.  Look for objects with COLL_NAME like <prefix>%
+			// 2.  Look for objects with COLL_NAME = <parent> and DATA_NAME like <object>%
+
+			// look for objects with COLL_NAME like <prefix>%
+			query = fmt::format(
+				"select COLL_NAME, DATA_NAME, DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME, DATA_CHECKSUM, "
+				"DATA_REPL_STATUS where COLL_NAME like '{}%'",
+				full_path.c_str());
+			logging::debug("{}: query={}", __FUNCTION__, query);
+			add_data_objects(*rcComm_t_ptr, query, base_length, document, listed);
+
+			// look for objects with COLL_NAME = <parent> and DATA_NAME like <object>%
+			query = fmt::format(
+				"select COLL_NAME, DATA_NAME, DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME, DATA_CHECKSUM, "
+				"DATA_REPL_STATUS where COLL_NAME = '{}' and DATA_NAME like '{}%'",
+				full_path.parent_path().c_str(),
+				full_path.object_name().c_str());
+			logging::debug("{}: query={}", __FUNCTION__, query);
+			add_data_objects(*rcComm_t_ptr, query, base_length, document, listed);
+		}
+
+		return document;
+	} // build_listing
+} // anonymous namespace
+
 void irods::s3::actions::handle_listobjects_v2(
 	irods::http::session_pointer_type session_ptr,
 	boost::beast::http::request_parser<boost::beast::http::empty_body>& parser,
@@ -49,9 +244,6 @@ void irods::s3::actions::handle_listobjects_v2(
 		return;
 	}
 
-	auto conn = irods::get_connection(*irods_username);
-	auto rcComm_t_ptr = static_cast<RcComm*>(conn);
-
 	irods::experimental::filesystem::path bucket_base;
 	if (auto bucket = irods::s3::resolve_bucket(url.segments()); bucket.has_value()) {
 		bucket_base = bucket.value();
@@ -64,7 +256,6 @@ void irods::s3::actions::handle_listobjects_v2(
 	}
 	auto base_length = bucket_base.string().size();
 	auto resolved_path = irods::s3::finish_path(bucket_base, url.segments());
-	boost::property_tree::ptree document;
 
 	irods::experimental::filesystem::path the_prefix;
 	if (const auto prefix = url.params().find("prefix"); prefix != url.params().end()) {
@@ -81,176 +272,25 @@ void irods::s3::actions::handle_listobjects_v2(
 
 	auto full_path = resolved_path / the_prefix;
 
-	std::string query;
-
-	document.add("ListBucketResult", "");
-	document.add("ListBucketResult.Name", bucket_base.c_str());
-	document.add("ListBucketResult.Prefix", the_prefix.c_str());
-	document.add("ListBucketResult.Marker", "");
-	document.add("ListBucketResult.IsTruncated", "false");
-
-	if (delimiter_in_request) {
-		if (full_path.object_name().empty()) {
-			// Path ends in a slash, this is an exact collection match
-			// and all objects in that collection
-
-			// Get exact collections underneath this collection
-			query = fmt::format(
-				"select COLL_NAME where COLL_NAME like '{}/%' and COLL_NAME not like '{}/%/%'",
-				full_path.parent_path().c_str(),
-				full_path.parent_path().c_str());
-			logging::debug("{}: query={}", __FUNCTION__, query);
-			for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
-				ptree object;
-				std::string key = (row[0].size() > base_length ? row[0].substr(base_length) : "");
-				if (key.starts_with("/")) {
-					key = key.substr(1);
-				}
-				key += "/";
-				object.put("Prefix", key);
-				document.add_child("ListBucketResult.CommonPrefixes", object);
-			}
-
-			// Get the data objects within the collection
-			query = fmt::format(
-				"select COLL_NAME, DATA_NAME, DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME where COLL_NAME = '{}'",
-				full_path.parent_path().c_str());
-			logging::debug("{}: query={}", __FUNCTION__, query);
-			for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
-				ptree object;
-				std::string key = (row[0].size() > base_length ? row[0].substr(base_length) : "") + "/" + row[1];
-				if (key.starts_with("/")) {
-					key = key.substr(1);
-				}
-				object.put("Key", key);
-				object.put("Etag", row[0] + row[1]);
-				object.put("Owner", row[2]);
-				object.put("Size", atoi(row[3].c_str()));
-				try {
-					std::time_t modified_epoch_time = boost::lexical_cast<std::time_t>(row[4]);
-					std::string modified_time_str =
-						irods::s3::api::common_routines::convert_time_t_to_str(modified_epoch_time, date_format);
-					object.put("LastModified", modified_time_str);
-				}
-				catch (const boost::bad_lexical_cast&) {
-					// do nothing - don't add LastModified tag
-				}
-				document.add_child("ListBucketResult.Contents", object);
-			}
-		}
-		else {
-			// Path does not end in a slash.  This is a query for collections and data objects
-			// with a trailing wildcard.
+	// The listed data objects are remembered so that the ones the client downloads next can be
+	// read ahead.
+	auto* prefetcher = irods::http::globals::prefetcher();
+	std::vector<irods::s3::listed_object> listed;
 
-			// First get collections
-			query = fmt::format(
-				"select COLL_NAME where COLL_NAME like '{}%' and COLL_NAME not like '{}%/%'",
-				full_path.c_str(),
-				full_path.c_str());
-			logging::debug("{}: query={}", __FUNCTION__, query);
-			for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
-				ptree object;
-				std::string key = (row[0].size() > base_length ? row[0].substr(base_length) : "");
-				if (key.starts_with("/")) {
-					key = key.substr(1);
-				}
-				key += "/";
-				object.put("Prefix", key);
-				document.add_child("ListBucketResult.CommonPrefixes", object);
-			}
-
-			// Now get data objects
-			query = fmt::format(
-				"select COLL_NAME, DATA_NAME, DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME where COLL_NAME = '{}'"
-				" and DATA_NAME like '{}%'",
-				full_path.parent_path().c_str(),
-				full_path.object_name().c_str());
-			logging::debug("{}: query={}", __FUNCTION__, query);
-			for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
-				ptree object;
-				std::string key = (row[0].size() > base_length ? row[0].substr(base_length) : "") + "/" + row[1];
-				if (key.starts_with("/")) {
-					key = key.substr(1);
-				}
-				object.put("Key", key);
-				object.put("Etag", row[0] + row[1]);
-				object.put("Owner", row[2]);
-				object.put("Size", atoi(row[3].c_str()));
-				try {
-					std::time_t modified_epoch_time = boost::lexical_cast<std::time_t>(row[4]);
-					std::string modified_time_str =
-						irods::s3::api::common_routines::convert_time_t_to_str(modified_epoch_time, date_format);
-					object.put("LastModified", modified_time_str);
-				}
-				catch (const boost::bad_lexical_cast&) {
-					// do nothing - don't add LastModified tag
-				}
-				document.add_child("ListBucketResult.Contents", object);
-			}
-		}
-	}
-	else {
-		// No delimiter in request.  When there is no delimiter provided, for listing purposes AWS simply searches for
-		// all objects with the given prefix.  To make this behave similarly in iRODS, we need to perform two searches:
-		//
-		// 1.  Look for objects with COLL_NAME like <prefix>%
-		// 2.  Look for objects with COLL_NAME = <parent> and DATA_NAME like <object>%
-
-		// look for objects with COLL_NAME like <prefix>%
-		query = fmt::format(
-			"select COLL_NAME, DATA_NAME, DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME where COLL_NAME like '{}%'",
-			full_path.c_str());
-		logging::debug("{}: query={}", __FUNCTION__, query);
-		for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
-			ptree object;
-			std::string key = (row[0].size() > base_length ? row[0].substr(base_length) : "") + "/" + row[1];
-			if (key.starts_with("/")) {
-				key = key.substr(1);
-			}
-			object.put("Key", key);
-			object.put("Etag", row[0] + row[1]);
-			object.put("Owner", row[2]);
-			object.put("Size", atoi(row[3].c_str()));
-			try {
-				std::time_t modified_epoch_time = boost::lexical_cast<std::time_t>(row[4]);
-				std::string modified_time_str =
-					irods::s3::api::common_routines::convert_time_t_to_str(modified_epoch_time, date_format);
-				object.put("LastModified", modified_time_str);
-			}
-			catch (const boost::bad_lexical_cast&) {
-				// do nothing - don't add LastModified tag
-			}
-			document.add_child("ListBucketResult.Contents", object);
-		}
+	auto document = irods::with_catalog_retry(*irods_username, [&](auto& conn) {
+		listed.clear();
+		return build_listing(
+			static_cast<RcComm*>(conn),
+			bucket_base,
+			the_prefix,
+			full_path,
+			base_length,
+			delimiter_in_request,
+			prefetcher ? &listed : nullptr);
+	});
 
-		// look for objects with COLL_NAME = <parent> and DATA_NAME like <object>%
-		query = fmt::format(
-			"select COLL_NAME, DATA_NAME, DATA_OWNER_NAME, DATA_SIZE, DATA_MODIFY_TIME where COLL_NAME = '{}'"
-			" and DATA_NAME like '{}%'",
-			full_path.parent_path().c_str(),
-			full_path.object_name().c_str());
-		logging::debug("{}: query={}", __FUNCTION__, query);
-		for (auto&& row : irods::query<RcComm>(rcComm_t_ptr, query)) {
-			ptree object;
-			std::string key = (row[0].size() > base_length ? row[0].substr(base_length) : "") + "/" + row[1];
-			if (key.starts_with("/")) {
-				key = key.substr(1);
-			}
-			object.put("Key", key);
-			object.put("Etag", row[0] + row[1]);
-			object.put("Owner", row[2]);
-			object.put("Size", atoi(row[3].c_str()));
-			try {
-				std::time_t modified_epoch_time = boost::lexical_cast<std::time_t>(row[4]);
-				std::string modified_time_str =
-					irods::s3::api::common_routines::convert_time_t_to_str(modified_epoch_time, date_format);
-				object.put("LastModified", modified_time_str);
-			}
-			catch (const boost::bad_lexical_cast&) {
-				// do nothing - don't add LastModified tag
-			}
-			document.add_child("ListBucketResult.Contents", object);
-		}
+	if (prefetcher) {
+		prefetcher->remember_listing(*irods_username, std::move(listed));
 	}
 
 	beast::http::response<beast::http::string_body> string_body_response(std::move(response));
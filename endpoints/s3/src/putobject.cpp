@@ -2,15 +2,22 @@
 #include "irods/private/s3_api/authentication.hpp"
 #include "irods/private/s3_api/bucket.hpp"
 #include "irods/private/s3_api/common_routines.hpp"
+#include "irods/private/s3_api/conditional_request.hpp"
 #include "irods/private/s3_api/connection.hpp"
 #include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_cache.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
 #include "irods/private/s3_api/common.hpp"
 #include "irods/private/s3_api/session.hpp"
 #include "irods/private/s3_api/configuration.hpp"
 #include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/parallel_transfer.hpp"
+#include "irods/private/s3_api/rpc_profiler.hpp"
+#include "irods/private/s3_api/transfer_buffer_sizer.hpp"
 
 #include <irods/client_connection.hpp>
 #include <irods/dstream.hpp>
+#include <irods/filesystem.hpp>
 #include <irods/fully_qualified_username.hpp>
 #include <irods/transport/default_transport.hpp>
 
@@ -18,14 +25,21 @@
 
 #include <boost/beast/http/empty_body.hpp>
 #include <boost/beast/http/read.hpp>
+#include <boost/beast/http/write.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <fstream>
 #include <regex>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <utility>
 
 namespace asio = boost::asio;
 namespace beast = boost::beast;
@@ -73,6 +87,61 @@ namespace
 {
 	const std::regex upload_id_pattern("[0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12}");
 
+	// Sends "100 Continue" if the client asked for it and then calls _start_reading. The interim
+	// response is written asynchronously so that a slow client never holds a background thread.
+	auto send_continue_then_read(
+		irods::http::session_pointer_type _session_ptr,
+		bool _expect_continue,
+		std::function<void()> _start_reading) -> void
+	{
+		if (!_expect_continue) {
+			_start_reading();
+			return;
+		}
+
+		auto response = std::make_shared<beast::http::response<beast::http::empty_body>>(
+			beast::http::status::continue_, 11);
+
+		_session_ptr->stream().expires_after(_session_ptr->timeout());
+		beast::http::async_write(
+			_session_ptr->stream(),
+			*response,
+			[response, start_reading = std::move(_start_reading), fn = __func__](beast::error_code _ec, std::size_t) {
+				if (_ec) {
+					logging::error("{}: Error sending [100-continue] response: {}", fn, _ec.message());
+					return;
+				}
+
+				logging::debug("{}: Sent 100-continue", fn);
+				start_reading();
+			});
+	} // send_continue_then_read
+
+	// Sets the ETag of an object which has just been written to the one HeadObject, GetObject and
+	// ListObjects report for it.
+	auto set_etag(
+		beast::http::response<beast::http::empty_body>& _response,
+		const std::string& _username,
+		const fs::path& _path) -> void
+	{
+		try {
+			const auto stat = irods::with_catalog_retry(_username, [&_username, &_path](auto& _conn) {
+				return irods::s3::stat_object(_conn, _path, _username, irods::s3::stat_sharing::none);
+			});
+
+			if (stat) {
+				_response.set(
+					beast::http::field::etag, irods::s3::make_etag(_path, stat->size, stat->mtime, stat->checksum));
+				return;
+			}
+		}
+		catch (const std::exception& e) {
+			logging::error("{}: Could not look up [{}]: {}", __func__, _path.c_str(), e.what());
+		}
+
+		_response.erase(beast::http::field::etag);
+	} // set_etag
+
 	enum class parsing_state
 	{
 		header_begin,
@@ -85,41 +154,37 @@ namespace
 
 } //namespace
 
-void manually_parse_chunked_body_write_to_irods_in_background(
-	irods::http::session_pointer_type session_ptr,
-	beast::http::response<beast::http::empty_body>& response_,
-	std::shared_ptr<beast::http::request_parser<boost::beast::http::buffer_body>> parser,
-	uint64_t read_buffer_size,
-	std::shared_ptr<std::ofstream> ofs,
-	std::shared_ptr<irods::experimental::client_connection> conn,
-	std::shared_ptr<irods::experimental::io::client::native_transport> tp,
-	std::shared_ptr<irods::experimental::io::odstream> d,
-	bool upload_part,
-	parsing_state current_state,
-	size_t chunk_size,
-	const std::string& parsing_buffer_string,
-	bool know_part_offset,
-	bool keep_dstream_open_flag,
-	const std::string func);
-
 class incremental_async_read : public std::enable_shared_from_this<incremental_async_read>
 {
 	irods::http::session_pointer_type session_ptr_;
 	beast::http::response<beast::http::empty_body> resp_;
 	std::shared_ptr<beast::http::request_parser<boost::beast::http::buffer_body>> parser_;
 	std::string irods_path_;
+	std::string irods_username_;
+	bool object_existed_;
 	bool upload_part_flag_;
 	bool part_offset_is_known_;
 	std::size_t part_offset_;
 	std::string upload_id_;
 	std::string part_filename_;
 	std::ofstream part_file_;
+	irods::s3::transfer_buffer_sizer sizer_;
 	std::vector<char> buffer_;
+	std::chrono::steady_clock::time_point read_start_;
 	std::size_t total_bytes_read_{};
 	bool keep_dstream_open_flag;
 	std::shared_ptr<irods::experimental::client_connection> conn_;
 	std::shared_ptr<irods::experimental::io::client::default_transport> tp_;
 	std::shared_ptr<irods::experimental::io::odstream> odstream_;
+	std::shared_ptr<irods::s3::parallel_writer> writer_;
+	std::vector<char> block_;
+	std::uint64_t block_offset_{};
+	std::uint64_t block_size_{};
+	std::shared_ptr<irods::s3::rpc_profiler::request_profile> profile_{irods::s3::rpc_profiler::current()};
+
+	// Serializes the writes to iRODS with abandon(), which is also scheduled from the socket's thread.
+	std::mutex transfer_mutex_;
+	bool abandoned_ = false;
 
   public:
 	incremental_async_read(
@@ -127,24 +192,31 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 		irods::http::session_pointer_type& _session_ptr,
 		beast::http::response<beast::http::empty_body>& _response,
 		std::string _irods_path,
+		std::string _irods_username,
+		bool _object_existed,
 		bool _upload_part_flag,
 		bool _know_part_offset_flag,
 		size_t _part_offset,
 		std::string _upload_id,
 		std::string _part_filename,
-		std::shared_ptr<irods::experimental::client_connection> _conn)
+		std::shared_ptr<irods::experimental::client_connection> _conn,
+		std::shared_ptr<irods::s3::parallel_writer> _writer = nullptr)
 		: session_ptr_{_session_ptr->shared_from_this()}
 		, resp_{std::move(_response)}
 		, parser_{_parser}
 		, irods_path_{_irods_path}
+		, irods_username_{std::move(_irods_username)}
+		, object_existed_{_object_existed}
 		, upload_part_flag_{_upload_part_flag}
 		, part_offset_is_known_{_know_part_offset_flag}
 		, part_offset_{_part_offset}
 		, upload_id_{_upload_id}
 		, part_filename_{_part_filename}
-		, buffer_(irods::s3::get_put_object_buffer_size_in_bytes())
+		, sizer_{irods::s3::get_put_object_buffer_size_in_bytes(), _parser->content_length().value_or(0)}
+		, buffer_(sizer_.size())
 		, keep_dstream_open_flag{false}
 		, conn_{_conn}
+		, writer_{std::move(_writer)}
 	{
 		namespace part_shmem = irods::s3::api::multipart_global_state;
 
@@ -152,10 +224,17 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 		resp_.set("Etag", _irods_path);
 		resp_.keep_alive(parser_->get().keep_alive());
 
-		tp_ = std::make_shared<irods::experimental::io::client::default_transport>(*conn_);
 		odstream_ = std::make_shared<irods::experimental::io::odstream>();
 
-		if (upload_part_flag_ && part_offset_is_known_) {
+		if (writer_) {
+			// a large single part upload, the writer has already opened its streams to iRODS
+			logging::trace("{}: Writing iRODS data object [{}] over parallel streams.", __func__, irods_path_);
+			block_size_ = irods::s3::get_parallel_transfer_block_size_in_bytes();
+			block_.reserve(block_size_);
+		}
+		else if (upload_part_flag_ && part_offset_is_known_) {
+			tp_ = std::make_shared<irods::experimental::io::client::default_transport>(*conn_);
+
 			// we know the offset so seek and stream directly to iRODS
 			std::lock_guard<std::mutex> guard(part_shmem::multipart_global_state_mutex);
 
@@ -168,11 +247,13 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 					__func__,
 					irods_path_,
 					part_offset_);
+				irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
 				odstream_->open(
 					*tp_,
 					irods_path_,
 					irods::experimental::io::root_resource_name{irods::s3::get_resource()},
 					std::ios::out | std::ios::trunc);
+				timer.stop(!odstream_->is_open());
 				if (odstream_->is_open()) {
 					// the first stream that opens will stay open until CompleteMultipartTransfer is called
 					keep_dstream_open_flag = true;
@@ -188,12 +269,14 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 					irods_path_,
 					part_offset_,
 					std::get<0>(part_shmem::replica_token_number_and_odstream_map[upload_id_]).value);
+				irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
 				odstream_->open(
 					*tp_,
 					std::get<0>(part_shmem::replica_token_number_and_odstream_map[upload_id_]), // replica token
 					irods_path_,
 					std::get<1>(part_shmem::replica_token_number_and_odstream_map[upload_id_]), // replica number
 					std::ios::out | std::ios::in);
+				timer.stop(!odstream_->is_open());
 			}
 
 			if (!odstream_->is_open()) {
@@ -218,8 +301,11 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 			}
 		}
 		else { // just a single part upload, stream directly to iRODS
+			tp_ = std::make_shared<irods::experimental::io::client::default_transport>(*conn_);
 			logging::trace("{}: Open iRODS data object [{}] for writing.", __func__, part_filename_);
+			irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
 			odstream_->open(*tp_, irods_path_, irods::experimental::io::root_resource_name{irods::s3::get_resource()});
+			timer.stop(!odstream_->is_open());
 
 			if (!odstream_->is_open()) {
 				auto msg = fmt::format("{}:{} Failed to open iRODS object [{}].", __func__, __LINE__, _irods_path);
@@ -240,6 +326,8 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
   private:
 	auto read_from_socket() -> void
 	{
+		read_start_ = std::chrono::steady_clock::now();
+		session_ptr_->stream().expires_after(session_ptr_->timeout());
 		beast::http::async_read(
 			session_ptr_->stream(),
 			session_ptr_->get_buffer(),
@@ -249,12 +337,23 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 
 	auto on_incremental_async_read(beast::error_code _ec, std::size_t _bytes_transferred) -> void
 	{
+		// Socket reads complete on the request handler threads, so reinstall the request's profile.
+		const irods::s3::rpc_profiler::scope profile{profile_};
+
 		logging::trace("{}: multipart upload: Number of bytes read from socket = [{}]", __func__, _bytes_transferred);
 
 		if (_ec && _ec != beast::http::error::need_buffer) {
 			logging::error("{}: multipart upload: Error reading from socket: {}", __func__, _ec.message());
-			resp_.result(beast::http::status::internal_server_error);
-			session_ptr_->send(std::move(resp_)); // Schedules an async write op.
+			irods::http::globals::background_task([self = shared_from_this()] {
+				std::lock_guard lk{self->transfer_mutex_};
+				self->abandon();
+			});
+
+			// Nobody is left to receive a response if the client went away.
+			if (!irods::http::is_disconnect(_ec)) {
+				resp_.result(beast::http::status::internal_server_error);
+				session_ptr_->send(std::move(resp_)); // Schedules an async write op.
+			}
 			return;
 		}
 
@@ -263,6 +362,8 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 		// This work is scheduled on the background thread pool so other threads get a
 		// chance to perform socket IO. Socket IO occurs on foreground threads only.
 		irods::http::globals::background_task([self = shared_from_this()] {
+			std::lock_guard lk{self->transfer_mutex_};
+
 			const auto byte_count = self->buffer_.size() - self->parser_->get().body().size;
 			logging::trace(
 				"{}: multipart upload: [{}] bytes in buffer_body for part file [{}].",
@@ -284,6 +385,7 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 						__func__,
 						byte_count,
 						self->part_filename_);
+					self->abandon();
 					self->resp_.result(beast::http::status::internal_server_error);
 					self->session_ptr_->send(std::move(self->resp_)); // Schedules an async write op.
 					return;
@@ -294,13 +396,30 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 					byte_count,
 					self->part_filename_);
 			}
+			else if (self->writer_) {
+				if (!self->write_blocks(byte_count)) {
+					logging::error(
+						"{}: Error writing [{}] bytes to iRODS data object [{}].",
+						__func__,
+						byte_count,
+						self->irods_path_);
+					self->abandon();
+					self->resp_.result(beast::http::status::internal_server_error);
+					self->session_ptr_->send(std::move(self->resp_)); // Schedules an async write op.
+					return;
+				}
+			}
 			else {
-				if (!self->odstream_->write(self->buffer_.data(), byte_count)) {
+				const auto written = irods::s3::rpc_profiler::timed("DATA_OBJ_WRITE", [&self, byte_count] {
+					return static_cast<bool>(self->odstream_->write(self->buffer_.data(), byte_count));
+				});
+				if (!written) {
 					logging::error(
 						"{}: multipart upload: Error writing [{}] bytes to iRODS data object [{}].",
 						__func__,
 						byte_count,
 						self->irods_path_);
+					self->abandon();
 					self->resp_.result(beast::http::status::internal_server_error);
 					self->session_ptr_->send(std::move(self->resp_)); // Schedules an async write op.
 					return;
@@ -318,23 +437,507 @@ class incremental_async_read : public std::enable_shared_from_this<incremental_a
 				}
 				if (self->odstream_->is_open() && !self->keep_dstream_open_flag) {
 					logging::trace("{}:{} Closing iRODS data object [{}].", __func__, __LINE__, self->irods_path_);
-					self->odstream_->close();
+					irods::s3::rpc_profiler::timed("DATA_OBJ_CLOSE", [&self] { self->odstream_->close(); });
 				}
+				if (self->writer_) {
+					logging::trace("{}:{} Closing iRODS data object [{}].", __func__, __LINE__, self->irods_path_);
+					if (!self->block_.empty() && !self->writer_->write(self->block_offset_, std::move(self->block_))) {
+						self->fail_parallel_write();
+						return;
+					}
 
-				logging::trace("{}: Request message has been processed [parser is done]", __func__);
-				self->resp_.result(beast::http::status::ok);
-				self->session_ptr_->send(std::move(self->resp_)); // Schedules an async write op.
+					// The response is sent once the outstanding writes are done.
+					self->writer_->close([self](bool _closed) {
+						std::lock_guard lk{self->transfer_mutex_};
+						if (!_closed) {
+							self->fail_parallel_write();
+							return;
+						}
+						self->send_success();
+					});
+					return;
+				}
+
+				self->send_success();
 				return;
 			}
 
+			// The time from the start of the socket read until the bytes are stored covers both sides
+			// of the transfer, so the buffer only grows while that speeds up the upload as a whole.
+			self->sizer_.record(byte_count, std::chrono::steady_clock::now() - self->read_start_);
+			if (self->buffer_.size() != self->sizer_.size()) {
+				self->buffer_.resize(self->sizer_.size());
+			}
+
 			// Reset the parser's buffer_body state and schedule the next asynchronous read operation.
 			self->parser_->get().body().data = self->buffer_.data();
 			self->parser_->get().body().size = self->buffer_.size();
+
+			// Only read more of the body once the writer has a stream for every block handed to it.
+			if (self->writer_) {
+				self->writer_->when_ready([self] { self->read_from_socket(); });
+				return;
+			}
+
 			self->read_from_socket();
 		});
 	} // on_incremental_async_read
+
+	auto send_success() -> void
+	{
+		logging::trace("{}: Request message has been processed [parser is done]", __func__);
+		if (!upload_part_flag_) {
+			set_etag(resp_, irods_username_, irods_path_);
+		}
+		resp_.result(beast::http::status::ok);
+		session_ptr_->send(std::move(resp_)); // Schedules an async write op.
+	} // send_success
+
+	// Runs on a background thread with transfer_mutex_ held.
+	auto fail_parallel_write() -> void
+	{
+		logging::error("{}: Error writing to iRODS data object [{}].", __func__, irods_path_);
+		abandon();
+		resp_.result(beast::http::status::internal_server_error);
+		session_ptr_->send(std::move(resp_)); // Schedules an async write op.
+	} // fail_parallel_write
+
+	// Copies the bytes in the parser's buffer into the current block and hands every full block
+	// to the parallel writer.
+	auto write_blocks(std::size_t _byte_count) -> bool
+	{
+		const char* data = buffer_.data();
+
+		while (_byte_count > 0) {
+			const auto n = std::min<std::uint64_t>(_byte_count, block_size_ - block_.size());
+			block_.insert(std::end(block_), data, data + n);
+			data += n;
+			_byte_count -= n;
+
+			if (block_.size() == block_size_) {
+				const auto size = block_.size();
+				if (!writer_->write(block_offset_, std::move(block_))) {
+					return false;
+				}
+				block_offset_ += size;
+				block_ = {};
+				block_.reserve(block_size_);
+			}
+		}
+
+		return true;
+	} // write_blocks
+
+	// Cleans up after an upload which stopped before the whole body was stored, e.g. because the
+	// client went away. The bytes stored so far are removed so that they are never mistaken for a
+	// complete object or part, unless the object existed before the request. The streams open an
+	// existing object with truncation, so a failed overwrite leaves it truncated or partially
+	// written; removing it would only lose the ACLs and metadata as well. Runs on a background
+	// thread with transfer_mutex_ held.
+	auto abandon() -> void
+	{
+		if (std::exchange(abandoned_, true)) {
+			return;
+		}
+
+		if (part_file_.is_open()) {
+			part_file_.close();
+			std::remove(part_filename_.c_str());
+		}
+
+		if (writer_) {
+			writer_->abandon(!object_existed_);
+			return;
+		}
+
+		// The first stream of a multipart upload stays open until the upload is completed or aborted.
+		if (keep_dstream_open_flag) {
+			return;
+		}
+
+		if (odstream_->is_open()) {
+			irods::s3::rpc_profiler::timed("DATA_OBJ_CLOSE", [this] { odstream_->close(); });
+		}
+
+		if (!conn_) {
+			return;
+		}
+
+		// A part written straight into the data object is simply sent again by the client.
+		const auto remove_object = [this] { return fs::client::remove(*conn_, irods_path_); };
+		if (!upload_part_flag_ && !object_existed_ &&
+		    !irods::s3::rpc_profiler::timed("DATA_OBJ_UNLINK", remove_object))
+		{
+			logging::error("{}: Failed to remove partial iRODS data object [{}].", __func__, irods_path_);
+		}
+
+		conn_->disconnect();
+	} // abandon
 }; // class incremental_async_read
 
+// Reads an aws-chunked body ("STREAMING-AWS4-HMAC-SHA256-PAYLOAD") and writes the chunk data to
+// iRODS or to a part file.
+//
+// Like incremental_async_read, the socket is only read asynchronously on the I/O threads and the
+// chunks are parsed and written on the background threads. Chunk data is written as it arrives, so
+// a transfer never holds more than one read buffer and the start of the next chunk header.
+class chunked_async_read : public std::enable_shared_from_this<chunked_async_read>
+{
+	irods::http::session_pointer_type session_ptr_;
+	beast::http::response<beast::http::empty_body> resp_;
+	std::shared_ptr<beast::http::request_parser<boost::beast::http::buffer_body>> parser_;
+	irods::s3::transfer_buffer_sizer sizer_;
+	std::vector<char> buffer_;
+	std::chrono::steady_clock::time_point read_start_;
+	std::shared_ptr<std::ofstream> ofs_;
+	std::shared_ptr<irods::experimental::client_connection> conn_;
+	std::shared_ptr<irods::experimental::io::client::native_transport> tp_;
+	std::shared_ptr<irods::experimental::io::odstream> d_;
+	std::string irods_path_;
+	std::string irods_username_;
+	bool object_existed_;
+	std::string part_filename_;
+	bool upload_part_;
+	bool know_part_offset_;
+	bool keep_dstream_open_flag_;
+	std::string func_;
+
+	parsing_state current_state_ = parsing_state::header_begin;
+	std::size_t chunk_size_ = -1;
+	std::size_t chunk_bytes_remaining_ = 0;
+
+	// Holds input bytes until they have been parsed.
+	std::string parsing_buffer_;
+
+	// Serializes the writes to iRODS with abandon(), which is also scheduled from the socket's thread.
+	std::mutex transfer_mutex_;
+	bool abandoned_ = false;
+
+	std::shared_ptr<irods::s3::rpc_profiler::request_profile> profile_{irods::s3::rpc_profiler::current()};
+
+  public:
+	chunked_async_read(
+		irods::http::session_pointer_type _session_ptr,
+		beast::http::response<beast::http::empty_body>& _response,
+		std::shared_ptr<beast::http::request_parser<boost::beast::http::buffer_body>> _parser,
+		std::uint64_t _read_buffer_size,
+		std::shared_ptr<std::ofstream> _ofs,
+		std::shared_ptr<irods::experimental::client_connection> _conn,
+		std::shared_ptr<irods::experimental::io::client::native_transport> _tp,
+		std::shared_ptr<irods::experimental::io::odstream> _d,
+		std::string _irods_path,
+		std::string _irods_username,
+		bool _object_existed,
+		std::string _part_filename,
+		bool _upload_part,
+		bool _know_part_offset,
+		bool _keep_dstream_open_flag,
+		std::string _func)
+		: session_ptr_{std::move(_session_ptr)}
+		, resp_{std::move(_response)}
+		, parser_{std::move(_parser)}
+		, sizer_{_read_buffer_size, 0}
+		, ofs_{std::move(_ofs)}
+		, conn_{std::move(_conn)}
+		, tp_{std::move(_tp)}
+		, d_{std::move(_d)}
+		, irods_path_{std::move(_irods_path)}
+		, irods_username_{std::move(_irods_username)}
+		, object_existed_{_object_existed}
+		, part_filename_{std::move(_part_filename)}
+		, upload_part_{_upload_part}
+		, know_part_offset_{_know_part_offset}
+		, keep_dstream_open_flag_{_keep_dstream_open_flag}
+		, func_{std::move(_func)}
+	{
+		// The eager option instructs the parser to continue reading the buffer once it has completed a
+		// structured element (header, chunk header, chunk body). Since we are handling the parsing ourself,
+		// we want the parser to give us as much as is available.
+		parser_->eager(true);
+	} // constructor
+
+	auto start() -> void
+	{
+		read_from_socket();
+	} // start
+
+  private:
+	auto read_from_socket() -> void
+	{
+		buffer_.resize(sizer_.size());
+		parser_->get().body().data = buffer_.data();
+		parser_->get().body().size = buffer_.size();
+
+		read_start_ = std::chrono::steady_clock::now();
+		session_ptr_->stream().expires_after(session_ptr_->timeout());
+		beast::http::async_read(
+			session_ptr_->stream(),
+			session_ptr_->get_buffer(),
+			*parser_,
+			beast::bind_front_handler(&chunked_async_read::on_read, shared_from_this()));
+	} // read_from_socket
+
+	auto on_read(beast::error_code _ec, std::size_t) -> void
+	{
+		// Socket reads complete on the I/O threads, so reinstall the request's profile.
+		const irods::s3::rpc_profiler::scope profile{profile_};
+
+		// need buffer means we have filled the current buffer
+		if (_ec && _ec != beast::http::error::need_buffer) {
+			logging::error("{}: Error when parsing file - {}", func_, _ec.message());
+			irods::http::globals::background_task([self = shared_from_this()] {
+				std::lock_guard lk{self->transfer_mutex_};
+				self->abandon();
+			});
+
+			// Nobody is left to receive a response if the client went away.
+			if (!irods::http::is_disconnect(_ec)) {
+				resp_.result(beast::http::status::internal_server_error);
+				logging::debug("{}: returned [{}]", func_, resp_.reason());
+				session_ptr_->send(std::move(resp_));
+			}
+			return;
+		}
+
+		irods::http::globals::background_task([self = shared_from_this()] { self->parse(); });
+	} // on_read
+
+	// Parses and writes what has been read so far. Runs on a background thread.
+	auto parse() -> void
+	{
+		std::lock_guard lk{transfer_mutex_};
+
+		// add the current buffer into the parsing buffer
+		const auto bytes_read = buffer_.size() - parser_->get().body().size;
+		parsing_buffer_.append(buffer_.data(), bytes_read);
+
+		bool need_more = false;
+
+		// continue parsing until we need more bytes in the parsing buffer
+		while (!parser_->is_done() || !parsing_buffer_.empty()) {
+			// break out if at a terminal state
+			if (current_state_ == parsing_state::parsing_done || current_state_ == parsing_state::parsing_error) {
+				break;
+			}
+
+			// if we have read all from the parser but need more bytes enter error state
+			if (parser_->is_done() && need_more) {
+				logging::error("{}: Ran out of bytes before finished parsing", func_);
+				current_state_ = parsing_state::parsing_error;
+				break;
+			}
+
+			// if we need more, break out and read more from the socket
+			if (need_more) {
+				break;
+			}
+
+			switch (current_state_) {
+				case parsing_state::header_begin:
+					need_more = parse_header_begin();
+					break;
+
+				case parsing_state::header_continue: {
+					// move beyond the newline
+					const auto newline_location = parsing_buffer_.find("\r\n");
+
+					if (newline_location != std::string::npos) {
+						parsing_buffer_.erase(0, newline_location + 2);
+						current_state_ = (chunk_size_ == 0) ? parsing_state::end_of_chunk : parsing_state::body;
+					}
+					else if (!parser_->is_done()) {
+						need_more = true;
+					}
+					else {
+						// we have read all the bytes but do not have a \r\n at the end
+						// of the header line
+						logging::error("{}: Malformed chunk header", func_);
+						current_state_ = parsing_state::parsing_error;
+					}
+					break;
+				}
+
+				case parsing_state::body: {
+					// Write whatever part of the chunk has arrived.
+					const auto count = std::min(parsing_buffer_.size(), chunk_bytes_remaining_);
+					if (count == 0) {
+						need_more = true;
+						break;
+					}
+
+					try {
+						if (upload_part_ && !know_part_offset_) {
+							ofs_->write(parsing_buffer_.data(), static_cast<std::streamsize>(count));
+						}
+						else {
+							const irods::s3::rpc_profiler::timer timer{"DATA_OBJ_WRITE"};
+							d_->write(parsing_buffer_.data(), static_cast<std::streamsize>(count));
+						}
+					}
+					catch (std::exception& e) {
+						logging::error("{}: Exception when writing to file - {}", func_, e.what());
+						abandon();
+						resp_.result(beast::http::status::internal_server_error);
+						logging::debug("{}: returned [{}]", func_, resp_.reason());
+						session_ptr_->send(std::move(resp_));
+						return;
+					}
+
+					parsing_buffer_.erase(0, count);
+					chunk_bytes_remaining_ -= count;
+					if (chunk_bytes_remaining_ == 0) {
+						current_state_ = parsing_state::end_of_chunk;
+					}
+					break;
+				}
+
+				case parsing_state::end_of_chunk: {
+					// If the parsing buffer is empty or consists of "\r" only then we need to get
+					// more bytes to read the expected "\r\n".
+					if (!parser_->is_done() &&
+					    (parsing_buffer_.empty() || (parsing_buffer_.size() == 1 && parsing_buffer_[0] == '\r')))
+					{
+						need_more = true;
+						break;
+					}
+
+					if (parsing_buffer_.find("\r\n") != 0) {
+						logging::error("{}: Invalid chunk end sequence", func_);
+						current_state_ = parsing_state::parsing_error;
+					}
+					else {
+						// remove \r\n and go to next chunk
+						parsing_buffer_.erase(0, 2);
+						current_state_ = (chunk_size_ == 0) ? parsing_state::parsing_done : parsing_state::header_begin;
+					}
+					break;
+				}
+
+				default:
+					break;
+			}
+
+			// if we are done return ok
+			if (current_state_ == parsing_state::parsing_done) {
+				if (ofs_->is_open()) {
+					ofs_->close();
+				}
+				if (!keep_dstream_open_flag_ && d_->is_open()) {
+					logging::trace("{}:{} Closing iRODS data object.", __func__, __LINE__);
+					irods::s3::rpc_profiler::timed("DATA_OBJ_CLOSE", [this] { d_->close(); });
+				}
+				if (!upload_part_) {
+					set_etag(resp_, irods_username_, irods_path_);
+				}
+				resp_.result(beast::http::status::ok);
+				logging::debug("{}: returned [{}]:{}", func_, resp_.reason(), __LINE__);
+				session_ptr_->send(std::move(resp_));
+				return;
+			}
+
+			if (current_state_ == parsing_state::parsing_error) {
+				abandon();
+				logging::error("{}: Error parsing chunked body", func_);
+				resp_.result(boost::beast::http::status::bad_request);
+				logging::debug("{}: returned [{}]", func_, resp_.reason());
+				session_ptr_->send(std::move(resp_));
+				return;
+			}
+		}
+
+		sizer_.record(bytes_read, std::chrono::steady_clock::now() - read_start_);
+		read_from_socket();
+	} // parse
+
+	// Parses the start of a chunk header. Returns true if more bytes are needed.
+	//
+	// Chunk headers can be of the following forms:
+	// 1. With extensions: <hex>;extension1=extension1value;extension2=extension2value\r\n
+	// 2. Without extensions: <hex>\r\n
+	auto parse_header_begin() -> bool
+	{
+		// See if it is of form 1.
+		const auto semicolon_location = parsing_buffer_.find(";");
+		const auto newline_location = parsing_buffer_.find("\r\n");
+		const bool has_extensions = semicolon_location < newline_location;
+
+		if (!has_extensions && newline_location == std::string::npos) {
+			if (!parser_->is_done()) {
+				return true;
+			}
+
+			// we have received all of the bytes but do not have "<hex>\r\n" sequence
+			logging::error("{}: Malformed chunk header", func_);
+			current_state_ = parsing_state::parsing_error;
+			return false;
+		}
+
+		const auto end_of_size = has_extensions ? semicolon_location : newline_location;
+		const auto chunk_size_str = parsing_buffer_.substr(0, end_of_size);
+		std::size_t hex_digits_parsed = 0;
+		try {
+			chunk_size_ = std::stoull(chunk_size_str, &hex_digits_parsed, 16);
+		}
+		catch (const std::exception&) {
+			hex_digits_parsed = 0;
+		}
+
+		if (hex_digits_parsed != chunk_size_str.length()) {
+			logging::error("{}: bad chunk size: {}", func_, chunk_size_str);
+			current_state_ = parsing_state::parsing_error;
+			return false;
+		}
+
+		chunk_bytes_remaining_ = chunk_size_;
+
+		if (has_extensions) {
+			// eat the bytes up to and including the semicolon
+			parsing_buffer_.erase(0, semicolon_location + 1);
+			current_state_ = parsing_state::header_continue;
+		}
+		else {
+			// eat the bytes up to and including \r\n
+			parsing_buffer_.erase(0, newline_location + 2);
+			current_state_ = (chunk_size_ == 0) ? parsing_state::end_of_chunk : parsing_state::body;
+		}
+
+		return false;
+	} // parse_header_begin
+
+	// Cleans up after an upload which stopped before the whole body was stored. Like
+	// incremental_async_read::abandon(), the bytes stored so far are removed unless the object
+	// existed before the request, in which case a failed overwrite leaves it truncated or partially
+	// written. Runs on a background thread with transfer_mutex_ held.
+	auto abandon() -> void
+	{
+		if (std::exchange(abandoned_, true)) {
+			return;
+		}
+
+		if (ofs_->is_open()) {
+			ofs_->close();
+			std::remove(part_filename_.c_str());
+		}
+
+		// The first stream of a multipart upload stays open until the upload is completed or aborted.
+		if (keep_dstream_open_flag_) {
+			return;
+		}
+
+		if (d_->is_open()) {
+			irods::s3::rpc_profiler::timed("DATA_OBJ_CLOSE", [this] { d_->close(); });
+		}
+
+		// A part written straight into the data object is simply sent again by the client.
+		const auto remove_object = [this] { return fs::client::remove(*conn_, irods_path_); };
+		if (!upload_part_ && !object_existed_ && !irods::s3::rpc_profiler::timed("DATA_OBJ_UNLINK", remove_object)) {
+			logging::error("{}: Failed to remove partial iRODS data object [{}].", func_, irods_path_);
+		}
+
+		conn_->disconnect();
+	} // abandon
+}; // class chunked_async_read
+
 void irods::s3::actions::handle_putobject(
 	irods::http::session_pointer_type session_ptr,
 	beast::http::request_parser<boost::beast::http::empty_body>& empty_body_parser,
@@ -393,22 +996,9 @@ void irods::s3::actions::handle_putobject(
 		}
 	}
 
-	if (parser_message[beast::http::field::expect] == "100-continue") {
-		response.version(11);
-		response.result(beast::http::status::continue_);
-		response.set(beast::http::field::server, parser_message["Host"]);
-
-		beast::error_code ec;
-		beast::http::write(session_ptr->stream(), response, ec);
-		if (ec) {
-			logging::error("{}: multipart upload: Error sending [100-continue] response: {}", __func__, ec.message());
-			response.result(beast::http::status::internal_server_error);
-			session_ptr->send(std::move(response));
-			return;
-		}
-
-		logging::debug("{}: Sent 100-continue", __func__);
-	}
+	// "100 Continue" is sent once the upload is ready to receive the body. Until then, the client
+	// holds the body back.
+	const bool expect_continue = parser_message[beast::http::field::expect] == "100-continue";
 
 	fs::path path;
 	if (auto bucket = irods::s3::resolve_bucket(url.segments()); bucket.has_value()) {
@@ -600,12 +1190,21 @@ void irods::s3::actions::handle_putobject(
 		logging::debug("{}: UploadPart detected.  partNumber={} uploadId={}", __func__, part_number, upload_id);
 	}
 
-	// Make sure the parent collection exists.
+	// Make sure the parent collection exists. An abandoned upload only removes the object if the
+	// upload created it. An abandoned overwrite leaves the existing object with partial data.
+	bool object_existed = false;
 	{
 		auto conn = irods::get_connection(*irods_username);
-		fs::client::create_collections(conn, path.parent_path());
+		irods::s3::rpc_profiler::timed(
+			"COLL_CREATE", [&conn, &path] { fs::client::create_collections(conn, path.parent_path()); });
+		object_existed =
+			!upload_part && irods::s3::rpc_profiler::timed("OBJ_STAT", [&] { return fs::client::exists(conn, path); });
 	}
 
+	// The object is about to change. Cached copies are also checked against the catalog, so a
+	// copy cached while the upload is in progress is never served once the upload completes.
+	irods::s3::invalidate_cached_object(path.string());
+
 	uint64_t read_buffer_size = irods::s3::get_put_object_buffer_size_in_bytes();
 	logging::debug("{}: read_buffer_size={}", __func__, read_buffer_size);
 
@@ -613,30 +1212,57 @@ void irods::s3::actions::handle_putobject(
 	response.set("Connection", "close");
 	response.keep_alive(parser_message.keep_alive());
 
-	// Create a dedicated iRODS connection for the upload.
-	const auto& config = irods::http::globals::configuration();
-	const auto& irods_client_config = config.at("irods_client");
-	const auto& zone = irods_client_config.at("zone").get_ref<const std::string&>();
-
-	const auto& rodsadmin_username =
-		irods_client_config.at(json_pointer{"/proxy_admin_account/username"}).get_ref<const std::string&>();
-	auto rodsadmin_password =
-		irods_client_config.at(json_pointer{"/proxy_admin_account/password"}).get_ref<const std::string&>();
+	// Large single part uploads with a known length are written over several iRODS data streams.
+	std::shared_ptr<irods::s3::parallel_writer> writer;
+	if (!upload_part && !chunked_flag && !special_chunked_header) {
+		const auto stream_count = irods::s3::get_parallel_transfer_stream_count();
+		std::uint64_t content_length = 0;
+		try {
+			content_length = boost::lexical_cast<std::uint64_t>(parser_message[beast::http::field::content_length]);
+		}
+		catch (const boost::bad_lexical_cast&) {
+			// Let the parser report the malformed header.
+		}
 
-	auto conn = std::make_shared<irods::experimental::client_connection>(
-		irods::experimental::defer_authentication,
-		irods_client_config.at("host").get_ref<const std::string&>(),
-		irods_client_config.at("port").get<int>(),
-		irods::experimental::fully_qualified_username{rodsadmin_username, zone},
-		irods::experimental::fully_qualified_username{*irods_username, zone});
+		if (stream_count > 1 && content_length >= irods::s3::get_parallel_transfer_threshold_in_bytes()) {
+			logging::debug(
+				"{}: Writing [{}] bytes to [{}] over [{}] streams.",
+				__func__,
+				content_length,
+				path.c_str(),
+				stream_count);
+			try {
+				writer = std::make_shared<irods::s3::parallel_writer>(*irods_username, path, stream_count);
+			}
+			catch (const std::exception& e) {
+				logging::error("{}: Could not connect to iRODS: {}", __func__, e.what());
+				response.result(beast::http::status::internal_server_error);
+				session_ptr->send(std::move(response));
+				return;
+			}
 
-	auto* conn_ptr = static_cast<RcComm*>(*conn);
+			if (!writer->is_open()) {
+				response.result(beast::http::status::internal_server_error);
+				logging::debug("{}: returned [{}]", __func__, response.reason());
+				session_ptr->send(std::move(response));
+				return;
+			}
+		}
+	}
 
-	if (const auto ec = clientLoginWithPassword(conn_ptr, rodsadmin_password.data()); ec < 0) {
-		logging::error("{}: clientLoginWithPassword error: {}", __func__, ec);
-		response.result(beast::http::status::internal_server_error);
-		session_ptr->send(std::move(response));
-		return;
+	// Create a dedicated iRODS connection for the upload. The connection is opened against the
+	// server which will receive the bytes so that they do not pass through the catalog provider.
+	std::shared_ptr<irods::experimental::client_connection> conn;
+	if (!writer) {
+		try {
+			conn = irods::s3::get_data_connection(*irods_username, path, irods::s3::data_transfer_direction::write);
+		}
+		catch (const std::exception& e) {
+			logging::error("{}: Could not connect to iRODS: {}", __func__, e.what());
+			response.result(beast::http::status::internal_server_error);
+			session_ptr->send(std::move(response));
+			return;
+		}
 	}
 
 	if (special_chunked_header) {
@@ -665,11 +1291,13 @@ void irods::s3::actions::handle_putobject(
 						__func__,
 						path.string(),
 						part_offset);
+					irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
 					d->open(
 						*tp,
 						path,
 						irods::experimental::io::root_resource_name{irods::s3::get_resource()},
 						std::ios::out | std::ios::trunc);
+					timer.stop(!d->is_open());
 					if (d->is_open()) {
 						keep_dstream_open_flag = true;
 						part_shmem::replica_token_number_and_odstream_map[upload_id] = {
@@ -683,12 +1311,14 @@ void irods::s3::actions::handle_putobject(
 						__func__,
 						path.string(),
 						part_offset);
+					irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
 					d->open(
 						*tp,
 						std::get<0>(part_shmem::replica_token_number_and_odstream_map[upload_id]), // replica token
 						path,
 						std::get<1>(part_shmem::replica_token_number_and_odstream_map[upload_id]), // replica number
 						std::ios::out | std::ios::in);
+					timer.stop(!d->is_open());
 				}
 			}
 			if (!d->is_open()) {
@@ -712,7 +1342,9 @@ void irods::s3::actions::handle_putobject(
 			}
 		}
 		else {
+			irods::s3::rpc_profiler::timer timer{"DATA_OBJ_OPEN"};
 			d->open(*tp, path, irods::experimental::io::root_resource_name{irods::s3::get_resource()});
+			timer.stop(!d->is_open());
 			if (!d->is_open()) {
 				logging::error("{}: Failed to open dstream to iRODS", __func__);
 				response.result(beast::http::status::internal_server_error);
@@ -722,21 +1354,7 @@ void irods::s3::actions::handle_putobject(
 			}
 		}
 
-		// The eager option instructs the parser to continue reading the buffer once it has completed a
-		// structured element (header, chunk header, chunk body). Since we are handling the parsing ourself,
-		// we want the parser to give us as much as is available.
-		parser->eager(true);
-
-		parsing_state current_state = parsing_state::header_begin;
-
-		// This is a string that holds input bytes temporarily as they are being read
-		// from the stream.  This chunk parser will only read more bytes into this
-		// when necessary to continue parsing.  Once bytes are no longer needed they are
-		// discarded from this variable.
-		std::string parsing_buffer_string;
-		size_t chunk_size = -1;
-
-		manually_parse_chunked_body_write_to_irods_in_background(
+		auto reader = std::make_shared<chunked_async_read>(
 			session_ptr,
 			response,
 			parser,
@@ -745,330 +1363,32 @@ void irods::s3::actions::handle_putobject(
 			conn,
 			tp,
 			d,
+			path,
+			*irods_username,
+			object_existed,
+			upload_part_filename,
 			upload_part,
-			current_state,
-			chunk_size,
-			parsing_buffer_string,
 			know_part_offset,
 			keep_dstream_open_flag,
 			__func__);
+		send_continue_then_read(session_ptr, expect_continue, [reader] { reader->start(); });
 	}
 	else {
 		logging::debug("{}: upload_part={}", __func__, upload_part);
-		std::make_shared<incremental_async_read>(
+		auto reader = std::make_shared<incremental_async_read>(
 			parser,
 			session_ptr,
 			response,
 			path,
+			*irods_username,
+			object_existed,
 			upload_part,
 			know_part_offset,
 			part_offset,
 			upload_id,
 			upload_part_filename,
-			conn)
-			->start();
+			conn,
+			writer);
+		send_continue_then_read(session_ptr, expect_continue, [reader] { reader->start(); });
 	}
 } // handle_putobject
-
-void manually_parse_chunked_body_write_to_irods_in_background(
-	irods::http::session_pointer_type session_ptr,
-	beast::http::response<beast::http::empty_body>& response_,
-	std::shared_ptr<beast::http::request_parser<boost::beast::http::buffer_body>> parser,
-	uint64_t read_buffer_size,
-	std::shared_ptr<std::ofstream> ofs,
-	std::shared_ptr<irods::experimental::client_connection> conn,
-	std::shared_ptr<irods::experimental::io::client::native_transport> tp,
-	std::shared_ptr<irods::experimental::io::odstream> d,
-	bool upload_part,
-	parsing_state current_state,
-	size_t chunk_size,
-	const std::string& parsing_buffer_string_,
-	bool know_part_offset,
-	bool keep_dstream_open_flag,
-	const std::string func)
-{
-	irods::http::globals::background_task([session_ptr,
-	                                       response = std::move(response_),
-	                                       parser,
-	                                       read_buffer_size,
-	                                       ofs,
-	                                       conn,
-	                                       tp,
-	                                       d,
-	                                       upload_part,
-	                                       current_state,
-	                                       chunk_size,
-	                                       parsing_buffer_string = std::move(parsing_buffer_string_),
-	                                       know_part_offset,
-	                                       keep_dstream_open_flag,
-	                                       func]() mutable {
-		boost::beast::error_code ec;
-		auto& parser_message = parser->get();
-
-		std::vector<char> buf_vector(read_buffer_size);
-		parser_message.body().data = buf_vector.data();
-		parser_message.body().size = read_buffer_size;
-
-		// read in a loop and fill up buffer
-		// once we have filled the currently buffer, continue parsing
-		bool ready_to_continue_parsing = false;
-		while (!ready_to_continue_parsing && !parser->is_done()) {
-			beast::http::read_some(session_ptr->stream(), session_ptr->get_buffer(), *parser, ec);
-
-			// need buffer means we have filled the current parser, write it to iRODS
-			if (ec == beast::http::error::need_buffer) {
-				ready_to_continue_parsing = true;
-				ec = {};
-			}
-
-			if (ec) {
-				logging::error("{}: Error when parsing file - {}", func, ec.what());
-				response.result(beast::http::status::internal_server_error);
-				logging::debug("{}: returned [{}]", func, response.reason());
-				session_ptr->send(std::move(response));
-				return;
-			}
-		}
-
-		bool need_more = false;
-
-		// add the current buffer into the parsing_buffer_string
-		size_t bytes_read = read_buffer_size - parser_message.body().size;
-		parsing_buffer_string.append(buf_vector.data(), bytes_read);
-
-		// continue parsing until we need more bytes in parsing_buffer_string
-		while (!parser->is_done() || !parsing_buffer_string.empty()) {
-			// break out if at a terminal state
-			if (current_state == parsing_state::parsing_done || current_state == parsing_state::parsing_error) {
-				break;
-			}
-
-			// if we have read all from the parser but need more bytes enter error state
-			if (parser->is_done() && need_more) {
-				logging::error("{}: Ran out of bytes before finished parsing", func);
-				current_state = parsing_state::parsing_error;
-				break;
-			}
-
-			// if we need more, break out and continue in a new background thread
-			if (need_more) {
-				break;
-			}
-
-			switch (current_state) {
-				case parsing_state::header_begin: {
-					// Chunk headers can be of the following forms:
-					// 1. With extensions: <hex>;extension1=extension1value;extension2=extension2value\r\n
-					// 2. Without extensions: <hex>\r\n
-
-					// See if it is of form 1.
-					size_t semicolon_location = parsing_buffer_string.find(";");
-					if (semicolon_location == std::string::npos) {
-						// Not form 1.  See if it is form 2.
-						size_t newline_location = parsing_buffer_string.find("\r\n");
-						if (newline_location != std::string::npos) {
-							std::string chunk_size_str = parsing_buffer_string.substr(0, newline_location);
-							size_t hex_digits_parsed = 0;
-							try {
-								chunk_size = stoull(chunk_size_str, &hex_digits_parsed, 16);
-							}
-							catch (std::invalid_argument& e) {
-								hex_digits_parsed = 0;
-							}
-
-							if (hex_digits_parsed == chunk_size_str.length()) {
-								// eat the bytes up to and including \r\n
-								parsing_buffer_string = parsing_buffer_string.substr(newline_location + 2);
-								if (chunk_size == 0) {
-									current_state = parsing_state::end_of_chunk;
-								}
-								else {
-									current_state = parsing_state::body;
-								}
-							}
-							else {
-								logging::error("{}: bad chunk size: {}", func, chunk_size_str);
-								current_state = parsing_state::parsing_error;
-							}
-						}
-						else if (!parser->is_done()) {
-							need_more = true;
-						}
-						else {
-							// we have received all of the bytes but do not have "<hex>\r\n" sequence
-							logging::error("{}: Malformed chunk header", func);
-							current_state = parsing_state::parsing_error;
-						}
-					}
-					else {
-						// semicolon found
-						std::string chunk_size_str = parsing_buffer_string.substr(0, semicolon_location);
-						size_t hex_digits_parsed = 0;
-						try {
-							chunk_size = stoull(chunk_size_str, &hex_digits_parsed, 16);
-						}
-						catch (std::invalid_argument& e) {
-							hex_digits_parsed = 0;
-						}
-						if (hex_digits_parsed == chunk_size_str.length()) {
-							// eat the bytes up to and including semicolon
-							parsing_buffer_string = parsing_buffer_string.substr(semicolon_location + 1);
-							current_state = parsing_state::header_continue;
-						}
-						else {
-							logging::error("{}: bad chunk size: {}", func, chunk_size_str);
-							current_state = parsing_state::parsing_error;
-						}
-					}
-					break;
-				}
-				case parsing_state::header_continue: {
-					// move beyond the newline
-					size_t newline_location = parsing_buffer_string.find("\r\n");
-
-					// set string to after the \r\n
-					if (newline_location != std::string::npos) {
-						parsing_buffer_string = parsing_buffer_string.substr(newline_location + 2);
-						if (chunk_size == 0) {
-							current_state = parsing_state::end_of_chunk;
-						}
-						else {
-							current_state = parsing_state::body;
-						}
-					}
-					else if (!parser->is_done()) {
-						need_more = true;
-					}
-					else {
-						// we have read all the bytes but do not have a \r\n at the end
-						// of the header line
-						logging::error("{}: Malformed chunk header", func);
-						current_state = parsing_state::parsing_error;
-					}
-					break;
-				}
-				case parsing_state::body: {
-					// if we have the full chunk, handle it otherwise continue
-					// until we do
-					if (parsing_buffer_string.length() >= chunk_size) {
-						std::string body = parsing_buffer_string.substr(0, chunk_size);
-
-						try {
-							if (upload_part && !know_part_offset) {
-								ofs->write(body.c_str(), body.length());
-							}
-							else {
-								d->write(body.c_str(), body.length());
-							}
-						}
-						catch (std::exception& e) {
-							logging::error("{}: Exception when writing to file - {}", func, e.what());
-							response.result(beast::http::status::internal_server_error);
-							logging::debug("{}: returned [{}]", func, response.reason());
-							session_ptr->send(std::move(response));
-							return;
-						}
-
-						// reset string stream and set it to after the \r\n
-						parsing_buffer_string = parsing_buffer_string.substr(chunk_size);
-						current_state = parsing_state::end_of_chunk;
-					}
-					else {
-						// Note to save memory we could stream the bytes we have, decrease
-						// chunk size, and discard these bytes.
-						need_more = true;
-					}
-					break;
-				}
-				case parsing_state::end_of_chunk: {
-					// If the size of parsing_buffer_string is just one and consists of "\r"
-					// then we need to get more bytes.
-					if (!parser->is_done() && parsing_buffer_string.size() == 1 && parsing_buffer_string[0] == '\r') {
-						// we don't have enough bytes to read the expected "\r\n"
-						// but there are more bytes to be read
-						need_more = true;
-						break;
-					}
-
-					// If the size is 0 then we need to get more bytes.
-					if (!parser->is_done() && parsing_buffer_string.size() == 0) {
-						// we don't have enough bytes to read the expected "\r\n"
-						// but there are more bytes to be read
-						need_more = true;
-						break;
-					}
-
-					size_t newline_location = parsing_buffer_string.find("\r\n");
-					if (newline_location != 0) {
-						logging::error("{}: Invalid chunk end sequence", func);
-						current_state = parsing_state::parsing_error;
-					}
-					else {
-						// remove \r\n and go to next chunk
-						parsing_buffer_string = parsing_buffer_string.substr(2);
-						if (chunk_size == 0) {
-							current_state = parsing_state::parsing_done;
-						}
-						else {
-							current_state = parsing_state::header_begin;
-						}
-					}
-					break;
-				}
-				default:
-					break;
-			}
-
-			// if we are done return ok
-			if (current_state == parsing_state::parsing_done) {
-				// this is to force that these are destructed in the correct order
-				auto conn_ptr = conn;
-				auto transport_ptr = tp;
-				auto dstream_ptr = d;
-
-				if (ofs->is_open()) {
-					ofs->close();
-				}
-				if (!keep_dstream_open_flag && d->is_open()) {
-					logging::trace("{}:{} Closing iRODS data object.", __func__, __LINE__);
-					d->close();
-				}
-				response.result(beast::http::status::ok);
-				logging::debug("{}: returned [{}]:{}", func, response.reason(), __LINE__);
-				session_ptr->send(std::move(response));
-				return;
-			}
-			else if (current_state == parsing_state::parsing_error) {
-				if (ofs->is_open()) {
-					ofs->close();
-				}
-				if (d->is_open()) {
-					d->close();
-				}
-				logging::error("{}: Error parsing chunked body", func);
-				response.result(boost::beast::http::status::bad_request);
-				logging::debug("{}: returned [{}]", func, response.reason());
-				session_ptr->send(std::move(response));
-				return;
-			}
-		}
-
-		// schedule a new task to continue
-		manually_parse_chunked_body_write_to_irods_in_background(
-			session_ptr,
-			response,
-			parser,
-			read_buffer_size,
-			ofs,
-			conn,
-			tp,
-			d,
-			upload_part,
-			current_state,
-			chunk_size,
-			parsing_buffer_string,
-			know_part_offset,
-			keep_dstream_open_flag,
-			func);
-	});
-} // manually_parse_chunked_body_write_to_irods_in_background
@@ -0,0 +1,142 @@
+#include "irods/private/s3_api/s3_api.hpp"
+#include "irods/private/s3_api/archive.hpp"
+#include "irods/private/s3_api/authentication.hpp"
+#include "irods/private/s3_api/bucket.hpp"
+#include "irods/private/s3_api/common_routines.hpp"
+#include "irods/private/s3_api/connection.hpp"
+#include "irods/private/s3_api/globals.hpp"
+#include "irods/private/s3_api/log.hpp"
+#include "irods/private/s3_api/object_stat.hpp"
+#include "irods/private/s3_api/common.hpp"
+#include "irods/private/s3_api/session.hpp"
+
+#include <irods/irods_exception.hpp>
+
+namespace beast = boost::beast;
+namespace fs = irods::experimental::filesystem;
+namespace logging = irods::http::logging;
+
+namespace
+{
+	// Queues the object to be staged from the archive.
+	void restore_object(
+		irods::http::session_pointer_type session_ptr,
+		const std::string& irods_username,
+		const boost::urls::url_view& url);
+} // namespace
+
+void irods::s3::actions::handle_restoreobject(
+	irods::http::session_pointer_type session_ptr,
+	boost::beast::http::request_parser<boost::beast::http::empty_body>& empty_body_parser,
+	const boost::urls::url_view& url)
+{
+	beast::http::response<beast::http::empty_body> response;
+
+	auto irods_username = irods::s3::authentication::authenticates(empty_body_parser, url);
+	if (!irods_username) {
+		response.result(beast::http::status::forbidden);
+		logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+		session_ptr->send(std::move(response));
+		return;
+	}
+
+	// The RestoreRequest in the body is read but not used. Restored objects stay staged until iRODS
+	// purges them, so the number of days cannot be honored.
+	irods::s3::api::common_routines::read_string_body_async(
+		session_ptr,
+		empty_body_parser,
+		irods::http::globals::metadata_task,
+		[session_ptr, irods_username = *irods_username, url = boost::urls::url{url}](auto) {
+			restore_object(session_ptr, irods_username, url);
+		},
+		__FUNCTION__);
+} // handle_restoreobject
+
+namespace
+{
+	void restore_object(
+		irods::http::session_pointer_type session_ptr,
+		const std::string& irods_username,
+		const boost::urls::url_view& url)
+	{
+		using irods::s3::api::common_routines::send_error_response;
+
+		beast::http::response<beast::http::empty_body> response;
+
+		fs::path path;
+		if (auto bucket = irods::s3::resolve_bucket(url.segments()); bucket.has_value()) {
+			path = bucket.value();
+			path = irods::s3::finish_path(path, url.segments());
+		}
+		else {
+			return send_error_response(
+				session_ptr,
+				beast::http::status::not_found,
+				"NoSuchBucket",
+				"The specified bucket does not exist",
+				url.path(),
+				__FUNCTION__);
+		}
+
+		try {
+			const auto info = irods::with_catalog_retry(irods_username, [&path, &irods_username](auto& conn) {
+				return irods::s3::stat_object(conn, path, irods_username);
+			});
+
+			if (!info) {
+				return send_error_response(
+					session_ptr,
+					beast::http::status::not_found,
+					"NoSuchKey",
+					"The specified key does not exist",
+					url.path(),
+					__FUNCTION__);
+			}
+
+			if (!info->accessible) {
+				return send_error_response(
+					session_ptr,
+					beast::http::status::forbidden,
+					"AccessDenied",
+					"Access Denied",
+					url.path(),
+					__FUNCTION__);
+			}
+
+			auto* restores = irods::http::globals::restore_queue();
+			if (!restores || !irods::s3::is_archived(*info)) {
+				return send_error_response(
+					session_ptr,
+					beast::http::status::forbidden,
+					"InvalidObjectState",
+					"Restore is not allowed for the object's current storage class",
+					url.path(),
+					__FUNCTION__);
+			}
+
+			// A staged copy already exists.
+			if (!irods::s3::needs_restore(*info)) {
+				response.result(beast::http::status::ok);
+			}
+			else if (restores->restore(irods_username, path)) {
+				response.result(beast::http::status::accepted);
+			}
+			else {
+				return send_error_response(
+					session_ptr,
+					beast::http::status::conflict,
+					"RestoreAlreadyInProgress",
+					"Object restore is already in progress",
+					url.path(),
+					__FUNCTION__);
+			}
+		}
+		catch (const std::exception& e) {
+			logging::error("{}: {}", __FUNCTION__, e.what());
+			response.result(beast::http::status::internal_server_error);
+		}
+
+		logging::debug("{}: returned [{}]", __FUNCTION__, response.reason());
+		session_ptr->send(std::move(response));
+	} // restore_object
+} // namespace
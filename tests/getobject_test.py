@@ -1,8 +1,11 @@
 import unittest
 import boto3
+import botocore
 from boto3.s3.transfer import TransferConfig
 import inspect
 import os
+import threading
+import time
 from libs.execute import *
 from libs.command import *
 from libs.utility import *
@@ -73,6 +76,28 @@ class GetObject_Test(TestCase):
             os.remove(get_filename)
             assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
 
+    def test_botocore_get_above_parallel_transfer_threshold(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+        get_filename = f"{put_filename}.get"
+
+        try:
+
+            # a size which is not a multiple of the parallel transfer block size
+            make_arbitrary_file(put_filename, 40*1024*1024 + 12345)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+
+            # get_object reads the whole object in a single request so it is read over parallel streams
+            response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename)
+            with open(get_filename, 'wb') as f:
+                f.write(response['Body'].read())
+            assert_command(f'diff -q {put_filename} {get_filename}')
+
+        finally:
+            os.remove(put_filename)
+            os.remove(get_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
     def test_botocore_put_in_subdirectory(self):
 
         put_filename = inspect.currentframe().f_code.co_name 
@@ -234,3 +259,434 @@ class GetObject_Test(TestCase):
             os.remove(put_filename)
             os.remove(get_filename)
             assert_command(f'irm -rf {self.bucket_irods_path}/{put_directory}')
+
+    def test_botocore_get_suffix_range(self):
+
+        put_filename = inspect.currentframe().f_code.co_name 
+
+        try:
+            make_arbitrary_file(put_filename, 100*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+
+            response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename, Range='bytes=-100')
+            self.assertEqual(response['ResponseMetadata']['HTTPStatusCode'], 206)
+            self.assertEqual(response['ContentRange'], f'bytes {100*1024 - 100}-{100*1024 - 1}/{100*1024}')
+
+            with open(put_filename, 'rb') as f:
+                f.seek(-100, os.SEEK_END)
+                self.assertEqual(response['Body'].read(), f.read())
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_small_file_whole_and_range(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+
+        try:
+            # small enough to be read with a single iRODS call
+            make_arbitrary_file(put_filename, 4*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+
+            with open(put_filename, 'rb') as f:
+                contents = f.read()
+
+            response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename)
+            self.assertEqual(response['ResponseMetadata']['HTTPStatusCode'], 200)
+            self.assertEqual(response['ContentLength'], 4*1024)
+            self.assertEqual(response['Body'].read(), contents)
+
+            response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename, Range='bytes=100-199')
+            self.assertEqual(response['ResponseMetadata']['HTTPStatusCode'], 206)
+            self.assertEqual(response['ContentRange'], f'bytes 100-199/{4*1024}')
+            self.assertEqual(response['Body'].read(), contents[100:200])
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_multiple_ranges(self):
+
+        put_filename = inspect.currentframe().f_code.co_name 
+
+        try:
+            make_arbitrary_file(put_filename, 100*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+
+            # the ranges are out of order to check that they are returned in ascending order
+            response = self.boto3_client.get_object(Bucket=self.bucket_name,
+                                                    Key=put_filename,
+                                                    Range='bytes=-10,0-9,5000-5099')
+            self.assertEqual(response['ResponseMetadata']['HTTPStatusCode'], 206)
+            self.assertTrue(response['ContentType'].startswith('multipart/byteranges; boundary='))
+            boundary = response['ContentType'].split('boundary=')[1]
+            body = response['Body'].read()
+
+            with open(put_filename, 'rb') as f:
+                contents = f.read()
+
+            expected = b''
+            for first, last in [(0, 9), (5000, 5099), (100*1024 - 10, 100*1024 - 1)]:
+                expected += (f'\r\n--{boundary}\r\nContent-Type: application/octet-stream\r\n'
+                             f'Content-Range: bytes {first}-{last}/{100*1024}\r\n\r\n').encode()
+                expected += contents[first:last + 1]
+            expected += f'\r\n--{boundary}--\r\n'.encode()
+            self.assertEqual(body, expected)
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_conditional(self):
+
+        put_filename = inspect.currentframe().f_code.co_name 
+
+        try:
+            make_arbitrary_file(put_filename, 100*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+
+            etag = self.boto3_client.head_object(Bucket=self.bucket_name, Key=put_filename)['ETag']
+
+            # a matching If-None-Match returns 304 without a body
+            with self.assertRaises(botocore.exceptions.ClientError) as cm:
+                self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename, IfNoneMatch=etag)
+            self.assertEqual(cm.exception.response['Error']['Code'], '304')
+
+            # a mismatching If-Match returns 412
+            with self.assertRaises(botocore.exceptions.ClientError) as cm:
+                self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename, IfMatch='"stale"')
+            self.assertEqual(cm.exception.response['ResponseMetadata']['HTTPStatusCode'], 412)
+
+            # a matching If-Match returns the object
+            response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename, IfMatch=etag)
+            self.assertEqual(response['ETag'], etag)
+            self.assertEqual(len(response['Body'].read()), 100*1024)
+
+            # overwriting the object changes the ETag, so a stale If-Range returns the whole object
+            make_arbitrary_file(put_filename, 50*1024)
+            assert_command(f'iput -f {put_filename} {self.bucket_irods_path}/{put_filename}')
+            def add_if_range(request, **kwargs):
+                request.headers['If-Range'] = etag
+            self.boto3_client.meta.events.register('before-sign.s3.GetObject', add_if_range)
+            try:
+                response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename, Range='bytes=0-9')
+            finally:
+                self.boto3_client.meta.events.unregister('before-sign.s3.GetObject', add_if_range)
+            self.assertEqual(response['ResponseMetadata']['HTTPStatusCode'], 200)
+            self.assertEqual(len(response['Body'].read()), 50*1024)
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_etag_changes_on_overwrite_within_a_second(self):
+
+        put_filename = inspect.currentframe().f_code.co_name 
+
+        try:
+            with open(put_filename, 'wb') as f:
+                f.write(b'a' * 100*1024)
+            assert_command(f'iput -k {put_filename} {self.bucket_irods_path}/{put_filename}')
+            _,mtime,_ = assert_command(f'iquest "%s" "select DATA_MODIFY_TIME where COLL_NAME = \'{self.bucket_irods_path}\' and DATA_NAME = \'{put_filename}\'"', 'STDOUT')
+            etag = self.boto3_client.head_object(Bucket=self.bucket_name, Key=put_filename)['ETag']
+
+            # an ETag has the length of an MD5 digest, like the ETags of S3
+            self.assertRegex(etag, r'^"[0-9a-f]{32}"$')
+
+            # other bytes of the same size with the same modification time
+            with open(put_filename, 'wb') as f:
+                f.write(b'b' * 100*1024)
+            assert_command(f'iput -f -k {put_filename} {self.bucket_irods_path}/{put_filename}')
+            assert_command(f'itouch -s {mtime.strip()} {self.bucket_irods_path}/{put_filename}')
+
+            response = self.boto3_client.head_object(Bucket=self.bucket_name, Key=put_filename)
+            self.assertNotEqual(response['ETag'], etag)
+
+            # a stale If-Match is rejected and GetObject reports the same ETag as HeadObject
+            with self.assertRaises(botocore.exceptions.ClientError) as cm:
+                self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename, IfMatch=etag)
+            self.assertEqual(cm.exception.response['ResponseMetadata']['HTTPStatusCode'], 412)
+            self.assertEqual(self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename)['ETag'],
+                             response['ETag'])
+
+            # ListObjects reports the same ETag
+            listing = self.boto3_client.list_objects_v2(Bucket=self.bucket_name, Prefix=put_filename)
+            self.assertEqual([o['ETag'] for o in listing['Contents'] if o['Key'] == put_filename], [response['ETag']])
+
+            # PutObject reports the ETag of the object it wrote
+            put_response = self.boto3_client.put_object(Bucket=self.bucket_name, Key=put_filename, Body=b'c' * 100*1024)
+            self.assertEqual(put_response['ETag'],
+                             self.boto3_client.head_object(Bucket=self.bucket_name, Key=put_filename)['ETag'])
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_repeatedly_after_overwrite(self):
+
+        put_filename = inspect.currentframe().f_code.co_name 
+        get_filename = f"{put_filename}.get"
+
+        try:
+            # small objects may be served from the object cache after the first read
+            make_arbitrary_file(put_filename, 100*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+            for _ in range(3):
+                with open(get_filename, 'wb') as f:
+                    self.boto3_client.download_fileobj(self.bucket_name, put_filename, f)
+                assert_command(f'diff -q {put_filename} {get_filename}')
+
+            # a ranged read is served from the same bytes
+            response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename, Range='bytes=100-199')
+            with open(put_filename, 'rb') as f:
+                f.seek(100)
+                self.assertEqual(response['Body'].read(), f.read(100))
+
+            # an object changed outside of the S3 API must not be served from the cache
+            make_arbitrary_file(put_filename, 60*1024)
+            assert_command(f'iput -f {put_filename} {self.bucket_irods_path}/{put_filename}')
+            with open(get_filename, 'wb') as f:
+                self.boto3_client.download_fileobj(self.bucket_name, put_filename, f)
+            assert_command(f'diff -q {put_filename} {get_filename}')
+
+            # an object overwritten through the S3 API must not be served from the cache
+            make_arbitrary_file(put_filename, 30*1024)
+            self.boto3_client.upload_file(put_filename, self.bucket_name, put_filename)
+            with open(get_filename, 'wb') as f:
+                self.boto3_client.download_fileobj(self.bucket_name, put_filename, f)
+            assert_command(f'diff -q {put_filename} {get_filename}')
+
+        finally:
+            os.remove(put_filename)
+            os.remove(get_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_cached_object_without_permission(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+
+        # rods holds no permission on the objects alice puts in her bucket
+        rods_client = boto3.client('s3',
+                                   use_ssl=False,
+                                   endpoint_url=self.s3_api_url,
+                                   aws_access_key_id='s3_key1',
+                                   aws_secret_access_key='s3_secret_key1')
+
+        try:
+            # the object is put in the object cache by alice's reads
+            make_arbitrary_file(put_filename, 100*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+            for _ in range(2):
+                self.assertEqual(len(self.boto3_client.get_object(Bucket=self.bucket_name,
+                                                                  Key=put_filename)['Body'].read()), 100*1024)
+
+            # the cached bytes must not be served to a user who may not read the object
+            with self.assertRaises(botocore.exceptions.ClientError) as cm:
+                rods_client.get_object(Bucket=self.bucket_name, Key=put_filename)['Body'].read()
+            self.assertEqual(cm.exception.response['ResponseMetadata']['HTTPStatusCode'], 403)
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_large_cached_object_without_permission(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+
+        # rods holds no permission on the objects alice puts in her bucket
+        rods_client = boto3.client('s3',
+                                   use_ssl=False,
+                                   endpoint_url=self.s3_api_url,
+                                   aws_access_key_id='s3_key1',
+                                   aws_secret_access_key='s3_secret_key1')
+
+        try:
+            # the object is copied to the disk cache in the background after alice's first read
+            make_arbitrary_file(put_filename, 8*1024*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+            for _ in range(3):
+                self.assertEqual(len(self.boto3_client.get_object(Bucket=self.bucket_name,
+                                                                  Key=put_filename)['Body'].read()), 8*1024*1024)
+                time.sleep(1)
+
+            # neither the whole object nor a range of it may be served to a user who may not read it
+            for kwargs in [{}, {'Range': 'bytes=5000000-5000099'}]:
+                with self.assertRaises(botocore.exceptions.ClientError) as cm:
+                    rods_client.get_object(Bucket=self.bucket_name, Key=put_filename, **kwargs)['Body'].read()
+                self.assertEqual(cm.exception.response['ResponseMetadata']['HTTPStatusCode'], 403)
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_large_file_repeatedly_after_overwrite(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+        get_filename = f"{put_filename}.get"
+
+        try:
+            # large objects are copied to the disk cache after the first read
+            make_arbitrary_file(put_filename, 8*1024*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+            for _ in range(3):
+                with open(get_filename, 'wb') as f:
+                    self.boto3_client.download_fileobj(self.bucket_name, put_filename, f)
+                assert_command(f'diff -q {put_filename} {get_filename}')
+                time.sleep(1)
+
+            # a ranged read is served from the same file
+            response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename,
+                                                    Range='bytes=5000000-5000099')
+            with open(put_filename, 'rb') as f:
+                f.seek(5000000)
+                self.assertEqual(response['Body'].read(), f.read(100))
+
+            # an object overwritten through the S3 API must not be served from the cache
+            make_arbitrary_file(put_filename, 6*1024*1024)
+            self.boto3_client.upload_file(put_filename, self.bucket_name, put_filename)
+            with open(get_filename, 'wb') as f:
+                self.boto3_client.download_fileobj(self.bucket_name, put_filename, f)
+            assert_command(f'diff -q {put_filename} {get_filename}')
+
+        finally:
+            os.remove(put_filename)
+            os.remove(get_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_many_ranges_after_overwrite(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+
+        try:
+            # successive ranged reads may reuse a data object left open by an earlier one
+            make_arbitrary_file(put_filename, 6*1024*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+            with open(put_filename, 'rb') as f:
+                for offset in range(0, 6*1024*1024, 512*1024):
+                    response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename,
+                                                            Range=f'bytes={offset}-{offset + 4095}')
+                    f.seek(offset)
+                    self.assertEqual(response['Body'].read(), f.read(4096))
+
+            # an object overwritten through the S3 API must not be read through a handle opened before
+            make_arbitrary_file(put_filename, 5*1024*1024)
+            self.boto3_client.upload_file(put_filename, self.bucket_name, put_filename)
+            with open(put_filename, 'rb') as f:
+                for offset in range(0, 5*1024*1024, 1024*1024):
+                    response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=put_filename,
+                                                            Range=f'bytes={offset}-{offset + 4095}')
+                    f.seek(offset)
+                    self.assertEqual(response['Body'].read(), f.read(4096))
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_same_object_concurrently(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+        client_count = 20
+
+        clients = boto3.client('s3',
+                               use_ssl=False,
+                               endpoint_url=self.s3_api_url,
+                               aws_access_key_id=self.key,
+                               aws_secret_access_key=self.secret_key,
+                               config=botocore.config.Config(max_pool_connections=client_count))
+
+        bodies = [None] * client_count
+
+        def get(i):
+            response = clients.get_object(Bucket=self.bucket_name, Key=put_filename)
+            # half of the clients read slowly so that the others have to get ahead of them
+            if i % 2 == 0:
+                body = b''
+                while chunk := response['Body'].read(256*1024):
+                    body += chunk
+                    time.sleep(0.01)
+                bodies[i] = body
+            else:
+                bodies[i] = response['Body'].read()
+
+        threads = [threading.Thread(target=get, args=(i,)) for i in range(client_count)]
+
+        try:
+            make_arbitrary_file(put_filename, 8*1024*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+
+            with open(put_filename, 'rb') as f:
+                contents = f.read()
+
+            # the requests arrive together and share a single read from iRODS
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join(timeout=120)
+
+            for body in bodies:
+                self.assertEqual(body, contents)
+
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_botocore_get_is_fast_while_many_clients_read_slowly(self):
+
+        large_filename = inspect.currentframe().f_code.co_name
+        small_filename = f"{large_filename}.small"
+        slow_client_count = 100
+
+        # every slow client holds its own connection
+        slow_clients = boto3.client('s3',
+                                    use_ssl=False,
+                                    endpoint_url=self.s3_api_url,
+                                    aws_access_key_id=self.key,
+                                    aws_secret_access_key=self.secret_key,
+                                    config=botocore.config.Config(max_pool_connections=slow_client_count))
+
+        stop = threading.Event()
+        started = threading.Semaphore(0)
+
+        def read_slowly():
+            response = slow_clients.get_object(Bucket=self.bucket_name, Key=large_filename)
+            started.release()
+            body = response['Body']
+            # the object is much larger than the socket buffers so the server is soon unable to
+            # write to this client
+            while not stop.is_set() and body.read(1024):
+                time.sleep(0.1)
+            body.close()
+
+        threads = [threading.Thread(target=read_slowly) for _ in range(slow_client_count)]
+
+        try:
+            make_arbitrary_file(large_filename, 32*1024*1024)
+            make_arbitrary_file(small_filename, 1024)
+            assert_command(f'iput {large_filename} {self.bucket_irods_path}/{large_filename}')
+            assert_command(f'iput {small_filename} {self.bucket_irods_path}/{small_filename}')
+
+            for thread in threads:
+                thread.start()
+            for _ in range(slow_client_count):
+                self.assertTrue(started.acquire(timeout=60))
+
+            # give the server time to fill the socket buffers of the slow clients
+            time.sleep(2)
+
+            for _ in range(10):
+                start = time.monotonic()
+                self.boto3_client.head_object(Bucket=self.bucket_name, Key=small_filename)
+                response = self.boto3_client.get_object(Bucket=self.bucket_name, Key=small_filename)
+                self.assertEqual(len(response['Body'].read()), 1024)
+                self.assertLess(time.monotonic() - start, 2)
+
+        finally:
+            stop.set()
+            for thread in threads:
+                if thread.ident is not None:
+                    thread.join()
+            os.remove(large_filename)
+            os.remove(small_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{large_filename}')
+            assert_command(f'irm -f {self.bucket_irods_path}/{small_filename}')
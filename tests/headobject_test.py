@@ -8,7 +8,7 @@ import os
 from libs.execute import *
 from libs.command import *
 from libs.utility import *
-from datetime import datetime
+from datetime import datetime, timezone
 from host_port import s3_api_host_port, irods_host
 
 class HeadObject_Test(TestCase):
@@ -50,13 +50,13 @@ class HeadObject_Test(TestCase):
 
             # get file last modified time for comparison below
             _,out,_ = assert_command(f'iquest "%s" "select DATA_MODIFY_TIME where COLL_NAME = \'{self.bucket_irods_path}\' and DATA_NAME = \'{put_filename}\'"', 'STDOUT')
-            object_create_time = datetime.fromtimestamp(int(out))
+            object_create_time = datetime.fromtimestamp(int(out), timezone.utc)
             print(out)
 
             head_object_result = self.boto3_client.head_object(Bucket=self.bucket_name, Key=f'{put_filename}')
             self.assertEqual(head_object_result['ResponseMetadata']['HTTPStatusCode'], 200)
             self.assertEqual(head_object_result['ContentLength'], file_size)
-            self.assertEqual(head_object_result['LastModified'].replace(tzinfo=None), datetime.fromtimestamp(int(out)).replace(tzinfo=None))
+            self.assertEqual(head_object_result['LastModified'].replace(tzinfo=None), datetime.fromtimestamp(int(out), timezone.utc).replace(tzinfo=None))
         finally:
             os.remove(put_filename)
             assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
@@ -73,13 +73,13 @@ class HeadObject_Test(TestCase):
 
             # get file last modified time for comparison below
             _,out,_ = assert_command(f'iquest "%s" "select DATA_MODIFY_TIME where COLL_NAME = \'{self.bucket_irods_path}/{put_directory}\' and DATA_NAME = \'{put_filename}\'"', 'STDOUT')
-            object_create_time = datetime.fromtimestamp(int(out))
+            object_create_time = datetime.fromtimestamp(int(out), timezone.utc)
             print(out)
 
             head_object_result = self.boto3_client.head_object(Bucket=self.bucket_name, Key=f'{put_directory}/{put_filename}')
             self.assertEqual(head_object_result['ResponseMetadata']['HTTPStatusCode'], 200)
             self.assertEqual(head_object_result['ContentLength'], file_size)
-            self.assertEqual(head_object_result['LastModified'].replace(tzinfo=None), datetime.fromtimestamp(int(out)).replace(tzinfo=None))
+            self.assertEqual(head_object_result['LastModified'].replace(tzinfo=None), datetime.fromtimestamp(int(out), timezone.utc).replace(tzinfo=None))
         finally:
             os.remove(put_filename)
             assert_command(f'irm -rf {self.bucket_irods_path}/{put_directory}')
@@ -94,8 +94,8 @@ class HeadObject_Test(TestCase):
 
             # get file last modified time for comparison below
             _,out,_ = assert_command(f'iquest "%s" "select DATA_MODIFY_TIME where COLL_NAME = \'{self.bucket_irods_path}\' and DATA_NAME = \'{put_filename}\'"', 'STDOUT')
-            object_create_time = datetime.fromtimestamp(int(out))
-            object_create_time_formatted = datetime.fromtimestamp(int(out)).strftime("%Y-%m-%dT%H:%M:%S")
+            object_create_time = datetime.fromtimestamp(int(out), timezone.utc)
+            object_create_time_formatted = datetime.fromtimestamp(int(out), timezone.utc).strftime("%Y-%m-%dT%H:%M:%S")
 
             # Note:  When checking LastModified, we are not looking at the timezone offset which is printed in the AWS tools
             assert_command(f'aws --profile s3_api_alice --endpoint-url {self.s3_api_url} s3api head-object --bucket {self.bucket_name} --key {put_filename}',
@@ -116,8 +116,8 @@ class HeadObject_Test(TestCase):
 
             # get file last modified time for comparison below
             _,out,_ = assert_command(f'iquest "%s" "select DATA_MODIFY_TIME where COLL_NAME = \'{self.bucket_irods_path}/{put_directory}\' and DATA_NAME = \'{put_filename}\'"', 'STDOUT')
-            object_create_time = datetime.fromtimestamp(int(out))
-            object_create_time_formatted = datetime.fromtimestamp(int(out)).strftime("%Y-%m-%dT%H:%M:%S")
+            object_create_time = datetime.fromtimestamp(int(out), timezone.utc)
+            object_create_time_formatted = datetime.fromtimestamp(int(out), timezone.utc).strftime("%Y-%m-%dT%H:%M:%S")
 
             assert_command(f'aws --profile s3_api_alice --endpoint-url {self.s3_api_url} s3api head-object --bucket {self.bucket_name} --key {put_directory}/{put_filename}',
                     'STDOUT_MULTILINE', [f'"ContentLength": {file_size}', f'"LastModified": "{object_create_time_formatted}'])
@@ -143,3 +143,23 @@ class HeadObject_Test(TestCase):
         self.assertRaises(botocore.exceptions.ClientError, lambda: self.boto3_client.head_object(Bucket="dne", Key="dne"))
         self.assertRaises(botocore.exceptions.ClientError, lambda: self.boto3_client.head_object(Bucket=self.bucket_name, Key="dne"))
 
+
+    def test_restore_object_not_in_archive(self):
+        put_filename = inspect.currentframe().f_code.co_name
+        try:
+            make_arbitrary_file(put_filename, 100*1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+
+            # objects which are not in an archive have no storage class and cannot be restored
+            head_object_result = self.boto3_client.head_object(Bucket=self.bucket_name, Key=f'{put_filename}')
+            self.assertNotIn('StorageClass', head_object_result)
+            self.assertNotIn('Restore', head_object_result)
+
+            with self.assertRaises(botocore.exceptions.ClientError) as cm:
+                self.boto3_client.restore_object(Bucket=self.bucket_name, Key=f'{put_filename}', RestoreRequest={'Days': 1})
+            self.assertEqual(cm.exception.response['Error']['Code'], 'InvalidObjectState')
+
+            self.assertRaises(botocore.exceptions.ClientError, lambda: self.boto3_client.restore_object(Bucket=self.bucket_name, Key='dne', RestoreRequest={'Days': 1}))
+        finally:
+            os.remove(put_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
@@ -5,7 +5,7 @@ import os
 from libs.execute import *
 from libs.command import *
 from libs.utility import *
-from datetime import datetime
+from datetime import datetime, timezone
 from host_port import s3_api_host_port
 
 class ListBuckets_Test(TestCase):
@@ -67,9 +67,9 @@ class ListBuckets_Test(TestCase):
         # Read the creation date for the two collections that alice can read for comparison below.
         # Note we will not compare the creation date for test-bucket.
         _,out,_ = assert_command(f'iquest "%s" "select COLL_CREATE_TIME where COLL_NAME = \'{self.bucket_irods_path_alice_bucket}\'"', 'STDOUT')
-        alice_bucket_create_time = datetime.fromtimestamp(int(out))
+        alice_bucket_create_time = datetime.fromtimestamp(int(out), timezone.utc)
         _,out,_ = assert_command(f'iquest "%s" "select COLL_CREATE_TIME where COLL_NAME = \'{self.bucket_irods_path_alice_bucket2}\'"', 'STDOUT')
-        alice_bucket2_create_time = datetime.fromtimestamp(int(out))
+        alice_bucket2_create_time = datetime.fromtimestamp(int(out), timezone.utc)
 
         # rods can read all three buckets 
         list_buckets_result = self.client_rods.list_buckets()
@@ -2,9 +2,14 @@ from unittest import *
 import boto3
 from boto3.s3.transfer import TransferConfig
 import botocore
+import botocore.auth
+import botocore.awsrequest
+import botocore.credentials
 import botocore.session
 import inspect
 import os
+import socket
+import time
 from libs.execute import *
 from libs.command import *
 from libs.utility import *
@@ -74,6 +79,27 @@ class PutObject_Test(TestCase):
             os.remove(get_filename)
             assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
 
+    def test_botocore_put_single_part_above_parallel_transfer_threshold(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+        get_filename = f'{put_filename}.get'
+
+        try:
+
+            # a size which is not a multiple of the parallel transfer block size
+            make_arbitrary_file(put_filename, 40*1024*1024 + 12345)
+
+            # put_object sends the file in a single request so it is written over parallel streams
+            with open(put_filename, 'rb') as f:
+                self.boto3_client.put_object(Bucket=self.bucket_name, Key=put_filename, Body=f)
+            assert_command(f'iget {self.bucket_irods_path}/{put_filename} {get_filename}')
+            assert_command(f'diff -q {put_filename} {get_filename}')
+
+        finally:
+            os.remove(put_filename)
+            os.remove(get_filename)
+            assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
     def test_botocore_put_in_subdirectory(self):
 
         put_filename = inspect.currentframe().f_code.co_name 
@@ -253,3 +279,65 @@ class PutObject_Test(TestCase):
 
         finally:
             assert_command(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def send_half_of_put_then_hang_up(self, key, size):
+        body = os.urandom(size)
+
+        # sign a complete request but send only half of the body before hanging up
+        request = botocore.awsrequest.AWSRequest(method='PUT',
+                                                 url=f'{self.s3_api_url}/{self.bucket_name}/{key}',
+                                                 data=body,
+                                                 headers={'Host': s3_api_host_port,
+                                                          'Content-Length': str(size)})
+        credentials = botocore.credentials.Credentials(self.key, self.secret_key)
+        botocore.auth.S3SigV4Auth(credentials, 's3', 'us-east-1').add_auth(request)
+
+        head = f'PUT /{self.bucket_name}/{key} HTTP/1.1\r\n'
+        head += ''.join(f'{name}: {value}\r\n' for name, value in request.headers.items())
+        head += '\r\n'
+
+        host, port = s3_api_host_port.split(':')
+        with socket.create_connection((host, int(port))) as s:
+            s.sendall(head.encode())
+            s.sendall(body[:size // 2])
+
+    def test_put_abandoned_mid_body_leaves_no_object(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+        size = 8*1024*1024
+
+        try:
+            self.send_half_of_put_then_hang_up(put_filename, size)
+
+            # the partial object is removed once the server notices that the client is gone
+            head_object = lambda: self.boto3_client.head_object(Bucket=self.bucket_name, Key=put_filename)
+            for _ in range(30):
+                try:
+                    head_object()
+                except botocore.exceptions.ClientError:
+                    break
+                time.sleep(1)
+            self.assertRaises(botocore.exceptions.ClientError, head_object)
+
+        finally:
+            execute_command_permissive(f'irm -f {self.bucket_irods_path}/{put_filename}')
+
+    def test_put_abandoned_mid_body_keeps_existing_object(self):
+
+        put_filename = inspect.currentframe().f_code.co_name
+        size = 8*1024*1024
+
+        try:
+            make_arbitrary_file(put_filename, 1024)
+            assert_command(f'iput {put_filename} {self.bucket_irods_path}/{put_filename}')
+
+            self.send_half_of_put_then_hang_up(put_filename, size)
+
+            # an object which existed before the request is never removed
+            time.sleep(5)
+            response = self.boto3_client.head_object(Bucket=self.bucket_name, Key=put_filename)
+            self.assertEqual(response['ResponseMetadata']['HTTPStatusCode'], 200)
+
+        finally:
+            os.remove(put_filename)
+            execute_command_permissive(f'irm -f {self.bucket_irods_path}/{put_filename}')